@@ -22,6 +22,12 @@ tab-size = 4
 #include <cmath>
 #include <iostream>
 #include <semaphore>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <deque>
+#include <utility>
 
 #define _WIN32_DCOM
 #define _WIN32_WINNT 0x0600
@@ -37,6 +43,11 @@ tab-size = 4
 #include <btop_theme.hpp>
 #include <btop_draw.hpp>
 #include <btop_menu.hpp>
+#include <btop_perf.hpp>
+#include <btop_record.hpp>
+#include <btop_export.hpp>
+#include <btop_share.hpp>
+#include <btop_remote.hpp>
 
 using std::string, std::string_view, std::vector, std::atomic, std::endl, std::cout, std::min, std::flush, std::endl;
 using std::string_literals::operator""s, std::to_string;
@@ -87,7 +98,9 @@ void argumentParser(const int& argc, char **argv) {
 	for(int i = 1; i < argc; i++) {
 		const string argument = argv[i];
 		if (is_in(argument, "-h", "--help")) {
-			cout 	<< "usage: btop [-h] [-v] [-/+t] [-p <id>] [--utf-force] [--debug]\n\n"
+			cout 	<< "usage: btop [-h] [-v] [-/+t] [-p <id>] [--utf-force] [--debug] [--trace] [--record [dir]] [--replay <path>]\n"
+					<< "            [--daemon] [--agent [[addr:]port]] [--connect <host[:port]>]\n"
+					<< "            [--batch [json|csv]] [--batch-out <file>] [--batch-fields <list>] [--batch-procs <n>] [--batch-count <n>]\n\n"
 					<< "optional arguments:\n"
 					<< "  -h, --help            show this help message and exit\n"
 					<< "  -v, --version         show version info and exit\n"
@@ -95,8 +108,27 @@ void argumentParser(const int& argc, char **argv) {
 					<< "  -t, --tty_on          force (ON) tty mode, max 16 colors and tty friendly graph symbols\n"
 					<< "  +t, --tty_off         force (OFF) tty mode\n"
 					<< "  -p, --preset <id>     start with preset, integer value between 0-9\n"
-					<< "  --debug               start in DEBUG mode: shows microsecond timer for information collect\n"
-					<< "                        and screen draw functions and sets loglevel to DEBUG\n"
+					<< "  --debug               start in DEBUG mode: shows performance HUD with rolling percentiles for\n"
+					<< "                        collect, draw, output and input to screen latency, sets loglevel to DEBUG\n"
+					<< "  --trace               record timing spans of all threads, written as a trace-event json file\n"
+					<< "                        to the config directory on exit or when pressing F12\n"
+					<< "  --record [dir]        record all collected metrics to compressed files in <dir>, defaults to\n"
+					<< "                        \"recordings\" in the config directory, see record_segment_mb and record_max_mb\n"
+					<< "  --replay <path>       play back a recording file or directory of recording files instead of live data,\n"
+					<< "                        space to pause, +/- for speed, </> to seek 10s, [/] to seek 10m\n"
+					<< "  --daemon              run without the tui as a collector daemon, other instances on this machine\n"
+					<< "                        show processes, disks and sensors collected by the daemon instead of their own\n"
+					<< "  --agent [[addr:]port] run without the tui and stream collected data to viewers connecting to <port>\n"
+					<< "                        (default 47801), listens on 127.0.0.1 unless an address is given\n"
+					<< "  --connect <host[:port]>\n"
+					<< "                        show data streamed from an agent on another machine instead of local data\n"
+					<< "  --batch [json|csv]    run without the tui and write one record per update_ms to stdout,\n"
+					<< "                        as json lines (default) or csv with a header line when the columns change\n"
+					<< "  --batch-out <file>    append batch records to <file> instead of stdout\n"
+					<< "  --batch-fields <list> comma separated sections to include in batch records, any of\n"
+					<< "                        cpu,cores,mem,disks,net,procs (default all)\n"
+					<< "  --batch-procs <n>     number of processes in batch records, highest cpu usage first (default 10)\n"
+					<< "  --batch-count <n>     quit after writing <n> batch records\n"
 					<< endl;
 			exit(0);
 		}
@@ -130,12 +162,90 @@ void argumentParser(const int& argc, char **argv) {
 		}
 		else if (argument == "--debug")
 			Global::debug = true;
+		else if (argument == "--trace")
+			Trace::enabled = true;
+		else if (argument == "--replay") {
+			if (++i >= argc) {
+				cout << "ERROR: Replay option needs a recording file or directory." << endl;
+				exit(1);
+			}
+			Record::Replay::active = true;
+			Record::Replay::path = argv[i];
+		}
+		else if (argument == "--batch") {
+			Export::active = true;
+			if (i + 1 < argc and not string(argv[i + 1]).starts_with("-")) {
+				Export::format = argv[++i];
+				if (not is_in(Export::format, "json", "csv")) {
+					cout << "ERROR: Batch format needs to be json or csv." << endl;
+					exit(1);
+				}
+			}
+		}
+		else if (is_in(argument, "--batch-out", "--batch-fields", "--batch-procs", "--batch-count")) {
+			if (++i >= argc) {
+				cout << "ERROR: Option " << argument << " needs an argument." << endl;
+				exit(1);
+			}
+			const string val = argv[i];
+			if (argument == "--batch-out")
+				Export::file = val;
+			else if (argument == "--batch-fields") {
+				for (const auto& field : ssplit(val, ',')) {
+					if (not v_contains(Export::valid_fields, field)) {
+						cout << "ERROR: Invalid batch field: " << field << endl;
+						exit(1);
+					}
+				}
+				Export::fields = val;
+			}
+			else if (isint(val) and val.size() < 10 and stoi(val) >= 0) {
+				(argument == "--batch-procs" ? Export::top_procs : Export::count) = stoi(val);
+			}
+			else {
+				cout << "ERROR: Option " << argument << " only accepts a positive integer." << endl;
+				exit(1);
+			}
+		}
+		else if (argument == "--daemon") {
+			Share::daemon = true;
+		}
+		else if (argument == "--agent") {
+			Remote::agent = true;
+			if (i + 1 < argc and not string(argv[i + 1]).starts_with("-") and not Remote::parse_address(argv[++i], false)) {
+				cout << "ERROR: Agent option needs a port or address:port to listen on." << endl;
+				exit(1);
+			}
+		}
+		else if (argument == "--connect") {
+			if (++i >= argc or not Remote::parse_address(argv[i], true)) {
+				cout << "ERROR: Connect option needs a host or host:port of an agent." << endl;
+				exit(1);
+			}
+			Remote::viewer = true;
+		}
+		else if (argument == "--record") {
+			Record::Disk::enabled = true;
+			if (i + 1 < argc and not string(argv[i + 1]).starts_with("-")) Record::Disk::dir = argv[++i];
+		}
 		else {
 			cout << " Unknown argument: " << argument << "\n" <<
 			" Use -h or --help for help." <<  endl;
 			exit(1);
 		}
 	}
+	if (Remote::viewer and (Remote::agent or Record::Replay::active)) {
+		cout << "ERROR: Connect option can't be combined with --agent or --replay." << endl;
+		exit(1);
+	}
+	if ((int)Remote::agent + (int)Share::daemon + (int)Export::active > 1) {
+		cout << "ERROR: Only one of --agent, --daemon and --batch can be used." << endl;
+		exit(1);
+	}
+	if ((Remote::agent or Share::daemon or Export::active) and (Remote::viewer or Record::Replay::active or Record::Disk::enabled)) {
+		cout << "ERROR: Agent, daemon and batch options can't be combined with --connect, --replay or --record." << endl;
+		exit(1);
+	}
 }
 
 //* Handler for SIGWINCH and general resizing events, does nothing if terminal hasn't been resized unless force=true
@@ -143,7 +253,7 @@ void term_resize(bool force) {
 	static atomic<bool> resizing (false);
 	if (Input::polling) {
 		Global::resized = true;
-		Input::interrupt = true;
+		Input::set_interrupt();
 		return;
 	}
 	atomic_lock lck(resizing, true);
@@ -188,16 +298,24 @@ void term_resize(bool force) {
 		else if (not Term::refresh()) break;
 	}
 
-	Input::interrupt = true;
+	Input::set_interrupt();
 }
 
 //* Exit handler; restores terminal and saves config changes
 void clean_quit(int sig) {
 	if (Global::quitting) return;
 	Global::quitting = true;
-	Runner::stop();
+	if (Global::_runner_started) Runner::stop();
+
+	if (not Export::active and not Share::daemon and not Remote::agent) Config::write();
+
+	Export::close();
+	Share::close();
+	Remote::close();
 
-	Config::write();
+	if (Trace::enabled) Trace::dump();
+
+	Record::Disk::stop();
 
 	if (Term::initialized) {
 		Term::restore();
@@ -208,7 +326,8 @@ void clean_quit(int sig) {
 		Logger::error(Global::exit_error_msg);
 		std::cerr << Global::fg_red << "ERROR: " << Global::fg_white << Global::exit_error_msg << Fx::reset << endl;
 	}
-	Logger::info("Quitting! Runtime: " + sec_to_dhms(time_s() - Global::start_time));
+	Logger::info("Quitting! Runtime: ", sec_to_dhms(time_s() - Global::start_time));
+	Logger::flush();
 
 	const auto excode = (sig != -1 ? sig : 0);
 
@@ -251,7 +370,6 @@ namespace Runner {
 	bool pause_output = false;
 
 	enum debug_actions {
-		collect_begin,
 		draw_begin,
 		draw_done
 	};
@@ -262,6 +380,7 @@ namespace Runner {
 	};
 
 	string debug_bg;
+	bool debug_hud = false;
 	unordered_flat_map<string, array<uint64_t, 2>> debug_times;
 
 	struct runner_conf {
@@ -271,19 +390,180 @@ namespace Runner {
 		bool background_update;
 		string overlay;
 		string clock;
+		uint64_t input_time;
 	};
 
 	struct runner_conf current_conf;
 
+	//* Worker threads used by the runner to collect boxes concurrently
+	namespace Workers {
+		const int count = 2;
+		std::mutex lock;
+		std::condition_variable cv;
+		std::deque<std::packaged_task<void()>> jobs;
+
+		void _worker(const int id) {
+			Trace::thread_name(id == 0 ? "worker 1" : "worker 2");
+			while (not Global::quitting) {
+				std::packaged_task<void()> job;
+				{
+					std::unique_lock lck(lock);
+					cv.wait(lck, [] { return not jobs.empty(); });
+					job = std::move(jobs.front());
+					jobs.pop_front();
+				}
+				job();
+			}
+		}
+
+		void start() {
+			for (int i = 0; i < count; i++) std::thread(_worker, i).detach();
+		}
+
+		//* Queue <job> for a worker thread, exceptions thrown by the job are rethrown from get() of the returned future
+		std::future<void> submit(std::function<void()> job) {
+			std::packaged_task<void()> task(std::move(job));
+			auto result = task.get_future();
+			{
+				std::lock_guard lck(lock);
+				jobs.push_back(std::move(task));
+			}
+			cv.notify_one();
+			return result;
+		}
+	}
+
+	//* Terminal writer thread, frames are handed over through a single pending slot so the runner can collect
+	//* and draw the next frame while the last one is still being written to a slow terminal
+	namespace Writer {
+		std::mutex lock;
+		std::condition_variable cv;
+		string pending;
+		uint64_t pending_input = 0;
+		bool writing = false;
+
+		void _writer() {
+			Trace::thread_name("writer");
+			string frame;
+			while (not Global::quitting) {
+				uint64_t input_time = 0;
+				{
+					std::unique_lock lck(lock);
+					writing = false;
+					cv.notify_all();
+					cv.wait(lck, [] { return not pending.empty(); });
+					frame.swap(pending);
+					input_time = std::exchange(pending_input, 0);
+					writing = true;
+				}
+				Trace::Span span_output("output", "writer");
+				const uint64_t write_start = time_micros();
+				cout << frame << flush;
+				Perf::add(Perf::output_write, time_micros() - write_start);
+				if (input_time > 0) Perf::add(Perf::input_latency, Trace::now() - input_time);
+				frame.clear();
+			}
+		}
+
+		void start() {
+			std::thread(_writer).detach();
+		}
+
+		//* Returns true if the last frame handed over hasn't been picked up by the writer yet
+		bool behind() {
+			std::lock_guard lck(lock);
+			return not pending.empty();
+		}
+
+		//* Queue <frame> for writing, a pending frame is replaced and counted as dropped if <full> is true,
+		//* otherwise <frame> is appended since it only contains changes on top of what is pending.
+		//* <input_time> is the time of the input that caused the frame, 0 if none
+		void submit(string&& frame, const bool full, const uint64_t input_time=0) {
+			{
+				std::lock_guard lck(lock);
+				if (full and not pending.empty()) {
+					pending = std::move(frame);
+					Perf::dropped_frames++;
+				}
+				else pending += frame;
+				if (input_time > 0 and pending_input == 0) pending_input = input_time;
+			}
+			cv.notify_all();
+		}
+
+		//* Wait for all queued output to be written, gives up after <timeout> ms
+		void flush(const int timeout=1000) {
+			std::unique_lock lck(lock);
+			cv.wait_for(lck, std::chrono::milliseconds(timeout), [] { return pending.empty() and not writing; });
+		}
+	}
+
+	//* State for config option "adaptive_sampling", updated by the runner after each collect and read by interval()
+	namespace Adaptive {
+		atomic<int> proc_factor (1);
+		atomic<bool> burst (false);
+		atomic<bool> expedite (false);
+
+		const size_t top_count = 5;
+		const uint64_t burst_time = 10'000;
+		uint64_t burst_until = 0;
+		int stable_scans = 0;
+		long long cpu_total = 0, scan_total = -1;
+		vector<size_t> last_top;
+
+		//* Lengthen the process interval while the top processes and cpu total are stable,
+		//* start a burst of faster cpu and process updates when total cpu or the tracked process crosses adaptive_threshold
+		void update(const Cpu::cpu_info* cpu, const vector<Proc::proc_info>* procs) {
+			const uint64_t now = steady_ms();
+			const long long threshold = Config::getI("adaptive_threshold");
+			bool spike = false;
+
+			if (cpu != nullptr and not cpu->cpu_percent.at("total").empty()) {
+				cpu_total = cpu->cpu_percent.at("total").back();
+				spike = (cpu_total >= threshold);
+			}
+
+			if (procs != nullptr) {
+				const size_t tracked = (Proc::detailed_pid > 0 ? Proc::detailed_pid.load() : Proc::selected_pid);
+				vector<const Proc::proc_info*> sorted;
+				sorted.reserve(procs->size());
+				for (const auto& p : *procs) {
+					if (p.filtered) continue;
+					if (tracked > 0 and p.pid == tracked and p.cpu_p >= threshold) spike = true;
+					sorted.push_back(&p);
+				}
+				const size_t count = min(top_count, sorted.size());
+				rng::partial_sort(sorted, sorted.begin() + count, [](const auto* a, const auto* b) { return a->cpu_p > b->cpu_p; });
+				vector<size_t> top;
+				for (size_t i = 0; i < count; i++) top.push_back(sorted[i]->pid);
+				rng::sort(top);
+
+				const bool stable = (top == last_top and scan_total >= 0 and std::abs(cpu_total - scan_total) < 10);
+				stable_scans = (stable ? stable_scans + 1 : 0);
+				last_top = std::move(top);
+				scan_total = cpu_total;
+
+				//? Double the process interval after 5 stable scans and quadruple it after 10
+				proc_factor = 1 << min(2, stable_scans / 5);
+			}
+
+			if (spike) {
+				if (burst_until <= now) expedite = true;
+				burst_until = now + burst_time;
+				stable_scans = 0;
+				proc_factor = 1;
+			}
+			burst = (burst_until > now);
+
+			//? Wake up the main thread to reschedule cpu and proc with the faster rate
+			if (expedite) Input::set_interrupt();
+		}
+	}
+
 	void debug_timer(const char* name, const int action) {
 		switch (action) {
-			case collect_begin:
-				debug_times[name].at(collect) = time_micros();
-				return;
 			case draw_begin:
 				debug_times[name].at(draw) = time_micros();
-				debug_times[name].at(collect) = debug_times[name].at(draw) - debug_times[name].at(collect);
-				debug_times["total"].at(collect) += debug_times[name].at(collect);
 				return;
 			case draw_done:
 				debug_times[name].at(draw) = time_micros() - debug_times[name].at(draw);
@@ -294,15 +574,20 @@ namespace Runner {
 
 	//? ------------------------------- Secondary thread: async launcher and drawing ----------------------------------
 	void _runner() {
+		Trace::thread_name("runner");
+		Workers::start();
+		Writer::start();
+		const vector<Proc::proc_info>* proc_list = nullptr;
 
 		//* ----------------------------------------------- THREAD LOOP -----------------------------------------------
 		while (not Global::quitting) {
 			thread_wait();
+			Trace::Span span_frame("frame", "runner");
 			atomic_wait_for(active, true, 5000);
 			if (active) {
 				Global::exit_error_msg = "Runner thread failed to get active lock!";
 				Global::thread_exception = true;
-				Input::interrupt = true;
+				Input::set_interrupt();
 				stopping = true;
 			}
 			if (stopping or Global::resized) {
@@ -315,30 +600,178 @@ namespace Runner {
 
 			auto& conf = current_conf;
 
+			//? Terminal hasn't caught up with the last frame, draw a full frame that can replace it instead of changes on top of it,
+			//? only possible if all shown boxes are part of this frame
+			const bool all_boxes = (conf.boxes.size() == Config::current_boxes.size());
+			if (all_boxes and Writer::behind()) conf.force_redraw = true;
+
 			//! DEBUG stats
 			if (Global::debug) {
-				if (debug_bg.empty() or redraw) Runner::debug_bg = Draw::createBox(2, 2, 32, 10, "", true, "debug");
+				if (debug_bg.empty() or redraw) {
+					//? Use the full performance HUD if it fits, otherwise fall back to the small box with latest times only
+					debug_hud = (Term::width >= Perf::width + 4 and Term::height >= Perf::height + 4);
+					Runner::debug_bg = (debug_hud
+						? Draw::createBox(2, 2, Perf::width, Perf::height, "", true, "debug")
+						: Draw::createBox(2, 2, 32, 10, "", true, "debug"));
+				}
 				debug_times.clear();
 				debug_times["total"] = {0, 0};
 			}
 
 			output.clear();
 
-			//* Run collection and draw functions for all boxes
+			//* Run collection for all boxes, boxes not sharing any state are collected concurrently on worker threads
 			try {
-				//? CPU
-				if (v_contains(conf.boxes, "cpu")) {
+				const bool show_cpu = v_contains(conf.boxes, "cpu");
+				const bool show_mem = v_contains(conf.boxes, "mem");
+				const bool show_net = v_contains(conf.boxes, "net");
+				const bool show_proc = v_contains(conf.boxes, "proc");
+				Cpu::cpu_info* cpu = nullptr;
+				Mem::mem_info* mem = nullptr;
+				Net::net_info* net = nullptr;
+				const vector<Proc::proc_info>* live_procs = nullptr;
+				array<uint64_t, 4> collect_times{};
+				const uint64_t collect_start = time_micros();
+
+				//? Selection or view change only, the last process list is still current and collect is skipped
+				const bool proc_selection = (show_proc and Proc::selection_only.exchange(false) and conf.no_update
+					and not conf.force_redraw and proc_list != nullptr);
+
+				vector<std::function<void()>> tasks;
+
+				//? Process collection is usually the slowest and runs on the runner thread itself
+				if (show_proc) tasks.push_back([&] {
+					try {
+						const uint64_t start = time_micros();
+						Trace::Span span_collect("proc::collect", "collect");
+						if (not proc_selection) {
+							proc_list = &Proc::collect(conf.no_update);
+							if (not conf.no_update and not Config::getB("proc_services")) {
+								live_procs = proc_list;
+								Record::Flight::add(*proc_list);
+							}
+						}
+						collect_times[3] = time_micros() - start;
+
+						//? Show a recorded snapshot instead of the live list while scrubbing back in time
+						if (const uint64_t scrub = Record::Flight::scrub_time; scrub > 0 and not proc_selection) {
+							static vector<Proc::proc_info> scrub_list;
+							const uint64_t wall = (Config::getB("proc_services") ? 0 : Record::Flight::get(scrub, scrub_list, Config::getS("proc_filter")));
+							if (wall == 0)
+								Record::Flight::scrub_time = 0;
+							else {
+								Proc::proc_sorter(scrub_list, Config::getS("proc_sorting"), Config::getB("proc_reversed"));
+								Proc::numpids = (int)rng::count(scrub_list, false, &Proc::proc_info::filtered);
+								Record::Flight::scrub_wall = wall;
+								proc_list = &scrub_list;
+							}
+						}
+					}
+					catch (const std::exception& e) {
+						throw std::runtime_error("Proc:: -> " + (string)e.what());
+					}
+				});
+
+				//? Cpu and Mem both read LHM gpu stats and can change the selected gpu, so they share one task
+				if (show_cpu or show_mem) tasks.push_back([&] {
+					if (show_cpu) {
+						try {
+							const uint64_t start = time_micros();
+							Trace::Span span_collect("cpu::collect", "collect");
+							cpu = &Cpu::collect(conf.no_update);
+							collect_times[0] = time_micros() - start;
+						}
+						catch (const std::exception& e) {
+							throw std::runtime_error("Cpu:: -> " + (string)e.what());
+						}
+					}
+					if (show_mem) {
+						try {
+							const uint64_t start = time_micros();
+							Trace::Span span_collect("mem::collect", "collect");
+							mem = &Mem::collect(conf.no_update);
+							collect_times[1] = time_micros() - start;
+						}
+						catch (const std::exception& e) {
+							throw std::runtime_error("Mem:: -> " + (string)e.what());
+						}
+					}
+				});
+
+				if (show_net) tasks.push_back([&] {
 					try {
-						if (Global::debug) debug_timer("cpu", collect_begin);
+						const uint64_t start = time_micros();
+						Trace::Span span_collect("net::collect", "collect");
+						net = &Net::collect(conf.no_update);
+						collect_times[2] = time_micros() - start;
+					}
+					catch (const std::exception& e) {
+						throw std::runtime_error("Net:: -> " + (string)e.what());
+					}
+				});
+
+				//? Samples from the recording or a remote agent replaces collected data when replaying or connected
+				int source_moved = 1;
+				if (Record::Replay::active or Remote::viewer) {
+					static Cpu::cpu_info source_cpu;
+					static Mem::mem_info source_mem;
+					static unordered_flat_map<string, Net::net_info> source_net;
+					static vector<Proc::proc_info> source_procs;
+					tasks.clear();
+					if (not conf.no_update) {
+						const size_t samples = max(Term::width * 2, 100);
+						source_moved = (Remote::viewer
+							? Remote::fill(source_cpu, source_mem, source_net, source_procs, samples, Config::getS("proc_filter"))
+							: Record::Replay::fill(source_cpu, source_mem, source_net, source_procs, samples));
+						Proc::proc_sorter(source_procs, Config::getS("proc_sorting"), Config::getB("proc_reversed"));
+						Proc::numpids = (int)rng::count(source_procs, false, &Proc::proc_info::filtered);
+					}
+					if (source_moved == 2) conf.force_redraw = true;
+					cpu = &source_cpu;
+					mem = &source_mem;
+					net = &source_net[Net::selected_iface];
+					proc_list = &source_procs;
+				}
 
-						//? Start collect
-						Cpu::cpu_info cpu = Cpu::collect(conf.no_update);
+				//? Hand all but the first task to the workers, always wait for every task before rethrowing
+				//? since the tasks reference variables in this scope
+				if (not tasks.empty()) {
+					vector<std::future<void>> pending;
+					for (size_t i = 1; i < tasks.size(); i++) pending.push_back(Workers::submit(tasks[i]));
+					std::exception_ptr error;
+					try { tasks.front()(); }
+					catch (...) { error = std::current_exception(); }
+					for (auto& task : pending) {
+						try { task.get(); }
+						catch (...) { if (not error) error = std::current_exception(); }
+					}
+					if (error) std::rethrow_exception(error);
+				}
 
-						if (Global::debug) debug_timer("cpu", draw_begin);
+				const bool data_same = (conf.no_update or source_moved == 0);
 
-						//? Draw box
-						if (not pause_output) output += Cpu::draw(cpu, conf.force_redraw, conf.no_update);
+				if (Config::getB("adaptive_sampling") and not conf.no_update and not Record::Replay::active and not Remote::viewer)
+					Adaptive::update(cpu, (show_proc and not proc_selection and Record::Flight::scrub_time == 0 ? proc_list : nullptr));
+
+				if (Record::Disk::enabled and not conf.no_update and not Record::Replay::active and not Remote::viewer)
+					Record::Disk::add(time_ms(), cpu, mem, (net != nullptr ? &Net::current_net : nullptr), live_procs);
+
+				if (not conf.no_update and not Record::Replay::active and not Remote::viewer)
+					Export::Metrics::update(cpu, mem, (net != nullptr ? &Net::current_net : nullptr), live_procs);
+
+				if (Global::debug) {
+					for (size_t i = 0; const string name : {"cpu", "mem", "net", "proc"}) debug_times[name].at(collect) = collect_times[i++];
+					debug_times["total"].at(collect) = time_micros() - collect_start;
+				}
 
+				//* Draw boxes in order, drawing is kept on the runner thread since it updates shared state like Input::mouse_mappings
+
+				//? CPU
+				if (show_cpu) {
+					try {
+						if (Global::debug) debug_timer("cpu", draw_begin);
+						Trace::Span span_draw("cpu::draw", "draw");
+						if (not pause_output) output += Cpu::draw(*cpu, conf.force_redraw, data_same);
 						if (Global::debug) debug_timer("cpu", draw_done);
 					}
 					catch (const std::exception& e) {
@@ -347,18 +780,11 @@ namespace Runner {
 				}
 
 				//? MEM
-				if (v_contains(conf.boxes, "mem")) {
+				if (show_mem) {
 					try {
-						if (Global::debug) debug_timer("mem", collect_begin);
-
-						//? Start collect
-						auto mem = Mem::collect(conf.no_update);
-
 						if (Global::debug) debug_timer("mem", draw_begin);
-
-						//? Draw box
-						if (not pause_output) output += Mem::draw(mem, conf.force_redraw, conf.no_update);
-
+						Trace::Span span_draw("mem::draw", "draw");
+						if (not pause_output) output += Mem::draw(*mem, conf.force_redraw, data_same);
 						if (Global::debug) debug_timer("mem", draw_done);
 					}
 					catch (const std::exception& e) {
@@ -367,18 +793,11 @@ namespace Runner {
 				}
 
 				//? NET
-				if (v_contains(conf.boxes, "net")) {
+				if (show_net) {
 					try {
-						if (Global::debug) debug_timer("net", collect_begin);
-
-						//? Start collect
-						auto net = Net::collect(conf.no_update);
-
 						if (Global::debug) debug_timer("net", draw_begin);
-
-						//? Draw box
-						if (not pause_output) output += Net::draw(net, conf.force_redraw, conf.no_update);
-
+						Trace::Span span_draw("net::draw", "draw");
+						if (not pause_output) output += Net::draw(*net, conf.force_redraw, data_same);
 						if (Global::debug) debug_timer("net", draw_done);
 					}
 					catch (const std::exception& e) {
@@ -387,18 +806,11 @@ namespace Runner {
 				}
 
 				//? PROC
-				if (v_contains(conf.boxes, "proc")) {
+				if (show_proc) {
 					try {
-						if (Global::debug) debug_timer("proc", collect_begin);
-
-						//? Start collect
-						auto proc = Proc::collect(conf.no_update);
-
 						if (Global::debug) debug_timer("proc", draw_begin);
-
-						//? Draw box
-						if (not pause_output) output += Proc::draw(proc, conf.force_redraw, conf.no_update);
-
+						Trace::Span span_draw("proc::draw", "draw");
+						if (not pause_output) output += Proc::draw(*proc_list, conf.force_redraw, data_same, proc_selection);
 						if (Global::debug) debug_timer("proc", draw_done);
 					}
 					catch (const std::exception& e) {
@@ -409,7 +821,7 @@ namespace Runner {
 			catch (const std::exception& e) {
 				Global::exit_error_msg = "Exception in runner thread -> " + (string)e.what();
 				Global::thread_exception = true;
-				Input::interrupt = true;
+				Input::set_interrupt();
 				stopping = true;
 			}
 
@@ -441,7 +853,10 @@ namespace Runner {
 			}
 
 			//! DEBUG stats -->
-			if (Global::debug and not Menu::active) {
+			if (Global::debug and not Menu::active and debug_hud) {
+				output += debug_bg + Perf::draw(2, 2);
+			}
+			else if (Global::debug and not Menu::active) {
 				output += debug_bg + Theme::c("title") + Fx::b + ljust(" Box", 9) + ljust("Collect us", 12, true) + ljust("Draw us", 9, true) + Theme::c("main_fg") + Fx::ub;
 				for (const string name : {"cpu", "mem", "net", "proc", "total"}) {
 					if (not debug_times.contains(name)) debug_times[name] = {0,0};
@@ -456,10 +871,25 @@ namespace Runner {
 			}
 
 			//? If overlay isn't empty, print output without color and then print overlay on top
-			cout << Term::sync_start << (conf.overlay.empty()
+			const size_t frame_size = output.size() + conf.overlay.size();
+			Writer::submit(Term::sync_start + (conf.overlay.empty()
 					? output
 					: (output.empty() ? "" : Fx::ub + Theme::c("inactive_fg") + Fx::uncolor(output)) + conf.overlay)
-				<< Term::hide_cursor << Term::sync_end << flush;
+				+ Term::hide_cursor + Term::sync_end, (all_boxes and conf.force_redraw), conf.input_time);
+
+			//? Store stage times for the performance HUD, output is timed by the writer thread
+			if (Global::debug) {
+				static const array<string, 4> perf_boxes = {"cpu", "mem", "net", "proc"};
+				for (size_t i = 0; i < perf_boxes.size(); i++) {
+					if (not v_contains(conf.boxes, perf_boxes[i])) continue;
+					const auto& [time_collect, time_draw] = debug_times.at(perf_boxes[i]);
+					Perf::add((Perf::stages)(Perf::cpu_collect + i * 2), time_collect);
+					Perf::add((Perf::stages)(Perf::cpu_draw + i * 2), time_draw);
+				}
+				const auto& [total_collect, total_draw] = debug_times.at("total");
+				Perf::add(Perf::frame_total, total_collect + total_draw);
+				Perf::add(Perf::frame_bytes, frame_size);
+			}
 		}
 		//* ----------------------------------------------- THREAD LOOP -----------------------------------------------
 		
@@ -474,6 +904,7 @@ namespace Runner {
 			if (++stall_count == 12) {
 				Logger::error("Stall in Runner thread for more than 1 minute, quitting!");
 				active = false;
+				atomic_notify(active);
 				clean_quit(1);
 			}
 			else {
@@ -485,21 +916,22 @@ namespace Runner {
 		if (stopping or Global::resized) return;
 
 		if (box == "overlay") {
-			cout << Term::sync_start << Global::overlay << Term::sync_end << flush;
+			Writer::submit(Term::sync_start + Global::overlay + Term::sync_end, false);
 		}
 		else if (box == "clock") {
-			cout << Term::sync_start << Global::clock << Term::sync_end << flush;
+			Writer::submit(Term::sync_start + Global::clock + Term::sync_end, false);
 		}
 		else {
 			Config::unlock();
 			Config::lock();
 
 			current_conf = {
-				(box == "all" ? Config::current_boxes : vector{box}),
+				(box == "all" ? Config::current_boxes : ssplit(box)),
 				no_update, force_redraw,
 				(not Config::getB("tty_mode") and Config::getB("background_update")),
 				Global::overlay,
-				Global::clock
+				Global::clock,
+				Perf::input_take()
 			};
 
 			if (Menu::active and not current_conf.background_update) Global::overlay.clear();
@@ -511,18 +943,46 @@ namespace Runner {
 
 	}
 
+	uint64_t interval(const string& box, const bool adaptive) {
+		const int box_ms = Config::getI("update_ms_" + box);
+		const uint64_t ms = (box_ms > 0 ? box_ms : Config::getI("update_ms"));
+		if (not adaptive or not Config::getB("adaptive_sampling") or not is_in(box, "cpu", "proc")) return ms;
+		else if (Adaptive::burst) return max((uint64_t)100, ms / 2);
+		return (box == "proc" ? ms * Adaptive::proc_factor : ms);
+	}
+
 	//* Stops any work being done in runner thread and checks for thread errors
 	void stop() {
 		stopping = true;
 		thread_trigger();
 		atomic_wait_for(active, false, 100);
 		atomic_wait_for(active, true, 100);
+		Writer::flush();
 		stopping = false;
 	}
 
 }
 
 
+//* Run a mode without the tui (agent, daemon or batch) until Global::should_quit is set or a task throws, then quit.
+//* <init> sets up the mode before Shared::init() and <tick> runs every update_ms on the scheduler
+void run_headless(const string& name, const std::function<void()>& init, const std::function<void()>& tick) {
+	std::atexit(_exit_handler);
+	try {
+		init();
+		Shared::init();
+
+		Scheduler::add(name, [] { return (uint64_t)Config::getI("update_ms"); }, tick);
+		Scheduler::reset(steady_ms());
+		while (not Global::should_quit) sleep_ms(Scheduler::run(steady_ms()));
+	}
+	catch (const std::exception& e) {
+		Global::exit_error_msg = "Exception in " + name + " mode -> " + (string)e.what();
+		clean_quit(1);
+	}
+	clean_quit(0);
+}
+
 //* --------------------------------------------- Main starts here! ---------------------------------------------------
 int main(int argc, char **argv) {
 
@@ -532,6 +992,7 @@ int main(int argc, char **argv) {
 
 	//? Call argument parser if launched with arguments
 	if (argc > 1) argumentParser(argc, argv);
+	Trace::thread_name("main");
 
 	SetConsoleCtrlHandler(CtrlHandler, TRUE);
 
@@ -556,15 +1017,28 @@ int main(int argc, char **argv) {
 		if (Global::debug) {
 			Logger::set("DEBUG");
 			Logger::debug("Starting in DEBUG mode!");
+			Perf::enabled = true;
 		}
 		else Logger::set(Config::getS("log_level"));
 
-		Logger::info("Logger set to " + (Global::debug ? "DEBUG" : Config::getS("log_level")));
+		Logger::info("Logger set to ", (Global::debug ? "DEBUG" : Config::getS("log_level")));
 
 		for (const auto& err_str : load_warnings) Logger::warning(err_str);
 	}
 	
 
+	//? Modes without the tui, collectors run on the scheduler without initializing the terminal, draw or input layers
+	if (Remote::agent) run_headless("agent", Remote::listen, Remote::publish);
+	else if (Share::daemon) run_headless("daemon", Share::create, Share::publish);
+	else if (Export::active) {
+		run_headless("batch",
+			[] {
+				Export::init();
+				std::thread(Export::Metrics::serve).detach();
+			},
+			[] { if (not Export::write()) Global::should_quit = true; });
+	}
+
 	//? Initialize terminal and set options
 	if (not Term::init()) {
 		Global::exit_error_msg = "No tty detected!\nbtop4win needs an interactive shell to run.";
@@ -584,6 +1058,12 @@ int main(int argc, char **argv) {
 		}
 	}
 
+	//? Attach to a collector daemon if one is running, checked again every 5 seconds while collecting locally
+	if (not Record::Replay::active and not Remote::viewer) {
+		Share::attach();
+		Scheduler::add("share", [] { return 5000; }, [] { Share::attach(); });
+	}
+
 	//? Collector init and error check
 	try {
 		Shared::init();
@@ -593,6 +1073,41 @@ int main(int argc, char **argv) {
 		clean_quit(1);
 	}
 
+	//? Open recording for playback if started with "--replay", live data is still initialized but not collected
+	if (Record::Replay::active) {
+		try {
+			Record::Replay::open();
+		}
+		catch (const std::exception& e) {
+			Global::exit_error_msg = "Failed to open recording -> " + (string)e.what();
+			clean_quit(1);
+		}
+	}
+
+	//? Connect to an agent if started with "--connect", local data is still initialized but not collected
+	if (Remote::viewer) {
+		try {
+			Remote::connect();
+		}
+		catch (const std::exception& e) {
+			Global::exit_error_msg = "Failed to connect to agent -> " + (string)e.what();
+			clean_quit(1);
+		}
+	}
+
+	//? Start metrics endpoint thread, idle until metrics_port is set
+	if (not Record::Replay::active and not Remote::viewer) std::thread(Export::Metrics::serve).detach();
+
+	//? Start writing recording segments if started with "--record", only local data is recorded
+	if (Record::Disk::enabled and (Record::Replay::active or Remote::viewer)) {
+		Record::Disk::enabled = false;
+		Logger::warning("Recording is disabled when replaying a recording or connected to an agent.");
+	}
+	else if (Record::Disk::enabled) {
+		if (Record::Disk::dir.empty()) Record::Disk::dir = Config::conf_dir / "recordings";
+		Record::Disk::start();
+	}
+
 	//? Update list of available themes and generate the selected theme
 	Theme::updateThemes();
 	Theme::setTheme();
@@ -635,8 +1150,19 @@ int main(int argc, char **argv) {
 
 	//? ------------------------------------------------ MAIN LOOP ----------------------------------------------------
 
-	uint64_t update_ms = Config::getI("update_ms");
-	auto future_time = time_ms();
+	//? Schedule updates for each box at its own interval, all boxes are updated at once on start
+	static const array<string, 4> all_boxes = {"cpu", "mem", "net", "proc"};
+	vector<string> due_boxes(all_boxes.begin(), all_boxes.end());
+	for (const auto& box : all_boxes)
+		Scheduler::add(box, [&box] { return Runner::interval(box); }, [&box, &due_boxes] { due_boxes.push_back(box); });
+
+	const auto get_intervals = [] {
+		array<uint64_t, 4> intervals;
+		for (size_t i = 0; i < all_boxes.size(); i++) intervals[i] = Runner::interval(all_boxes[i], false);
+		return intervals;
+	};
+	auto intervals = get_intervals();
+	Scheduler::reset(steady_ms());
 
 	try {
 		while (not true not_eq not false) {
@@ -662,33 +1188,44 @@ int main(int argc, char **argv) {
 				Runner::run("clock");
 			}
 
-			//? Start secondary collect & draw thread at the interval set by <update_ms> config value
-			if (time_ms() >= future_time and not Global::resized) {
-				Runner::run("all");
-				update_ms = Config::getI("update_ms");
-				future_time = time_ms() + update_ms;
+			//? Adaptive sampling started a burst, move the next cpu and proc updates forward to the faster rate
+			if (Runner::Adaptive::expedite.exchange(false)) {
+				for (const string box : {"cpu", "proc"}) Scheduler::rearm(box, steady_ms());
+			}
+
+			//? Run scheduled tasks and start secondary collect & draw thread for the shown boxes due an update
+			const uint64_t next_task = Scheduler::run(steady_ms());
+			if (not due_boxes.empty() and not Global::resized) {
+				string run_boxes;
+				for (const auto& box : Config::current_boxes) {
+					if (v_contains(due_boxes, box)) run_boxes += (run_boxes.empty() ? "" : " ") + box;
+				}
+				due_boxes.clear();
+				if (not run_boxes.empty()) Runner::run(run_boxes);
 			}
 
 			//? Loop over input polling and input action processing
-			for (auto current_time = time_ms(); current_time < future_time; current_time = time_ms()) {
+			for (auto current_time = steady_ms(), future_time = current_time + next_task; current_time < future_time; current_time = steady_ms()) {
 
-				//? Check for external clock changes and for changes to the update timer
-				if (std::cmp_not_equal(update_ms, Config::getI("update_ms"))) {
-					update_ms = Config::getI("update_ms");
-					future_time = time_ms() + update_ms;
+				//? Check for changes to the update timers
+				if (get_intervals() != intervals) {
+					intervals = get_intervals();
+					Scheduler::reset(current_time);
+					break;
 				}
-				else if (future_time - current_time > update_ms)
-					future_time = current_time;
 
-				//? Poll for input and process any input detected
-				else if (Input::poll(min((uint64_t)1000, future_time - current_time))) {
+				//? Wait for input until the next scheduled task or the next full second for the clock, and process any input detected
+				else if (Input::poll(min(1000 - time_ms() % 1000, future_time - current_time))) {
+					Trace::Span span_input("input", "main");
 					if (not Runner::active) Config::unlock();
 
+					Perf::input_mark();
 					if (Menu::active) Menu::process(Input::get());
 					else Input::process(Input::get());
+					Perf::input_take();
 				}
 
-				//? Break the loop at 1000ms intervals or if input polling was interrupted
+				//? Break the loop at every full second or if input polling was interrupted
 				else break;
 
 			}
@@ -0,0 +1,175 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <robin_hood.h>
+
+#include <btop_accounts.hpp>
+
+using std::deque, std::vector, robin_hood::unordered_flat_map;
+
+namespace Accounts {
+
+	namespace {
+		uint64_t now_ms() {
+			return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+	}
+
+	struct Cache::State {
+		struct Entry {
+			status st = status::pending;
+			string name;
+
+			//? Time of the last failure
+			uint64_t time = 0;
+
+			//? Set while queued or looked up, <started> is the time the lookup started and 0 while queued
+			bool queued = false;
+			uint64_t started = 0;
+			bool timed_out = false;
+		};
+
+		std::mutex lock;
+		std::condition_variable cv;
+		unordered_flat_map<string, Entry> entries;
+		deque<string> queue;
+
+		//? Accounts being looked up by a worker, at most one per worker
+		vector<string> running;
+		std::unique_ptr<Resolver> resolver;
+		uint64_t timeout_ms, retry_ms;
+		size_t max_workers;
+		size_t workers = 0, idle = 0, stuck = 0;
+		bool stopping = false;
+	};
+
+	namespace {
+		void worker(std::shared_ptr<Cache::State> state);
+
+		//? Queue <id> and wake an idle worker, or start a new one if all are busy. Workers stuck in a lookup past the timeout don't count towards <max_workers>
+		void enqueue(const std::shared_ptr<Cache::State>& state, const string& id, Cache::State::Entry& entry) {
+			entry.queued = true;
+			entry.started = 0;
+			state->queue.push_back(id);
+			if (state->idle > 0)
+				state->cv.notify_one();
+			else if (state->workers - state->stuck < state->max_workers) {
+				state->workers++;
+				std::thread(worker, state).detach();
+			}
+		}
+
+		void worker(std::shared_ptr<Cache::State> state) {
+			std::unique_lock lck(state->lock);
+			while (not state->stopping) {
+				if (state->queue.empty()) {
+					//? Only one idle worker is kept, the others exit when the queue is empty
+					if (state->workers - state->stuck > 1) break;
+					state->idle++;
+					state->cv.wait(lck, [&] { return state->stopping or not state->queue.empty(); });
+					state->idle--;
+					continue;
+				}
+
+				const string id = std::move(state->queue.front());
+				state->queue.pop_front();
+				state->entries[id].started = now_ms();
+				state->running.push_back(id);
+
+				lck.unlock();
+				string name;
+				const bool found = state->resolver->lookup(id, name) and not name.empty();
+				lck.lock();
+
+				std::erase(state->running, id);
+				auto& entry = state->entries[id];
+				entry.queued = false;
+				entry.started = 0;
+				if (entry.timed_out) {
+					entry.timed_out = false;
+					state->stuck--;
+				}
+				if (found) {
+					entry.st = status::resolved;
+					entry.name = std::move(name);
+				}
+				else {
+					entry.st = status::failed;
+					entry.time = now_ms();
+				}
+			}
+			state->workers--;
+		}
+
+		//? Mark lookups running longer than the timeout as failed until they return and don't count their workers as available,
+		//? then start workers for the remaining queue in their place
+		void check_timeouts(const std::shared_ptr<Cache::State>& state) {
+			const uint64_t now = now_ms();
+			for (const auto& id : state->running) {
+				auto& entry = state->entries[id];
+				if (entry.timed_out or now - entry.started <= state->timeout_ms) continue;
+				entry.timed_out = true;
+				state->stuck++;
+				if (entry.st == status::pending) {
+					entry.st = status::failed;
+					entry.time = now;
+				}
+			}
+			while (state->queue.size() > state->idle and state->workers - state->stuck < state->max_workers) {
+				state->workers++;
+				std::thread(worker, state).detach();
+			}
+		}
+	}
+
+	Cache::Cache(std::unique_ptr<Resolver> resolver, const uint64_t timeout_ms, const uint64_t retry_ms, const size_t max_workers)
+		: state(std::make_shared<State>()) {
+		state->resolver = std::move(resolver);
+		state->timeout_ms = timeout_ms;
+		state->retry_ms = retry_ms;
+		state->max_workers = std::max<size_t>(max_workers, 1);
+	}
+
+	Cache::~Cache() {
+		std::lock_guard lck(state->lock);
+		state->stopping = true;
+		state->cv.notify_all();
+	}
+
+	status Cache::get(const string& id, string& name) {
+		std::lock_guard lck(state->lock);
+		check_timeouts(state);
+		auto [it, inserted] = state->entries.try_emplace(id);
+		auto& entry = it->second;
+
+		//? Failed accounts stay failed while retried so callers keep their fallback
+		if (inserted or (entry.st == status::failed and not entry.queued and now_ms() - entry.time > state->retry_ms)) {
+			enqueue(state, id, entry);
+		}
+
+		if (entry.st == status::resolved) name = entry.name;
+		return entry.st;
+	}
+}
@@ -0,0 +1,63 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstdint>
+
+using std::string;
+
+//* Account names for process owners. Lookups can block for a network round trip on domain joined hosts, so unknown
+//* accounts are resolved by worker threads and callers show a placeholder until the name is known
+namespace Accounts {
+
+	//* Shown as the user of a process while its account name is being resolved
+	const string placeholder = "...";
+
+	//* Looks up the name of an account, may block
+	class Resolver {
+	public:
+		virtual ~Resolver() = default;
+
+		//* Set <name> for account <id> (a binary SID on Windows), returns false if the account can't be resolved. Called from worker threads
+		virtual bool lookup(const string& id, string& name) = 0;
+	};
+
+	enum class status { resolved, pending, failed };
+
+	//* Names by account id, a lookup running longer than <timeout_ms> counts as failed and another worker is started for the
+	//* remaining queue, up to <max_workers>. Running lookups are checked on every get() for any account, so a hung lookup
+	//* is noticed even if its account is never asked for again. Failed accounts are retried after <retry_ms>, a late result is still stored
+	class Cache {
+	public:
+		//? Shared with the worker threads, a worker stuck in a lookup can outlive the cache
+		struct State;
+	private:
+		std::shared_ptr<State> state;
+	public:
+		Cache(std::unique_ptr<Resolver> resolver, const uint64_t timeout_ms = 2000, const uint64_t retry_ms = 60000, const size_t max_workers = 4);
+		~Cache();
+		Cache(const Cache&) = delete;
+		Cache& operator=(const Cache&) = delete;
+
+		//* Get the name of account <id> without waiting, <name> is only set if resolved. Unknown accounts are queued for a worker
+		status get(const string& id, string& name);
+	};
+}
@@ -0,0 +1,62 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+
+#include <btop_atomic.hpp>
+
+namespace Tools {
+	//? std::atomic::wait() has no timeout, so timed waits use a condition variable shared by all atomics
+	std::mutex wait_mutex;
+	std::condition_variable wait_cv;
+
+	void atomic_wait(const atomic<bool>& atom, const bool old) noexcept {
+		atom.wait(old);
+	}
+
+	void atomic_wait_for(const atomic<bool>& atom, const bool old, const uint64_t wait_ms) noexcept {
+		if (atom.load() != old or wait_ms == 0) return;
+		std::unique_lock lck(wait_mutex);
+		wait_cv.wait_for(lck, std::chrono::milliseconds(wait_ms), [&atom, old]{ return atom.load() != old; });
+	}
+
+	void atomic_notify(atomic<bool>& atom) noexcept {
+		atom.notify_all();
+		//? Taking the mutex makes sure a waiter can't miss the change between checking it and going to sleep
+		{ std::lock_guard lck(wait_mutex); }
+		wait_cv.notify_all();
+	}
+
+	atomic_lock::atomic_lock(atomic<bool>& atom, bool wait) : atom(atom) {
+		if (wait) {
+			while (not this->atom.compare_exchange_strong(this->not_true, true)) {
+				this->atom.wait(true);
+				this->not_true = false;
+			}
+		}
+		else this->atom.store(true);
+		atomic_notify(this->atom);
+	}
+
+	atomic_lock::~atomic_lock() {
+		this->atom.store(false);
+		atomic_notify(this->atom);
+	}
+}
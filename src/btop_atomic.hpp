@@ -0,0 +1,47 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+using std::atomic;
+
+//* Waiting on the atomic<bool> flags shared between the main thread and the runner, kept apart from the rest of
+//* Tools so it can be benchmarked on its own
+namespace Tools {
+
+	//* Block until <atom> is not equal to <old>, the thread sleeps until woken by atomic_notify()
+	void atomic_wait(const atomic<bool>& atom, const bool old=true) noexcept;
+
+	//* Block until <atom> is not equal to <old> or <wait_ms> milliseconds have passed
+	void atomic_wait_for(const atomic<bool>& atom, const bool old=true, const uint64_t wait_ms=0) noexcept;
+
+	//* Wake all threads waiting on <atom>, needs to be called after every store to an atomic that is waited on
+	void atomic_notify(atomic<bool>& atom) noexcept;
+
+	//* Sets atomic<bool> to true on construct, sets to false on destruct and notifies any waiting threads
+	class atomic_lock {
+		atomic<bool>& atom;
+		bool not_true = false;
+	public:
+		atomic_lock(atomic<bool>& atom, bool wait=false);
+		~atomic_lock();
+	};
+}
@@ -62,6 +62,12 @@ tab-size = 4
 #include <btop_config.hpp>
 #include <btop_tools.hpp>
 #include <btop_draw.hpp>
+#include <btop_perf.hpp>
+#include <btop_export.hpp>
+#include <btop_share.hpp>
+#include <btop_lhm.hpp>
+#include <btop_wmi.hpp>
+#include <btop_accounts.hpp>
 
 #ifdef LHM_Enabled
 	#pragma comment(lib, "external\\CPPdll.lib")
@@ -162,12 +168,84 @@ namespace Shared {
 		~WMIObjectReleaser() { if (&WbClObj != nullptr) WbClObj.Release(); }
 	};
 
-	class VariantWrap {
+	//* Wmi::Enumerator running queries with WbemServices, result objects are fetched in batches
+	class WbemQuery : public Wmi::Enumerator {
+		class WbemRow : public Wmi::Row {
+		public:
+			vector<VARIANT> values;
+
+			WbemRow(const size_t columns) : values(columns) { for (auto& v : values) VariantInit(&v); }
+			~WbemRow() { clear(); }
+			void clear() { for (auto& v : values) VariantClear(&v); }
+
+			wstring_view str(const size_t column) const override {
+				const auto& v = values.at(column);
+				if (v.vt != VT_BSTR or v.bstrVal == nullptr) return {};
+				return { v.bstrVal, SysStringLen(v.bstrVal) };
+			}
+
+			uint64_t num(const size_t column) const override {
+				const auto& v = values.at(column);
+				switch (v.vt) {
+					case VT_BSTR: return Wmi::to_uint(str(column));
+					case VT_BOOL: return (v.boolVal == VARIANT_TRUE);
+					case VT_I1: case VT_UI1: return v.bVal;
+					case VT_I2: case VT_UI2: return v.uiVal;
+					case VT_I4: case VT_UI4: return v.ulVal;
+					case VT_I8: case VT_UI8: return v.ullVal;
+					default: return 0;
+				}
+			}
+		};
 	public:
-		VARIANT val;
-		VariantWrap() { ; }
-		auto operator()() { return &val; }
-		~VariantWrap() { VariantClear(&val); }
+		void query(const Wmi::Query& query, const std::function<void(const Wmi::Row&)>& row_callback) override {
+			string select;
+			vector<_bstr_t> columns;
+			for (const auto& column : query.columns) {
+				select += (select.empty() ? "SELECT " : ", ") + column;
+				columns.emplace_back(column.c_str());
+			}
+			select += " FROM " + query.from;
+
+			WbemEnumerator WMI;
+			if (auto hr = WbemServices->ExecQuery(_bstr_t(L"WQL"), _bstr_t(select.c_str()), WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY, 0, &WMI.WbEnum); FAILED(hr) or WMI() == nullptr) {
+				throw std::runtime_error("Shared::WbemQuery() (" + query.from + ") -> WbemServices query failed with code: " + to_string(hr));
+			}
+
+			WbemRow row(columns.size());
+			std::array<IWbemClassObject*, 64> results;
+			ULONG count = 0;
+			HRESULT hr;
+			while (SUCCEEDED(hr = WMI.WbEnum->Next(WBEM_INFINITE, (ULONG)results.size(), results.data(), &count)) and count > 0) {
+				for (ULONG i = 0; i < count; i++) {
+					WMIObjectReleaser rls(results[i]);
+					row.clear();
+					for (size_t c = 0; c < columns.size(); c++) {
+						results[i]->Get(columns[c], 0, &row.values[c], 0, 0);
+					}
+					row_callback(row);
+				}
+				if (hr != WBEM_S_NO_ERROR) break;
+			}
+			if (FAILED(hr))
+				throw std::runtime_error("Shared::WbemQuery() (" + query.from + ") -> IEnumWbemClassObject::Next() failed with code: " + to_string(hr));
+		}
+	};
+
+	//* Accounts::Resolver using LookupAccountSid(), account ids are binary SIDs
+	class SidResolver : public Accounts::Resolver {
+	public:
+		bool lookup(const string& id, string& name) override {
+			SID_NAME_USE SidType;
+			wchar_t lpName[260];
+			wchar_t lpDomain[260];
+			DWORD nameSize = 260;
+			DWORD domainSize = 260;
+			if (not LookupAccountSid(0, (PSID)id.data(), lpName, &nameSize, lpDomain, &domainSize, &SidType)) return false;
+			name = bstr2str(lpName);
+			if (name.empty()) name = bstr2str(lpDomain);
+			return true;
+		}
 	};
 
 }
@@ -181,6 +259,17 @@ namespace Mem {
 namespace Cpu {
 	vector<long long> core_old_totals;
 	vector<long long> core_old_idles;
+
+	//? Ring of samples from the high frequency sampler, single producer (sampler thread) and single consumer (Cpu::collect),
+	//? each sample is the total followed by the usage of each core
+	const size_t sample_capacity = 1024;
+	size_t sample_stride = 0;
+	vector<long long> sample_ring;
+	atomic<size_t> sample_head (0), sample_tail (0);
+	atomic<int> sample_ms (0);
+	atomic<bool> sample_failed (false);
+	SampleTimer sample_timer;
+
 	vector<string> available_fields;
 	vector<string> available_sensors = { "Auto" };
 	cpu_info current_cpu;
@@ -189,11 +278,69 @@ namespace Cpu {
 	bool has_gpu = false;
 	atomic<uint64_t> OHMRTimer = 0;
 	bool has_OHMR = true;
-	std::mutex OHMRmutex;
 	std::binary_semaphore OHMR_work(0);
-	inline bool OHMR_wait() { return OHMR_work.try_acquire_for(std::chrono::milliseconds(100)); }
+	inline void OHMR_wait() { OHMR_work.acquire(); }
 	inline void OHMR_trigger() { OHMR_work.release(); }
 
+	//? Usage of a core in percent since the counters in <old_total> and <old_idle>, which are updated with the new counters
+	inline long long core_usage(const _SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION& info, long long& old_total, long long& old_idle) {
+		const long long idle = info.IdleTime.QuadPart;
+		const long long totals = (info.KernelTime.QuadPart - idle) + info.UserTime.QuadPart + info.Reserved1[0].QuadPart + info.Reserved1[1].QuadPart + idle;
+		const long long calc_totals = max(0ll, totals - old_total);
+		const long long calc_idles = max(0ll, idle - old_idle);
+		old_total = totals;
+		old_idle = idle;
+		if (calc_totals == 0) return 0;
+		return clamp((long long)round((double)(calc_totals - calc_idles) * 100 / calc_totals), 0ll, 100ll);
+	}
+
+	void sample_collect() {
+		Trace::thread_name("cpu sampler");
+		const size_t cores = Shared::coreCount;
+		vector<_SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION> sppi(cores);
+		vector<long long> old_totals(cores, 0), old_idles(cores, 0);
+		bool primed = false;
+		auto next = std::chrono::steady_clock::now();
+
+		while (true) {
+			const int interval = sample_ms.load();
+			if (interval <= 0) {
+				sample_ms.wait(interval);
+				primed = false;
+				next = std::chrono::steady_clock::now();
+				continue;
+			}
+
+			if (not NT_SUCCESS(NtQuerySystemInformation(SystemProcessorPerformanceInformation, sppi.data(),
+					(ULONG)(cores * sizeof(_SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION)), NULL))) {
+				Logger::warning("Cpu::sample_collect() -> NtQuerySystemInformation() failed, high frequency cpu sampling disabled.");
+				sample_failed = true;
+				return;
+			}
+
+			//? Counters are always read to keep the deltas current, the sample is dropped if the ring is full or this is the first read
+			const size_t head = sample_head.load(std::memory_order_relaxed);
+			long long* sample = (primed and head - sample_tail.load(std::memory_order_acquire) < sample_capacity
+				? &sample_ring[(head % sample_capacity) * sample_stride] : nullptr);
+			long long total = 0;
+			for (size_t i = 0; i < cores; i++) {
+				const long long usage = core_usage(sppi[i], old_totals[i], old_idles[i]);
+				total += usage;
+				if (sample != nullptr) sample[i + 1] = usage;
+			}
+			if (sample != nullptr) {
+				sample[0] = total / (long long)cores;
+				sample_head.store(head + 1, std::memory_order_release);
+			}
+			primed = true;
+
+			//? Keep a fixed rate without trying to catch up on missed samples
+			next += std::chrono::milliseconds(interval);
+			if (const auto now = std::chrono::steady_clock::now(); next < now) next = now;
+			std::this_thread::sleep_until(next);
+		}
+	}
+
 	string get_cpuName();
 
 	struct Sensor {
@@ -204,8 +351,14 @@ namespace Cpu {
 		int64_t crit = 0;
 	};
 
-	OHMRraw OHMRrawStats{};
-	vector<string> gpu_order;
+	snapshot_cell<OHMRraw> OHMRrawStats;
+	std::shared_ptr<const OHMRraw> get_OHMR() { return OHMRrawStats.load(); }
+
+	//? Set when sensor values are read from a collector daemon instead of Libre Hardware Monitor
+	bool lhm_shared = false;
+
+	//? Sensor layout of the Libre Hardware Monitor output, compiled on the first collect from OHMR_init() and again when the layout changes
+	Lhm::Mapping lhm_mapping;
 
 	unordered_flat_map<string, Sensor> found_sensors;
 	string cpu_sensor;
@@ -217,49 +370,43 @@ namespace Cpu {
 	const double LAVG_1F = 0.9200444146293232478931553241;
 	const double LAVG_5F = 0.9834714538216174894737477501;
 	const double LAVG_15F = 0.9944598480048967508795473394;
-	double load_avg_1m = 0.0;
-	double load_avg_5m = 0.0;
-	double load_avg_15m = 0.0;
+	snapshot_cell<array<double, 3>> load_avg;
 
-	void CALLBACK LoadAvgCallback(PVOID hCounter, BOOLEAN timedOut) {
+	HQUERY load_query = nullptr;
+	HCOUNTER load_counter = nullptr;
+
+	//* Sample processor queue length and update the load averages, run every 5 seconds by the scheduler
+	void loadAVG_update() {
 		PDH_FMT_COUNTERVALUE displayValue;
-		double currentLoad;
-		
-		if (PdhGetFormattedCounterValue((PDH_HCOUNTER)hCounter, PDH_FMT_DOUBLE, 0, &displayValue) != ERROR_SUCCESS) {
+		if (PdhCollectQueryData(load_query) != ERROR_SUCCESS
+			or PdhGetFormattedCounterValue(load_counter, PDH_FMT_DOUBLE, 0, &displayValue) != ERROR_SUCCESS) {
 			return;
 		}
-		currentLoad = displayValue.doubleValue;
+		const double currentLoad = displayValue.doubleValue;
+		Trace::Span span("loadavg", "background");
 
-		load_avg_1m = load_avg_1m * LAVG_1F + currentLoad * (1.0 - LAVG_1F);
-		load_avg_5m = load_avg_5m * LAVG_5F + currentLoad * (1.0 - LAVG_5F);
-		load_avg_15m = load_avg_15m * LAVG_15F + currentLoad * (1.0 - LAVG_15F);
+		auto avg = *load_avg.load();
+		avg[0] = avg[0] * LAVG_1F + currentLoad * (1.0 - LAVG_1F);
+		avg[1] = avg[1] * LAVG_5F + currentLoad * (1.0 - LAVG_5F);
+		avg[2] = avg[2] * LAVG_15F + currentLoad * (1.0 - LAVG_15F);
+		load_avg.publish(std::move(avg));
 	}
 
-	void loadAVG_init() {
-		HQUERY hQuery;
-		if (PdhOpenQueryW(nullptr, 0, &hQuery) != ERROR_SUCCESS) {
-			throw std::runtime_error("Cpu::loadAVG_init() -> PdhOpenQueryW failed");
-		}
-
-		HCOUNTER hCounter;
-		if (PdhAddEnglishCounterW(hQuery, L"\\System\\Processor Queue Length", 0, &hCounter) != ERROR_SUCCESS) {
-			throw std::runtime_error("Cpu::loadAVG_init() -> PdhAddEnglishCounterW failed");
-		}
-		
-		HANDLE eventh = CreateEventW(NULL, FALSE, FALSE, L"LoadUpdateEvent");
-		if (eventh == NULL) {
-			throw std::runtime_error("Cpu::loadAVG_init() -> CreateEventW failed");
+	bool loadAVG_init() {
+		if (PdhOpenQueryW(nullptr, 0, &load_query) != ERROR_SUCCESS) {
+			Logger::warning("Cpu::loadAVG_init() -> PdhOpenQueryW failed, load average disabled.");
+			return false;
 		}
 
-		
-		if (PdhCollectQueryDataEx(hQuery, 5, eventh) != ERROR_SUCCESS) {
-			throw std::runtime_error("Cpu::loadAVG_init() -> PdhCollectQueryDataEx failed");
+		if (PdhAddEnglishCounterW(load_query, L"\\System\\Processor Queue Length", 0, &load_counter) != ERROR_SUCCESS) {
+			Logger::warning("Cpu::loadAVG_init() -> PdhAddEnglishCounterW failed, load average disabled.");
+			PdhCloseQuery(load_query);
+			return false;
 		}
 
-		HANDLE waitHandle;
-		if (RegisterWaitForSingleObject(&waitHandle, eventh, (WAITORTIMERCALLBACK)LoadAvgCallback, (PVOID)hCounter, INFINITE, WT_EXECUTEDEFAULT) == 0) {
-			throw std::runtime_error("Cpu::loadAVG_init() -> RegisterWaitForSingleObject failed");
-		}
+		//? First sample only primes the query
+		PdhCollectQueryData(load_query);
+		return true;
 	}
 
 	//bool NvSMI_init() {
@@ -297,134 +444,92 @@ namespace Cpu {
 
 	double ohmr_shared_mem = 0;
 
+	//* Publish new sensor values and update the available gpus and temperatures if changed, <init> is set for the first values
+	void OHMR_publish(OHMRraw&& stats, const bool init) {
+		const bool no_gpus = stats.GPUS.empty();
+		const bool no_temps = stats.CPU.empty();
+		const bool single_temp = (stats.CPU.size() == 1);
+		const vector<string> gpu_order = (has_gpu == no_gpus ? stats.GPUorder : vector<string>{});
+		OHMRrawStats.publish(std::move(stats));
+
+		if (has_gpu == no_gpus) {
+			atomic_wait(Runner::active);
+			Config::available_gpus = { "Auto" };
+			for (auto& gpu : gpu_order) {
+				Config::available_gpus.push_back(gpu);
+			}
+			if (auto it = rng::find(available_fields, "gpu"s); it != available_fields.end()) {
+				available_fields.erase(it);
+			}
+			else {
+				available_fields.push_back("gpu");
+			}
+
+			has_gpu = not has_gpu;
+			if (not init) Global::resized = true;
+		}
+		if (got_sensors == no_temps) {
+			atomic_wait(Runner::active);
+			got_sensors = not got_sensors;
+			if (single_temp) cpu_temp_only = true;
+			if (not init) Global::resized = true;
+		}
+	}
+
 	//* Collects Cpu, Motherboard and Gpu information from Libre Hardware Monitor using LHM-CPPdll (https://github.com/aristocratos/LHM-CppExport)
 	void OHMR_collect() {
 	#ifdef LHM_Enabled
 		static bool ohmr_init = true;
+		Trace::thread_name("lhm");
 		while (not Global::quitting and has_OHMR) {
-			if (not OHMR_wait()) continue;
-			if (OHMRTimer > 0) sleep_ms(Config::getI("update_ms") - (OHMRTimer / 750));
+			OHMR_wait();
+
+			//? Values from a collector daemon are used as is, frames not updated since last read are published again
+			if (lhm_shared) {
+				if (OHMRraw stats; Share::read_lhm(stats)) OHMR_publish(std::move(stats), false);
+				continue;
+			}
+
 			auto timeStart = time_micros();
+			Trace::Span span_total("lhm::collect", "background");
 			
 			//? Fetch sensors values
-			auto outvec = ssplit(FetchLHMValues(), '\n');
+			Trace::Span span_fetch("lhm::fetch", "background");
+			const string output = FetchLHMValues();
+			span_fetch.end();
+
+			//? Parse Libre Hardware Monitor output
+			Trace::Span span_parse("lhm::parse", "background");
+			OHMRraw stats;
+			Lhm::Errors errors;
+			if (not Lhm::extract(output, lhm_mapping, stats, errors)) {
+				lhm_mapping = Lhm::compile(output);
+				stats = {};
+				errors = {};
+				if (lhm_mapping.lines > 0) {
+					Logger::debug("Libre Hardware Monitor sensor layout mapped: ", lhm_mapping.sensors.size(), " sensors in ", lhm_mapping.headers.size(), " hardware sections");
+					Lhm::extract(output, lhm_mapping, stats, errors);
+				}
+			}
+			span_parse.end();
 
-			if (outvec.empty()) {
+			if (lhm_mapping.lines == 0) {
 				Logger::error("Libre Hardware Monitor found no sensors. Disabling CPU clock/temp monitoring and GPU monitoring.");
 				has_OHMR = false;
 				return;
 			}
 
-			
+			//? Sensors with malformed values are skipped, only log when the first error changes to avoid a warning every update
+			static string last_error;
+			if (errors.count > 0 and errors.reason != last_error) {
+				Logger::warning("Libre Hardware Monitor output had ", errors.count, " malformed value(s), first at line ", errors.line, ": ", errors.reason);
+				last_error = errors.reason;
+			}
+			else if (errors.count == 0)
+				last_error.clear();
 
-			bool isGPU = false;
-			bool hasPackage = false;
-			bool hasGPUload = false;
-			int mb_cpu = 0;
-			int mb_system = 0;
-			OHMRraw stats;
 			auto& gpus = stats.GPUS;
 			auto& cpu_temps = stats.CPU;
-			auto& cpu_clock = stats.CpuClock;
-
-			string cur_id = "";
-			string gpu_name = "";
-			gpu_order.clear();
-
-			//? Iterate over Libre Hardware Monitor output
-			for (const auto& line : outvec) {
-
-				//? Split line by tab separator
-				auto linevec = ssplit(line, '\t');
-				if (linevec.size() < 3) continue;
-				
-				try {
-					//? New sensor section
-					if (linevec.front() == "Hardware") {
-						cur_id = linevec.at(2);
-						if (cur_id.contains("Gpu")) {
-							gpu_name = linevec.at(1);
-							if (gpu_name.empty()) gpu_name = cur_id;
-							isGPU = true;
-							hasGPUload = false;
-							gpu_order.push_back(gpu_name);
-						}
-						else
-							isGPU = false;
-					}
-					else if (isGPU) {
-						if (linevec.front().starts_with("GPU Core")) {
-							//? Gpu clock
-							if (linevec.at(1) == "Clock") {
-								gpus[gpu_name].clock_mhz = linevec.at(2) + " Mhz";
-							}
-							//? Gpu temp
-							else if (linevec.at(1) == "Temperature") {
-								gpus[gpu_name].temp = std::stoi(linevec.at(2));
-							}
-							//? Gpu load
-							else if (linevec.at(1) == "Load") {
-								gpus[gpu_name].usage = std::stoi(linevec.at(2));
-								hasGPUload = true;
-								gpus[gpu_name].cpu_gpu = false;
-							}
-						}
-						else if (not hasGPUload and linevec.front().starts_with("D3D 3D") and linevec.at(1) == "Load") {
-							gpus[gpu_name].usage = std::stoi(linevec.at(2));
-							gpus[gpu_name].cpu_gpu = true;
-						}
-						//? Gpu mem used
-						else if (linevec.front().starts_with("GPU Memory Used") or linevec.front() == "D3D Shared Memory Used") {
-							gpus[gpu_name].mem_used = std::stoll(linevec.at(2)) << 20ll;
-						}
-						//? Gpu mem total
-						else if (linevec.front().starts_with("GPU Memory Total")) {
-							gpus[gpu_name].mem_total = std::stoll(linevec.at(2)) << 20ll;
-						}
-					}
-					else {
-						//? Cpu clock - using highest found value because an average of all cores doesn't do well on systems with efficiency cores
-						if ((linevec.front().starts_with("CPU Core") or linevec.front().starts_with("Core #")) and linevec.at(1) == "Clock") {
-							int clock = std::stoi(linevec.at(2));
-							if (clock > cpu_clock) cpu_clock = clock;
-						}
-						//? Cpu core and package temp
-						else if (linevec.at(1) == "Temperature") {
-							if (linevec.front().starts_with("CPU Core #") and not linevec.front().contains("TjMax")) {
-								cpu_temps.push_back(std::stoi(linevec.at(2)));
-							}
-							else if (not hasPackage and (linevec.front().starts_with("CPU Package") or linevec.front() == "Core (Tctl/Tdie)")) {
-								cpu_temps.insert(cpu_temps.begin(), std::stoi(linevec.at(2)));
-								hasPackage = true;
-							}
-							else if (not hasPackage and linevec.front() == "CPU") {
-								mb_cpu = std::stoi(linevec.at(2));
-							}
-							else if (not hasPackage and linevec.front() == "System") {
-								mb_system = std::stoi(linevec.at(2));
-							}
-						}
-					}
-				}
-				catch (const std::exception& e) {
-					Logger::error("Error during Libre Hardware Monitor parsing: "s + e.what());
-					has_gpu = false;
-					got_sensors = false;
-					has_OHMR = false;
-					Global::resized = true;
-					return;
-				}
-			}
-
-			if (not hasPackage) {
-				if (mb_cpu > 0)
-					cpu_temps.insert(cpu_temps.begin(), mb_cpu);
-				else if (not cpu_temps.empty()) {
-					cpu_temps.insert(cpu_temps.begin(), std::accumulate(cpu_temps.begin(), cpu_temps.end(), 0) / cpu_temps.size());
-				}
-				else if (mb_system > 0)
-					cpu_temps.insert(cpu_temps.begin(), mb_system);
-			}
 
 			if (not gpus.empty()) {
 				for (auto& [ignore, g] : gpus) {
@@ -437,34 +542,9 @@ namespace Cpu {
 			}
 			
 			OHMRTimer = time_micros() - timeStart;
+			Perf::add(Perf::lhm_collect, OHMRTimer);
 
-			{
-				std::lock_guard lck(OHMRmutex);
-				OHMRrawStats = stats;
-			}
-
-			if (has_gpu == gpus.empty()) {
-				atomic_wait(Runner::active);
-				Config::available_gpus = { "Auto" };
-				for (auto& gpu : gpu_order) {
-					Config::available_gpus.push_back(gpu);
-				}
-				if (auto it = rng::find(available_fields, "gpu"s); it != available_fields.end()) {
-					available_fields.erase(it);
-				}
-				else {
-					available_fields.push_back("gpu");
-				}
-
-				has_gpu = not has_gpu;
-				if (not ohmr_init) Global::resized = true;
-			}
-			if (got_sensors == cpu_temps.empty()) {
-				atomic_wait(Runner::active);
-				got_sensors = not got_sensors;
-				if (OHMRrawStats.CPU.size() == 1) cpu_temp_only = true;
-				if (not ohmr_init) Global::resized = true;
-			}
+			OHMR_publish(std::move(stats), ohmr_init);
 
 			if (ohmr_init) { ohmr_init = false; return; }
 		}
@@ -478,6 +558,13 @@ namespace Cpu {
 
 	void OHMR_init() {
 	#ifdef LHM_Enabled
+		//? Use sensors from a collector daemon if attached to one running Libre Hardware Monitor
+		if (OHMRraw stats; Share::read_lhm(stats, &current_cpu.temp_max, &core_mapping)) {
+			lhm_shared = true;
+			OHMR_publish(std::move(stats), true);
+			return;
+		}
+
 		string output = FetchLHMReport();
 		if (output.empty()) {
 			has_OHMR = false;
@@ -524,10 +611,10 @@ namespace Cpu {
 			}
 		}
 		catch (const std::exception& e) {
-			Logger::debug("Error getting CPU TjMax value from Open Hardware Monitor Report: "s + e.what());
+			Logger::debug("Error getting CPU TjMax value from Open Hardware Monitor Report: ", e.what());
 		}
 
-		int found_sensors = OHMRrawStats.CPU.size() - 1;
+		int found_sensors = OHMRrawStats.load()->CPU.size() - 1;
 
 		//? Get Cpu core mapping
 		unordered_flat_map<int, int> core_map;
@@ -553,7 +640,7 @@ namespace Cpu {
 			}
 		}
 		catch (const std::exception& e) {
-			Logger::debug("Error getting CPU core mapping from Open Hardware Monitor Report: "s + e.what());
+			Logger::debug("Error getting CPU core mapping from Open Hardware Monitor Report: ", e.what());
 			core_map.clear();
 		}
 
@@ -636,272 +723,67 @@ namespace Cpu {
 
 namespace Proc {
 
-	struct WMIEntry {
-		uint32_t ParentProcessId = 0;
-		_bstr_t Name;
-		_bstr_t CommandLine;
-		_bstr_t ExecutablePath;
-		_bstr_t KernelModeTime;
-		_bstr_t UserModeTime;
-		_bstr_t CreationDate;
-		uint32_t ThreadCount = 0;
-		_bstr_t PrivateMemory;
-		_bstr_t ReadTransferCount;
-		_bstr_t WriteTransferCount;
-	};
-
-	struct WMISvcEntry {
-		bool AcceptPause = false;
-		bool AcceptStop = false;
-		_bstr_t Name;
-		_bstr_t Caption;
-		_bstr_t Description;
-		uint32_t ProcessID;
-		_bstr_t ServiceType;
-		_bstr_t StartMode;
-		_bstr_t Owner;
-		_bstr_t State;
-	};
-
-	const struct WMIProcQuerys{
-		_bstr_t WQL = L"WQL";
-		_bstr_t SELECT = L"SELECT * FROM Win32_Process";
-		_bstr_t SELECTSvc = L"SELECT * FROM Win32_Service";
-		_bstr_t ProcessID = L"ProcessID";
-		_bstr_t Name = L"Name";
-		_bstr_t CommandLine = L"CommandLine";
-		_bstr_t ExecutablePath = L"ExecutablePath";
-		_bstr_t KernelModeTime = L"KernelModeTime";
-		_bstr_t UserModeTime = L"UserModeTime";
-		_bstr_t CreationDate = L"CreationDate";
-		_bstr_t ThreadCount = L"ThreadCount";
-		_bstr_t PrivateMemory = L"PrivatePageCount";
-		_bstr_t ReadTransferCount = L"ReadTransferCount";
-		_bstr_t WriteTransferCount = L"WriteTransferCount";
-		_bstr_t ParentProcessId = L"ParentProcessId";
-	};
-
-	const struct WMISvcQuerys {
-		_bstr_t WQL = L"WQL";
-		_bstr_t SELECT = L"SELECT * FROM Win32_Service";
-		_bstr_t ProcessID = L"ProcessID";
-		_bstr_t AcceptPause = L"AcceptPause";
-		_bstr_t AcceptStop = L"AcceptStop";
-		_bstr_t Name = L"Name";
-		_bstr_t Caption = L"Caption";
-		_bstr_t Description = L"Description";
-		_bstr_t StartMode = L"StartMode";
-		_bstr_t Owner = L"StartName";
-		_bstr_t State = L"State";
-		_bstr_t ServiceType = L"ServiceType";
-
-	};
-
 	std::binary_semaphore wmi_work(0);
-	inline bool WMI_wait() { return wmi_work.try_acquire_for(std::chrono::milliseconds(100)); }
+	inline void WMI_wait() { wmi_work.acquire(); }
 	inline void WMI_trigger() { wmi_work.release(); }
 	atomic<bool> WMI_running = false;
 	atomic<uint64_t> WMItimer = 0;
-	vector<size_t> WMI_requests;
-	robin_hood::unordered_flat_map<size_t, WMIEntry> WMIList;
-	robin_hood::unordered_flat_map<string, WMISvcEntry> WMISvcList;
-	std::mutex WMImutex;
+
+	using WMIProcMap = Wmi::ProcMap;
+	using WMISvcMap = Wmi::SvcMap;
+	snapshot_cell<WMIProcMap> WMIList;
+	snapshot_cell<WMISvcMap> WMISvcList;
+
+	//? Pids that needs a WMI refresh, only the swap/insert is done under lock
+	robin_hood::unordered_flat_set<size_t> WMI_requests;
+	std::mutex WMI_requests_lock;
+
+	//? Snapshots and requests owned by the runner thread for the duration of a Proc::collect() pass
+	std::shared_ptr<const WMIProcMap> wmi_procs = std::make_shared<const WMIProcMap>();
+	std::shared_ptr<const WMISvcMap> wmi_svcs = std::make_shared<const WMISvcMap>();
+	vector<size_t> new_requests;
+
+	//* Hand over pids requested during the current collect pass to the WMI thread
+	void flush_WMI_requests() {
+		if (new_requests.empty()) return;
+		{
+			std::lock_guard lck(WMI_requests_lock);
+			WMI_requests.insert(new_requests.begin(), new_requests.end());
+		}
+		new_requests.clear();
+		WMI_trigger();
+	}
 
 	//? WMI thread, collects process/service information once every second to augment missing information from the standard WIN32 API methods
 	void WMICollect() {
-		WMIProcQuerys QProc{};
-		WMISvcQuerys QSvc{};
-		int counter = 0;
+		Shared::WbemQuery WMI;
+		Trace::thread_name("wmi");
 		while (not Global::quitting) {
-			if (not WMI_wait() and not (Config::getB("proc_services") and counter++ >= 50)) continue;
-			counter = 0;
-			vector<size_t> requests;
+			WMI_wait();
+			robin_hood::unordered_flat_set<size_t> requests;
 			atomic_wait(Runner::active);
 			atomic_lock lck(WMI_running);
-			requests.swap(WMI_requests);
+			{
+				std::lock_guard req_lck(WMI_requests_lock);
+				requests.swap(WMI_requests);
+			}
 			auto timeStart = time_micros();
+			Trace::Span span_total("wmi::collect", "background");
 
 			//* Processes
 			{
-				Shared::WbemEnumerator WMI;
-				robin_hood::unordered_flat_map<size_t, WMIEntry> newWMIList = WMIList;
-				auto& Q = QProc;
-				vector<size_t> found;
-
-				if (auto hr = Shared::WbemServices->ExecQuery(Q.WQL, Q.SELECT, WBEM_RETURN_WHEN_COMPLETE, 0, &WMI.WbEnum); FAILED(hr) or WMI() == nullptr) {
-					throw std::runtime_error("Proc::WMICollect() (Processes) [thread] -> WbemServices query failed with code: " + to_string(hr));
-				}
-
-				IWbemClassObject* result = NULL;
-				ULONG retCount = 0;
-
-				while (WMI.WbEnum->Next(WBEM_INFINITE, 1, &result, &retCount) == S_OK) {
-					Shared::WMIObjectReleaser rls(result);
-					if (retCount == 0) break;
-					size_t pid = 0;
-					bool new_entry = false;
-					
-					Shared::VariantWrap ProcessId{};
-					if (result->Get(Q.ProcessID, 0, &ProcessId.val, 0, 0) != S_OK) continue;
-					pid = ProcessId()->uintVal;
-					
-					found.push_back(pid);
-					if (pid == 0 or (not requests.empty() and not v_contains(requests, pid))) continue;
-
-					if (not newWMIList.contains(pid)) {
-						newWMIList[pid] = {};
-						new_entry = true;
-					}
-					auto& entry = newWMIList.at(pid);
-					
-					Shared::VariantWrap ReadTransferCount{};
-					if (result->Get(Q.ReadTransferCount, 0, &ReadTransferCount.val, 0, 0) == S_OK)
-						entry.ReadTransferCount = ReadTransferCount()->bstrVal;
-					
-					Shared::VariantWrap WriteTransferCount{};
-					if (result->Get(Q.WriteTransferCount, 0, &WriteTransferCount.val, 0, 0) == S_OK)
-						entry.WriteTransferCount = WriteTransferCount()->bstrVal;
-
-					Shared::VariantWrap PrivateMemory{};
-					if (result->Get(Q.PrivateMemory, 0, &PrivateMemory.val, 0, 0) == S_OK)
-						entry.PrivateMemory = PrivateMemory()->bstrVal;
-					
-					Shared::VariantWrap KernelModeTime{};
-					if (result->Get(Q.KernelModeTime, 0, &KernelModeTime.val, 0, 0) == S_OK)
-						entry.KernelModeTime = KernelModeTime()->bstrVal;
-					
-					Shared::VariantWrap UserModeTime{};
-					if (result->Get(Q.UserModeTime, 0, &UserModeTime.val, 0, 0) == S_OK)
-						entry.UserModeTime = UserModeTime()->bstrVal;
-					
-					Shared::VariantWrap ThreadCount{};
-					if (result->Get(Q.ThreadCount, 0, &ThreadCount.val, 0, 0) == S_OK)
-						entry.ThreadCount = ThreadCount()->uintVal;
-					
-					
-					if (new_entry) {
-						Shared::VariantWrap ParentProcessId{};
-						if (result->Get(Q.ParentProcessId, 0, &ParentProcessId.val, 0, 0) == S_OK)
-							entry.ParentProcessId = ParentProcessId()->uintVal;
-					
-						Shared::VariantWrap Name{};
-						if (result->Get(Q.Name, 0, &Name.val, 0, 0) == S_OK)
-							entry.Name = Name()->bstrVal;
-					
-						Shared::VariantWrap CommandLine{};
-						if (result->Get(Q.CommandLine, 0, &CommandLine.val, 0, 0) == S_OK)
-							entry.CommandLine = CommandLine()->bstrVal;
-					
-						Shared::VariantWrap ExecutablePath{};
-						if (result->Get(Q.ExecutablePath, 0, &ExecutablePath.val, 0, 0) == S_OK)
-							entry.ExecutablePath = ExecutablePath()->bstrVal;
-
-						Shared::VariantWrap CreationDate{};
-						if (result->Get(Q.CreationDate, 0, &CreationDate.val, 0, 0) == S_OK)
-							entry.CreationDate = CreationDate()->bstrVal;
-					}
-
-
-				}
-
-				//? Clear dead processes from list
-				for (auto it = newWMIList.begin(); it != newWMIList.end();) {
-					if (not v_contains(found, it->first))
-						it = newWMIList.erase(it);
-					else
-						it++;
-				}
-
-				const std::lock_guard<std::mutex> lck(Proc::WMImutex);
-				Proc::WMIList.swap(newWMIList);
+				Trace::Span span("wmi::processes", "background");
+				Proc::WMIList.publish(Wmi::update_procs(WMI, *WMIList.load(), requests));
 			}
-				
-			//* Services
-			if (Config::getB("proc_services") or WMISvcList.empty()) {
-				Shared::WbemEnumerator WMI;
-				robin_hood::unordered_flat_map<string, WMISvcEntry> newWMISvcList = WMISvcList;
-				auto& Q = QSvc;
-				vector<string> found;
-
-				if (auto hr = Shared::WbemServices->ExecQuery(Q.WQL, Q.SELECT, WBEM_RETURN_WHEN_COMPLETE, 0, &WMI.WbEnum); FAILED(hr) or WMI() == nullptr) {
-					throw std::runtime_error("Proc::WMICollect() (Services) [thread] -> WbemServices query failed with code: " + to_string(hr));
-				}
-
-				IWbemClassObject* result = NULL;
-				ULONG retCount = 0;
-
-				while (WMI.WbEnum->Next(WBEM_INFINITE, 1, &result, &retCount) == S_OK) {
-					Shared::WMIObjectReleaser rls(result);
-					if (retCount == 0) break;
-					string name;
-					bool new_entry = false;
-					
-					Shared::VariantWrap Name{};
-					if (result->Get(Q.Name, 0, &Name.val, 0, 0) == S_OK)
-						name = bstr2str(Name()->bstrVal);
-					
-					if (name.empty()) continue;
-					found.push_back(name);
-					if (not newWMISvcList.contains(name)) {
-						newWMISvcList[name] = {};
-						new_entry = true;
-					}
-					auto& entry = newWMISvcList.at(name);
-					
-					Shared::VariantWrap ProcessId{};
-					if (result->Get(Q.ProcessID, 0, &ProcessId.val, 0, 0) == S_OK)
-						entry.ProcessID = ProcessId()->uintVal;
-					
-					Shared::VariantWrap StartMode{};
-					if (result->Get(Q.StartMode, 0, &StartMode.val, 0, 0) == S_OK)
-						entry.StartMode = StartMode()->bstrVal;
-					
-					Shared::VariantWrap AcceptPause{};
-					if (result->Get(Q.AcceptPause, 0, &AcceptPause.val, 0, 0) == S_OK)
-						entry.AcceptPause = (AcceptPause()->boolVal == VARIANT_TRUE);
-					
-					Shared::VariantWrap AcceptStop{};
-					if (result->Get(Q.AcceptStop, 0, &AcceptStop.val, 0, 0) == S_OK)
-						entry.AcceptStop = (AcceptStop()->boolVal == VARIANT_TRUE);
-					
-					Shared::VariantWrap Owner{};
-					if (result->Get(Q.Owner, 0, &Owner.val, 0, 0) == S_OK)
-						entry.Owner = Owner()->bstrVal;
-					
-					Shared::VariantWrap State{};
-					if (result->Get(Q.State, 0, &State.val, 0, 0) == S_OK)
-						entry.State = State()->bstrVal;
-					
-					if (new_entry) {
-						Shared::VariantWrap Caption{};
-						if (result->Get(Q.Caption, 0, &Caption.val, 0, 0) == S_OK)
-							entry.Caption = Caption()->bstrVal;
-					
-						Shared::VariantWrap Description{};
-						if (result->Get(Q.Description, 0, &Description.val, 0, 0) == S_OK)
-							entry.Description = Description()->bstrVal;
 
-						Shared::VariantWrap ServiceType{};
-						if (result->Get(Q.ServiceType, 0, &ServiceType.val, 0, 0) == S_OK)
-							entry.ServiceType = ServiceType()->bstrVal;
-					}
-					
-
-				}
-				
-				//? Clear missing services from list
-				for (auto it = newWMISvcList.begin(); it != newWMISvcList.end();) {
-					if (not v_contains(found, it->first))
-						it = newWMISvcList.erase(it);
-					else
-						it++;
-				}
-				
-				const std::lock_guard<std::mutex> lck(Proc::WMImutex);
-				Proc::WMISvcList.swap(newWMISvcList);
+			//* Services
+			if (Config::getB("proc_services") or WMISvcList.load()->empty()) {
+				Trace::Span span("wmi::services", "background");
+				Proc::WMISvcList.publish(Wmi::update_services(WMI, *WMISvcList.load()));
 			}
 
 			Proc::WMItimer = time_micros() - timeStart;
+			Perf::add(Perf::wmi_collect, Proc::WMItimer);
 		}
 	}
 }
@@ -917,7 +799,7 @@ namespace Shared {
 	#else
 		static bool enabled = false;
 	#endif
-		if (not enabled) return;
+		if (not enabled or Export::active or Share::daemon) return;
 		static int current = 0;
 		static const int x = Term::width / 2 - 15;
 		static const int y = Term::height / 2 - 10;
@@ -938,6 +820,21 @@ namespace Shared {
 		sleep_ms(100);
 	}
 
+	void headless_setup(const bool cpu, const bool mem, const bool net, const bool proc) {
+		//? The shown flags tells background collectors like LHM which data is needed and the widths limits graph histories to a few samples
+		Cpu::shown = cpu;
+		Mem::shown = mem;
+		Net::shown = net;
+		Proc::shown = proc;
+		Cpu::width = Mem::width = Net::width = Proc::width = 10;
+
+		//? Options only meaningful for the tui are overridden and processes are collected unfiltered, the config file is not written
+		Config::set("adaptive_sampling", false);
+		Config::set("proc_services", false);
+		Config::set("proc_tree", false);
+		Config::set("proc_filter", string{});
+	}
+
 	void init() {
 
 		//? Shared global variables init
@@ -976,7 +873,15 @@ namespace Shared {
 		//? Start up background thread for Libre Hardware Monitor
 		if (Config::bools.at("enable_ohmr")) {
 			Cpu::OHMR_init();
-			if (Cpu::has_OHMR) std::thread(Cpu::OHMR_collect).detach();
+			if (Cpu::has_OHMR) {
+				std::thread(Cpu::OHMR_collect).detach();
+
+				//? Trigger sensor collection at the interval of the box using it, ahead of the box update by about the time it takes
+				Scheduler::add("lhm",
+					[] { return Runner::interval(Cpu::shown or not Mem::shown ? "cpu" : "mem"); },
+					[] { if (Cpu::shown or Mem::shown) Cpu::OHMR_trigger(); },
+					[] { return Cpu::OHMRTimer / 750; });
+			}
 		}
 		else {
 			Cpu::has_OHMR = false;
@@ -988,6 +893,7 @@ namespace Shared {
 		init_status("CPU Init");
 		//? Init for namespace Cpu
 		Cpu::current_cpu.core_percent.insert(Cpu::current_cpu.core_percent.begin(), Shared::coreCount, {});
+		Cpu::current_cpu.core_max.insert(Cpu::current_cpu.core_max.begin(), Shared::coreCount, {});
 		Cpu::current_cpu.temp.insert(Cpu::current_cpu.temp.begin(), Shared::coreCount + 1, {});
 		Cpu::current_cpu.temp_max = 100;
 		Cpu::core_old_totals.insert(Cpu::core_old_totals.begin(), Shared::coreCount, 0);
@@ -998,12 +904,17 @@ namespace Shared {
 		}
 		Cpu::cpuName = Cpu::get_cpuName();
 
-		//? Start up loadAVG counter in background
-		std::thread(Cpu::loadAVG_init).detach();
+		//? Start high frequency cpu sampler, idle until enabled with cpu_sample_ms
+		Cpu::sample_stride = Shared::coreCount + 1;
+		Cpu::sample_ring.resize(Cpu::sample_capacity * Cpu::sample_stride);
+		std::thread(Cpu::sample_collect).detach();
+
+		//? Sample load average every 5 seconds, the factors used for the averages assumes this interval
+		if (Cpu::loadAVG_init()) Scheduler::add("loadavg", [] { return 5000; }, Cpu::loadAVG_update);
 
 		init_status("MEM Init");
 		//? Init for namespace Mem
-		Mem::old_systime = GetTickCount64();
+		Mem::old_systime = steady_ms();
 		Mem::collect();
 
 		init_status("Connecting to WMI");
@@ -1011,9 +922,11 @@ namespace Shared {
 		Shared::WMI_init();
 
 		init_status("Starting WMI monitor");
-		//? Start up WMI system info collector in background
+		//? Start up WMI system info collector in background, triggered when new processes needs lookup
+		//? and every 5 seconds to refresh services when shown
 		std::thread(Proc::WMICollect).detach();
 		Proc::WMI_trigger();
+		Scheduler::add("wmi", [] { return 5000; }, [] { if (Proc::shown and Config::getB("proc_services")) Proc::WMI_trigger(); });
 
 		if (Cpu::has_OHMR) {
 			atomic_wait_for(Proc::WMI_running, false, 100);
@@ -1186,11 +1099,15 @@ namespace Cpu {
 		if (Runner::stopping or (no_update and not current_cpu.cpu_percent.at("total").empty())) return current_cpu;
 		auto& cpu = current_cpu;
 
+		//? Mark samples missed since last update as gaps in all graph histories
+		const size_t gaps = sample_timer.tick(Runner::interval("cpu"), width * 2);
+		const uint64_t now = steady_ms();
+
 		if (has_OHMR) {
-			std::lock_guard lck(Cpu::OHMRmutex);
-			OHMR_trigger();
-			
-			auto hz = OHMRrawStats.CpuClock;
+			const auto ohmr = OHMRrawStats.load();
+			const auto& stats = *ohmr;
+
+			auto hz = stats.CpuClock;
 			if (hz >= 1000) {
 				if (hz >= 10000) cpuHz = to_string((int)round(hz / 1000));
 				else cpuHz = to_string(round(hz / 100) / 10.0).substr(0, 3);
@@ -1200,13 +1117,15 @@ namespace Cpu {
 				cpuHz = to_string((int)round(hz)) + " MHz";
 
 			if (got_sensors) {
-				current_cpu.temp.at(0).push_back(OHMRrawStats.CPU.at(0));
-				if (current_cpu.temp.at(0).size() > 20) current_cpu.temp.at(0).pop_front();
+				push_gaps(current_cpu.temp.at(0), gaps);
+				current_cpu.temp.at(0).push_back(stats.CPU.at(0));
+				while (current_cpu.temp.at(0).size() > 20) current_cpu.temp.at(0).pop_front();
 
 				for (const auto& [core, temp] : core_mapping) {
-					if (cmp_less(core + 1, current_cpu.temp.size()) and cmp_less(temp, OHMRrawStats.CPU.size() - 1)) {
-						current_cpu.temp.at(core + 1).push_back(OHMRrawStats.CPU.at(temp + 1));
-						if (current_cpu.temp.at(core + 1).size() > 20) current_cpu.temp.at(core + 1).pop_front();
+					if (cmp_less(core + 1, current_cpu.temp.size()) and cmp_less(temp, stats.CPU.size() - 1)) {
+						push_gaps(current_cpu.temp.at(core + 1), gaps);
+						current_cpu.temp.at(core + 1).push_back(stats.CPU.at(temp + 1));
+						while (current_cpu.temp.at(core + 1).size() > 20) current_cpu.temp.at(core + 1).pop_front();
 					}
 				}
 			}
@@ -1217,7 +1136,7 @@ namespace Cpu {
 					cpu.gpu_temp.clear();
 					cpu.cpu_percent.at("gpu").clear();
 					
-					if (current_gpu != "Auto" and not OHMRrawStats.GPUS.contains(current_gpu)) {
+					if (current_gpu != "Auto" and not stats.GPUS.contains(current_gpu)) {
 						current_gpu = "Auto";
 						Config::set("selected_gpu", current_gpu);
 					}
@@ -1234,11 +1153,14 @@ namespace Cpu {
 					
 					Cpu::redraw = true;
 				}
-				const auto& gpu = OHMRrawStats.GPUS.contains(current_gpu) ? OHMRrawStats.GPUS.at(current_gpu) : OHMRrawStats.GPUS.at(Config::available_gpus.at(1));
+				const auto& gpu = stats.GPUS.contains(current_gpu) ? stats.GPUS.at(current_gpu) : stats.GPUS.at(Config::available_gpus.at(1));
 				gpu_clock = gpu.clock_mhz;
+				push_gaps(cpu.gpu_temp, gaps);
 				cpu.gpu_temp.push_back(gpu.temp);
-				if (cpu.gpu_temp.size() > 40) cpu.gpu_temp.pop_front();
+				while (cpu.gpu_temp.size() > 40) cpu.gpu_temp.pop_front();
+				push_gaps(cpu.cpu_percent.at("gpu"), gaps);
 				cpu.cpu_percent.at("gpu").push_back(gpu.usage);
+				cpu.history["gpu"].add(gpu.usage, now);
 				while (cmp_greater(cpu.cpu_percent.at("gpu").size(), width * 2)) cpu.cpu_percent.at("gpu").pop_front();
 			}
 		}
@@ -1246,9 +1168,10 @@ namespace Cpu {
 			cpuHz = get_cpuHz();
 		}
 	
-		cpu.load_avg[0] = Cpu::load_avg_1m;
-		cpu.load_avg[1] = Cpu::load_avg_5m;
-		cpu.load_avg[2] = Cpu::load_avg_15m;
+		{
+			const auto avg = Cpu::load_avg.load();
+			for (size_t i = 0; i < cpu.load_avg.size(); i++) cpu.load_avg[i] = (float)avg->at(i);
+		}
 
 		vector<_SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION> sppi(Shared::coreCount);
 		if (not NT_SUCCESS(
@@ -1270,22 +1193,16 @@ namespace Cpu {
 			kernel.push_back(sppi[i].KernelTime.QuadPart - idle.back());
 			dpc.push_back(sppi[i].Reserved1[0].QuadPart);
 			interrupt.push_back(sppi[i].Reserved1[1].QuadPart);
-			
-
-			totals = 0;
-			for (auto& v : { kernel, user, dpc, interrupt, idle }) totals += v.back();
-			//for (auto& v : { idle, dpc, interrupt }) idles += v.back();
 
-			const long long calc_totals = max(0ll, totals - core_old_totals.at(i));
-			const long long calc_idles = max(0ll, idle.back() - core_old_idles.at(i));
-			core_old_totals.at(i) = totals;
-			core_old_idles.at(i) = idle.back();
-
-			cpu.core_percent.at(i).push_back(clamp((long long)round((double)(calc_totals - calc_idles) * 100 / calc_totals), 0ll, 100ll));
+			push_gaps(cpu.core_percent.at(i), gaps);
+			push_gaps(cpu.core_max.at(i), gaps);
+			cpu.core_percent.at(i).push_back(core_usage(sppi[i], core_old_totals.at(i), core_old_idles.at(i)));
+			cpu.core_max.at(i).push_back(cpu.core_percent.at(i).back());
 			cpu_total += cpu.core_percent.at(i).back();
 
 			//? Reduce size if there are more values than needed for graph
-			if (cpu.core_percent.at(i).size() > 40) cpu.core_percent.at(i).pop_front();
+			while (cpu.core_percent.at(i).size() > 40) cpu.core_percent.at(i).pop_front();
+			while (cpu.core_max.at(i).size() > 40) cpu.core_max.at(i).pop_front();
 
 		}
 
@@ -1302,13 +1219,34 @@ namespace Cpu {
 		cpu_old.at("totals") = totals;
 
 		//? Total usage of cpu
+		push_gaps(cpu.cpu_percent.at("total"), gaps);
 		cpu.cpu_percent.at("total").push_back(clamp(cpu_total / Shared::coreCount, 0ll, 100ll));
 
 		//? Reduce size if there are more values than needed for graph
 		while (cmp_greater(cpu.cpu_percent.at("total").size(), width * 2)) cpu.cpu_percent.at("total").pop_front();
 
+		//? Peak usage since last update from the high frequency sampler, the values above are the averages for the whole interval
+		if (not sample_failed) {
+			const int new_sample_ms = Config::getI("cpu_sample_ms");
+			if (sample_ms.exchange(new_sample_ms) != new_sample_ms) sample_ms.notify_all();
+		}
+		long long peak = cpu.cpu_percent.at("total").back();
+		const size_t head = sample_head.load(std::memory_order_acquire);
+		for (size_t tail = sample_tail.load(std::memory_order_relaxed); tail != head; tail++) {
+			const long long* sample = &sample_ring[(tail % sample_capacity) * sample_stride];
+			peak = max(peak, sample[0]);
+			for (int i = 0; i < Shared::coreCount; i++) {
+				if (sample[i + 1] > cpu.core_max.at(i).back()) cpu.core_max.at(i).back() = sample[i + 1];
+			}
+		}
+		sample_tail.store(head, std::memory_order_release);
+		push_gaps(cpu.cpu_percent.at("max"), gaps);
+		cpu.cpu_percent.at("max").push_back(peak);
+		while (cmp_greater(cpu.cpu_percent.at("max").size(), width * 2)) cpu.cpu_percent.at("max").pop_front();
+
 		//? Populate cpu.cpu_percent with all fields from stat
 		for (int ii = 0; const auto& val : times) {
+			push_gaps(cpu.cpu_percent.at(time_names.at(ii)), gaps);
 			cpu.cpu_percent.at(time_names.at(ii)).push_back(clamp((long long)round((double)(val - cpu_old.at(time_names.at(ii))) * 100 / calc_totals), 0ll, 100ll));
 			cpu_old.at(time_names.at(ii)) = val;
 
@@ -1317,6 +1255,15 @@ namespace Cpu {
 			ii++;
 		}
 
+		//? Add the new values to the histories used for the zoomed graphs
+		for (const auto& field : {"total", "max", "kernel", "user", "dpc", "interrupt", "idle"}) {
+			cpu.history[field].add(cpu.cpu_percent.at(field).back(), now);
+		}
+		cpu.core_history.resize(cpu.core_max.size());
+		for (size_t i = 0; i < cpu.core_max.size(); i++) {
+			cpu.core_history.at(i).add(cpu.core_max.at(i).back(), now);
+		}
+
 		if (Config::getB("show_battery"))
 			current_bat = get_battery();
 
@@ -1332,6 +1279,7 @@ namespace Mem {
 	vector<string> last_found;
 	int64_t totalMem = 0;
 	bool cpu_gpu = false;
+	SampleTimer sample_timer;
 
 	mem_info current_mem {};
 
@@ -1344,6 +1292,70 @@ namespace Mem {
 		return static_cast<int64_t>(memstat.ullTotalPhys);
 	}
 
+	bool get_drives(vector<drive_raw>& drives, const std::function<bool(const drive_raw&)>& wanted) {
+		//? Get bitmask containing drives in use
+		DWORD logical_drives = GetLogicalDrives();
+		if (logical_drives == 0) return false;
+
+		drives.clear();
+		for (int i = 0; i < 26; i++) {
+			if (not (logical_drives & (1 << i))) continue;
+			drive_raw drive;
+			drive.letter = string(1, 'A' + i) + ":\\";
+
+			//? Get device type and continue loop if unknown or failed
+			drive.type = GetDriveTypeA(drive.letter.c_str());
+			if (drive.type < 2) continue;
+
+			//? Get name of drive
+			array<char, MAX_PATH + 1> ch_name;
+			if (GetVolumeInformationA(drive.letter.c_str(), ch_name.data(), MAX_PATH + 1, 0, 0, 0, nullptr, 0))
+				drive.name = string(ch_name.data());
+
+			if (wanted and not wanted(drive)) continue;
+
+			//? Get disk total size and free space
+			ULARGE_INTEGER freeBytesCaller, totalBytes, freeBytes;
+			if (GetDiskFreeSpaceExA(drive.letter.c_str(), &freeBytesCaller, &totalBytes, &freeBytes)) {
+				drive.has_space = true;
+				drive.total = totalBytes.QuadPart;
+				drive.free = freeBytesCaller.QuadPart;
+				drive.free_priv = freeBytes.QuadPart;
+			}
+
+			//? Get disk IO
+			//! Based on the method used in psutil
+			//! see https://github.com/giampaolo/psutil/blob/master/psutil/arch/windows/disk.c
+			HandleWrapper dHandle(CreateFileW(_bstr_t(string("\\\\.\\" + drive.letter.substr(0, 2)).c_str()), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr));
+			if (dHandle.valid) {
+				DISK_PERFORMANCE diskperf;
+				DWORD retSize = 0;
+				DWORD getSize = sizeof(diskperf);
+				BOOL status;
+				for (int bx = 1; bx < 1024; bx++) {
+					status = DeviceIoControl(dHandle(), IOCTL_DISK_PERFORMANCE, nullptr, 0, &diskperf, getSize, &retSize, nullptr);
+
+					//* DeviceIoControl success
+					if (status != 0) {
+						drive.has_io = true;
+						drive.read = diskperf.BytesRead.QuadPart;
+						drive.written = diskperf.BytesWritten.QuadPart;
+						drive.io_time = diskperf.ReadTime.QuadPart + diskperf.WriteTime.QuadPart;
+					}
+
+					//! DeviceIoControl fail
+					else if (GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
+						getSize *= 2;
+						continue;
+					}
+					break;
+				}
+			}
+			drives.push_back(std::move(drive));
+		}
+		return true;
+	}
+
 	auto collect(const bool no_update) -> mem_info& {
 		if (Runner::stopping or (no_update and not current_mem.percent.at("used").empty())) return current_mem;
 		
@@ -1351,20 +1363,24 @@ namespace Mem {
 		auto& show_disks = Config::getB("show_disks");
 		auto& mem = current_mem;
 
+		//? Mark samples missed since last update as gaps in all graph histories
+		const size_t gaps = sample_timer.tick(Runner::interval("mem"), width * 2);
+		const uint64_t now = steady_ms();
+
 		if (Cpu::has_OHMR and Cpu::has_gpu and Config::getB("show_gpu")) {
-			std::lock_guard lck(Cpu::OHMRmutex);
+			const auto ohmr = Cpu::OHMRrawStats.load();
+			const auto& stats = *ohmr;
 			if (not Cpu::shown) {
-				Cpu::OHMR_trigger();
 				if (Cpu::current_gpu != Config::getS("selected_gpu")) {
 					Cpu::current_gpu = Config::getS("selected_gpu");
-					if (Cpu::current_gpu != "Auto" and not Cpu::OHMRrawStats.GPUS.contains(Cpu::current_gpu)) {
+					if (Cpu::current_gpu != "Auto" and not stats.GPUS.contains(Cpu::current_gpu)) {
 						Cpu::current_gpu = "Auto";
 						Config::set("selected_gpu", Cpu::current_gpu);
 					}
 					redraw = true;
 				}
 			}
-			const auto& gpu = Cpu::OHMRrawStats.GPUS.contains(Cpu::current_gpu) ? Cpu::OHMRrawStats.GPUS.at(Cpu::current_gpu) : Cpu::OHMRrawStats.GPUS.at(Config::available_gpus.at(1));
+			const auto& gpu = stats.GPUS.contains(Cpu::current_gpu) ? stats.GPUS.at(Cpu::current_gpu) : stats.GPUS.at(Config::available_gpus.at(1));
 			const uint64_t conf_gpu_total = (int64_t)Config::getI("gpu_mem_override") << 20;
 			if (conf_gpu_total > 0 and conf_gpu_total > gpu.mem_used) {
 				mem.stats.at("gpu_total") = conf_gpu_total;
@@ -1379,7 +1395,9 @@ namespace Mem {
 			mem.stats.at("gpu_free") = mem.stats.at("gpu_total") - mem.stats.at("gpu_used");
 			cpu_gpu = gpu.cpu_gpu;
 			for (const auto name : { "gpu_used", "gpu_free" }) {
+				push_gaps(mem.percent.at(name), gaps);
 				mem.percent.at(name).push_back(round((double)mem.stats.at(name) * 100 / mem.stats.at("gpu_total")));
+				mem.history[name].add(mem.percent.at(name).back(), now);
 				while (cmp_greater(mem.percent.at(name).size(), width * 2)) mem.percent.at(name).pop_front();
 			}
 		}
@@ -1412,14 +1430,18 @@ namespace Mem {
 
 		//? Calculate percentages
 		for (const string name : { "used", "available", "cached", "commit"}) {
+			push_gaps(mem.percent.at(name), gaps);
 			mem.percent.at(name).push_back(round((double)mem.stats.at(name) * 100 / (name == "commit" ? totalCommit : totalMem)));
+			mem.history[name].add(mem.percent.at(name).back(), now);
 			while (cmp_greater(mem.percent.at(name).size(), width * 2)) mem.percent.at(name).pop_front();
 		}
 		
 
 		if (show_swap and mem.stats.at("page_total") > 0) {
 			for (const auto name : {"page_used", "page_free"}) {
+				push_gaps(mem.percent.at(name), gaps);
 				mem.percent.at(name).push_back(round((double)mem.stats.at(name) * 100 / mem.stats.at("page_total")));
+				mem.history[name].add(mem.percent.at(name).back(), now);
 				while (cmp_greater(mem.percent.at(name).size(), width * 2)) mem.percent.at(name).pop_front();
 			}
 			has_swap = true;
@@ -1429,13 +1451,13 @@ namespace Mem {
 
 		//? Get disks stats
 		if (show_disks) {
-			uint64_t systime = GetTickCount64();
+			//? Disk IO is stored as bytes per second since the mem box can have its own update interval
+			uint64_t systime = steady_ms();
 			auto free_priv = Config::getB("disk_free_priv");
 			auto& disks_filter = Config::getS("disks_filter");
 			bool filter_exclude = false;
 			auto& only_physical = Config::getB("only_physical");
 			auto& disks = mem.disks;
-			disk_ios = 0;
 
 			vector<string> filter;
 			if (not disks_filter.empty()) {
@@ -1446,103 +1468,85 @@ namespace Mem {
 				}
 			}
 
-			//? Get bitmask containing drives in use
-			DWORD logical_drives = GetLogicalDrives();
-			if (logical_drives == 0) return mem;
-			
-			vector<string> found;
-			found.reserve(last_found.size());			
-			for (int i = 0; i < 26; i++) {
-				if (not (logical_drives & (1 << i))) continue;
-				string letter = string(1, 'A' + i) + ":\\";
-				
-				//? Get device type and continue loop if unknown or failed
-				UINT device_type = GetDriveTypeA(letter.c_str());
-				if (device_type < 2) continue;
-
-				//? Get name of drive
-				string name = "";
-				array<char, MAX_PATH + 1> ch_name;
-				if (GetVolumeInformationA(letter.c_str(), ch_name.data(), MAX_PATH + 1, 0, 0, 0, nullptr, 0))
-					name = string(ch_name.data());
-				
+			const auto wanted = [&](const drive_raw& drive) {
 				//? Match filter if not empty
 				if (not filter.empty()) {
-					bool match = v_contains(filter, letter) or (not name.empty() and v_contains(filter, name));
+					bool match = v_contains(filter, drive.letter) or (not drive.name.empty() and v_contains(filter, drive.name));
 					if ((filter_exclude and match) or (not filter_exclude and not match))
-						continue;
+						return false;
+				}
+				return (not only_physical or drive.type == DRIVE_FIXED or drive.type == DRIVE_REMOVABLE);
+			};
+
+			//? Use drives read by a collector daemon if attached, nothing to update if it hasn't read them again since last time
+			static vector<drive_raw> drives;
+			if (Share::read_drives(drives, systime)) {
+				if (systime == old_systime) return mem;
+			}
+			else if (not get_drives(drives, wanted)) return mem;
+			const int64_t elapsed_ms = max<int64_t>(1, systime - old_systime);
+			disk_ios = 0;
+
+			vector<string> found;
+			found.reserve(last_found.size());
+			for (const auto& drive : drives) {
+				if (not wanted(drive)) continue;
+				const string& letter = drive.letter;
+				found.push_back(letter);
+
+				if (not disks.contains(letter))
+					disks[letter] = { drive.name };
+				else
+					disks.at(letter).name = drive.name;
+
+				auto& disk = disks.at(letter);
+
+				//? Disk total size, free and used
+				if (drive.has_space) {
+					disk.total = drive.total;
+					disk.free = (free_priv ? drive.free_priv : drive.free);
+					disk.used = disk.total - disk.free;
+					disk.used_percent = round((double)disk.used * 100 / disk.total);
+					disk.free_percent = 100 - disk.used_percent;
 				}
 
-				if (not only_physical or (only_physical and (device_type == DRIVE_FIXED or device_type == DRIVE_REMOVABLE))) {
-					found.push_back(letter);
+				//? Disk IO
+				if (drive.has_io) {
+					disk_ios++;
 
-					if (not disks.contains(letter))
-						disks[letter] = { name };
-					else
-						disks.at(letter).name = name;
-
-					auto& disk = disks.at(letter);
-
-					//? Get disk total size, free and used
-					ULARGE_INTEGER freeBytesCaller, totalBytes, freeBytes;
-					if (GetDiskFreeSpaceExA(letter.c_str(), &freeBytesCaller, &totalBytes, &freeBytes)) {
-						disk.total = totalBytes.QuadPart;
-						disk.free = (free_priv ? freeBytes.QuadPart : freeBytesCaller.QuadPart);
-						disk.used = disk.total - disk.free;
-						disk.used_percent = round((double)disk.used * 100 / disk.total);
-						disk.free_percent = 100 - disk.used_percent;
+					//? Read
+					if (disk.io_read.empty())
+						disk.io_read.push_back(0);
+					else {
+						push_gaps(disk.io_read, gaps);
+						disk.io_read.push_back(max((int64_t)0, (drive.read - disk.old_io.at(0)) * 1000 / elapsed_ms));
 					}
+					disk.old_io.at(0) = drive.read;
+					while (cmp_greater(disk.io_read.size(), width * 2)) disk.io_read.pop_front();
 
-					//? Get disk IO
-					//! Based on the method used in psutil
-					//! see https://github.com/giampaolo/psutil/blob/master/psutil/arch/windows/disk.c
-					HandleWrapper dHandle(CreateFileW(_bstr_t(string("\\\\.\\" + letter.substr(0, 2)).c_str()), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr));
-					if (dHandle.valid) {
-						DISK_PERFORMANCE diskperf;
-						DWORD retSize = 0;
-						DWORD getSize = sizeof(diskperf);
-						BOOL status;
-						for (int bx = 1; bx < 1024; bx++) {
-							status = DeviceIoControl(dHandle(), IOCTL_DISK_PERFORMANCE, nullptr, 0, &diskperf, getSize, &retSize, nullptr);
-							
-							//* DeviceIoControl success
-							if (status != 0) {
-								disk_ios++;
-								
-								//? Read
-								if (disk.io_read.empty())
-									disk.io_read.push_back(0);
-								else
-									disk.io_read.push_back(max((int64_t)0, (diskperf.BytesRead.QuadPart - disk.old_io.at(0))));
-								disk.old_io.at(0) = diskperf.BytesRead.QuadPart;
-								while (cmp_greater(disk.io_read.size(), width * 2)) disk.io_read.pop_front();
-
-								//? Write
-								if (disk.io_write.empty())
-									disk.io_write.push_back(0);
-								else
-									disk.io_write.push_back(max((int64_t)0, (diskperf.BytesWritten.QuadPart - disk.old_io.at(1))));
-								disk.old_io.at(1) = diskperf.BytesWritten.QuadPart;
-								while (cmp_greater(disk.io_write.size(), width * 2)) disk.io_write.pop_front();
-
-								//? IO%
-								int64_t io_time = diskperf.ReadTime.QuadPart + diskperf.WriteTime.QuadPart;
-								if (disk.io_activity.empty())
-									disk.io_activity.push_back(0);
-								else
-									disk.io_activity.push_back(clamp((long)round((double)(io_time - disk.old_io.at(2)) / 1000 / (systime - old_systime)), 0l, 100l));
-								disk.old_io.at(2) = io_time;
-								while (cmp_greater(disk.io_activity.size(), width * 2)) disk.io_activity.pop_front();
-							}
-							
-							//! DeviceIoControl fail
-							else if (GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
-								getSize *= 2;
-								continue;
-							}
-							break;
-						}
+					//? Write
+					if (disk.io_write.empty())
+						disk.io_write.push_back(0);
+					else {
+						push_gaps(disk.io_write, gaps);
+						disk.io_write.push_back(max((int64_t)0, (drive.written - disk.old_io.at(1)) * 1000 / elapsed_ms));
+					}
+					disk.old_io.at(1) = drive.written;
+					while (cmp_greater(disk.io_write.size(), width * 2)) disk.io_write.pop_front();
+
+					//? IO%
+					if (disk.io_activity.empty())
+						disk.io_activity.push_back(0);
+					else {
+						push_gaps(disk.io_activity, gaps);
+						disk.io_activity.push_back(clamp((long)round((double)(drive.io_time - disk.old_io.at(2)) / 1000 / elapsed_ms), 0l, 100l));
 					}
+					disk.old_io.at(2) = drive.io_time;
+					while (cmp_greater(disk.io_activity.size(), width * 2)) disk.io_activity.pop_front();
+
+					disk.history["read"].add(disk.io_read.back(), now);
+					disk.history["write"].add(disk.io_write.back(), now);
+					disk.history["activity"].add(disk.io_activity.back(), now);
 				}
 			}
 			old_systime = systime;
@@ -1577,7 +1581,7 @@ namespace Net {
 	unordered_flat_map<string, uint64_t> graph_max = { {"download", {}}, {"upload", {}} };
 	unordered_flat_map<string, array<int, 2>> max_count = { {"download", {}}, {"upload", {}} };
 	bool rescale = true;
-	uint64_t timestamp = 0;
+	SampleTimer sample_timer;
 
 	auto collect(const bool no_update) -> net_info& {
 		auto& net = current_net;
@@ -1585,11 +1589,16 @@ namespace Net {
 		auto& config_iface = Config::getS("net_iface");
 		auto& net_sync = Config::getB("net_sync");
 		auto& net_auto = Config::getB("net_auto");
-		auto new_timestamp = time_ms();
+		auto& adaptive = Config::getB("adaptive_sampling");
 
 		//! Much of the following code is based on the implementation used in psutil
 		//! See: https://github.com/giampaolo/psutil/blob/master/psutil/arch/windows/net.c
 		if (not no_update) {
+			//? Speeds are calculated over the time since last update, samples missed in between are marked as gaps in the graphs
+			const size_t gaps = sample_timer.tick(Runner::interval("net"), width * 2);
+			const uint64_t elapsed_ms = sample_timer.elapsed;
+			const uint64_t now = steady_ms();
+
 			//? Get list of adapters
 			ULONG bufSize = 0;
 			if (GetAdaptersAddresses(AF_UNSPEC, 0, nullptr, nullptr, &bufSize) != ERROR_BUFFER_OVERFLOW) {
@@ -1603,11 +1612,30 @@ namespace Net {
 
 			interfaces.clear();
 
+			//? With adaptive sampling only the shown interface is updated, all of them are while a new one is picked by total bytes
+			bool only_selected = false;
+			if (adaptive and not selected_iface.empty()) {
+				for (auto a = adapters.get(); a != nullptr and not only_selected; a = a->Next)
+					only_selected = (bstr2str(a->FriendlyName) == selected_iface);
+			}
+
 			//? Iterate through list of adapters
 			for (auto a = adapters.get(); a != nullptr; a = a->Next) {
 				string iface = bstr2str(a->FriendlyName);
 				interfaces.push_back(iface);
-				net[iface].connected = (a->OperStatus == IfOperStatusUp);
+				auto& info = net[iface];
+				info.connected = (a->OperStatus == IfOperStatusUp);
+
+				//? Skipped interfaces show no speed and restart their stats when collected again
+				if (only_selected and iface != selected_iface) {
+					if (not info.stale) {
+						info.stale = true;
+						for (auto& [dir, stat] : info.stat) stat.speed = 0;
+					}
+					continue;
+				}
+				const bool was_stale = info.stale;
+				info.stale = false;
 			
 				//? Get IP adresses associated with adapter
 				bool ip4 = false, ip6 = false;
@@ -1640,7 +1668,7 @@ namespace Net {
 				if (GetIfEntry2(&ifEntry) != NO_ERROR) {
 					if (not v_contains(failed, iface)) {
 						failed.push_back(iface);
-						Logger::debug("Failed to get IO stats for network adapter: " + iface);
+						Logger::debug("Failed to get IO stats for network adapter: ", iface);
 					}
 					continue;
 				}
@@ -1651,6 +1679,13 @@ namespace Net {
 
 					uint64_t val = (dir == "download" ? ifEntry.InOctets : ifEntry.OutOctets);
 
+					//? Counters weren't followed while stale, restart the baseline and drop history that has a hole in it
+					if (was_stale) {
+						saved_stat = {.last = val, .offset = saved_stat.offset};
+						bandwidth.clear();
+						net.at(iface).history[dir] = {};
+					}
+
 					//? Update speed, total and top values
 					if (val < saved_stat.last) {
 						saved_stat.rollover += saved_stat.last;
@@ -1660,14 +1695,16 @@ namespace Net {
 						saved_stat.rollover = 0;
 						saved_stat.last = 0;
 					}
-					saved_stat.speed = round((double)(val - saved_stat.last) / ((double)(new_timestamp - timestamp) / 1000));
+					saved_stat.speed = (elapsed_ms > 0 ? round((double)(val - saved_stat.last) * 1000 / elapsed_ms) : 0);
 					if (saved_stat.speed > saved_stat.top) saved_stat.top = saved_stat.speed;
 					if (saved_stat.offset > val + saved_stat.rollover) saved_stat.offset = 0;
 					saved_stat.total = (val + saved_stat.rollover) - saved_stat.offset;
 					saved_stat.last = val;
 
 					//? Add values to graph
+					push_gaps(bandwidth, gaps);
 					bandwidth.push_back(saved_stat.speed);
+					net.at(iface).history[dir].add(saved_stat.speed, now);
 					while (cmp_greater(bandwidth.size(), width * 2)) bandwidth.pop_front();
 
 					//? Set counters for auto scaling
@@ -1683,8 +1720,6 @@ namespace Net {
 					}
 				}
 			}
-			
-			timestamp = new_timestamp;
 
 			//? Clean up net map if needed
 			if (net.size() > interfaces.size()) {
@@ -1735,9 +1770,15 @@ namespace Net {
 					continue;
 				for (const auto& sel : {0, 1}) {
 					if (rescale or max_count[dir][sel] >= 5) {
-						const uint64_t avg_speed = (net[selected_iface].bandwidth[dir].size() > 5
-							? std::accumulate(net.at(selected_iface).bandwidth.at(dir).rbegin(), net.at(selected_iface).bandwidth.at(dir).rbegin() + 5, 0) / 5
-							: net[selected_iface].stat[dir].speed);
+						//? Average of the last 5 samples, not counting missed samples
+						uint64_t avg_speed = net[selected_iface].stat[dir].speed;
+						if (const auto& bandwidth = net.at(selected_iface).bandwidth.at(dir); bandwidth.size() > 5) {
+							long long sum = 0, count = 0;
+							for (auto it = bandwidth.rbegin(); it != bandwidth.rbegin() + 5; ++it) {
+								if (*it != graph_gap) { sum += *it; count++; }
+							}
+							if (count > 0) avg_speed = sum / count;
+						}
 						graph_max[dir] = max(uint64_t(avg_speed * (sel == 0 ? 1.3 : 3.0)), (uint64_t)10 << 10);
 						max_count[dir][0] = max_count[dir][1] = 0;
 						redraw = true;
@@ -1780,12 +1821,18 @@ namespace Proc {
 
 	detail_container detailed;
 
+	//? Account names of process owners, resolved in the background since LookupAccountSid() can block on domain joined hosts
+	Accounts::Cache accounts(std::make_unique<Shared::SidResolver>());
+
+	//? SIDs of processes shown with Accounts::placeholder as user until the account name is resolved
+	unordered_flat_map<size_t, string> pending_users;
+
 	struct tree_proc {
 		std::reference_wrapper<proc_info> entry;
 		vector<tree_proc> children;
 	};
 
-	void proc_sorter(vector<proc_info>& proc_vec, string sorting, const bool reverse, const bool tree = false, const bool services = false) {
+	void proc_sorter(vector<proc_info>& proc_vec, string sorting, const bool reverse, const bool tree, const bool services) {
 		if (services) {
 			if (sorting == "service") sorting = "program";
 			else if (sorting == "caption") sorting = "command";
@@ -1892,8 +1939,8 @@ namespace Proc {
 			cur_proc.tree_index = out_procs.size() - 1;
 			
 			//? Try to find name of the binary file and append to program name if not the same
-			if (cur_proc.short_cmd.empty() and WMIList.contains(cur_proc.pid)) {
-				string pname = bstr2str(WMIList.at(cur_proc.pid).Name);
+			if (cur_proc.short_cmd.empty() and wmi_procs->contains(cur_proc.pid)) {
+				string pname = wmi_procs->at(cur_proc.pid).info->Name;
 				if (pname.size() < cur_proc.cmd.size()) {
 					std::string_view cmd = cur_proc.cmd;
 					auto ssfind = cmd.find(pname);
@@ -1958,19 +2005,19 @@ namespace Proc {
 			last_status = detailed.status;
 		}
 
-		if (services and WMISvcList.contains(name)) {
-			const auto& svc = WMISvcList.at(name);
-			detailed.status = bstr2str(svc.State);
+		if (services and wmi_svcs->contains(name)) {
+			const auto& svc = wmi_svcs->at(name);
+			detailed.status = svc.State;
 			if (detailed.status != last_status) {
 				last_status = detailed.status;
 				redraw = true;
 			}
-			detailed.owner = bstr2str(svc.Owner);
-			detailed.start = bstr2str(svc.StartMode);
-			detailed.description = bstr2str(svc.Description);
+			detailed.owner = svc.Owner;
+			detailed.start = svc.StartMode;
+			detailed.description = svc.info->Description;
 			detailed.can_pause = svc.AcceptPause;
 			detailed.can_stop = svc.AcceptStop;
-			detailed.service_type = bstr2str(svc.ServiceType);
+			detailed.service_type = svc.info->ServiceType;
 		}
 
 		if (is_in(detailed.status, "Running", "Paused")) {
@@ -2005,10 +2052,10 @@ namespace Proc {
 			while (cmp_greater(detailed.mem_bytes.size(), width)) detailed.mem_bytes.pop_front();
 
 			//? Get bytes read and written
-			if (WMIList.contains(pid)) {
-				detailed.io_read = floating_humanizer(_wtoi64(WMIList.at(pid).ReadTransferCount));
-				detailed.io_write = floating_humanizer(_wtoi64(WMIList.at(pid).WriteTransferCount));
-				Proc::WMI_requests.push_back(pid);
+			if (wmi_procs->contains(pid)) {
+				detailed.io_read = floating_humanizer(wmi_procs->at(pid).ReadTransferCount);
+				detailed.io_write = floating_humanizer(wmi_procs->at(pid).WriteTransferCount);
+				new_requests.push_back(pid);
 			}
 
 			//? Get parent process name
@@ -2049,12 +2096,16 @@ namespace Proc {
 		FILETIME st;
 		::GetSystemTimeAsFileTime(&st);
 		const uint64_t systime = ULARGE_INTEGER{ st.dwLowDateTime, st.dwHighDateTime }.QuadPart;
-		std::lock_guard<std::mutex> lck(WMImutex);
+
+		//? Pin the latest WMI snapshots for this pass, the WMI thread can keep publishing without waiting for us
+		wmi_procs = WMIList.load();
+		wmi_svcs = WMISvcList.load();
 
 		const int cmult = (per_core) ? Shared::coreCount : 1;
 		bool got_detailed = false;
 
 		static vector<size_t> found;
+		static vector<Share::proc_raw> shared_procs;
 
 		//* Use pids from last update if only changing filter, sorting or tree options
 		if (no_update and not current_procs.empty()) {
@@ -2062,6 +2113,59 @@ namespace Proc {
 				_collect_details(detailed_pid, detailed_name, systime, (services ? current_svcs : current_procs), Mem::get_totalMem());
 			}
 		}
+		//* Use processes collected by a daemon if attached, cpu usage is calculated from the raw cpu times the same way as below
+		else if (Share::read_procs(shared_procs, cputimes)) {
+			should_filter = true;
+			totalMem = Mem::get_totalMem();
+
+			//? Cpu usage is kept from the last update if the daemon hasn't published a new frame since
+			const bool new_frame = (cputimes != old_cputimes);
+			found.clear();
+			for (auto& raw : shared_procs) {
+				found.push_back(raw.pid);
+
+				auto find_old = rng::find(current_procs, raw.pid, &proc_info::pid);
+				if (find_old == current_procs.end()) {
+					current_procs.push_back({raw.pid});
+					find_old = current_procs.end() - 1;
+				}
+
+				auto& new_proc = *find_old;
+				new_proc.name.swap(raw.name);
+				new_proc.cmd.swap(raw.cmd);
+				new_proc.user.swap(raw.user);
+				new_proc.ppid = raw.ppid;
+				new_proc.threads = raw.threads;
+				new_proc.mem = raw.mem;
+				new_proc.cpu_s = raw.cpu_s;
+
+				if (new_frame and raw.cpu_t != 0) {
+					if (new_proc.cpu_t == 0) new_proc.cpu_t = raw.cpu_t;
+					new_proc.cpu_p = clamp(round(cmult * 100 * (raw.cpu_t - new_proc.cpu_t) / max((uint64_t)1, cputimes - old_cputimes)) / 10.0, 0.0, 100.0 * Shared::coreCount);
+					new_proc.cpu_c = (double)raw.cpu_t / max(1ull, systime - new_proc.cpu_s);
+					new_proc.cpu_t = raw.cpu_t;
+				}
+
+				if (show_detailed and not got_detailed and new_proc.pid == detailed_pid) {
+					got_detailed = true;
+				}
+			}
+
+			//? Clear dead processes from current_procs
+			auto eraser = rng::remove_if(current_procs, [&](const auto& element){ return not v_contains(found, element.pid); });
+			current_procs.erase(eraser.begin(), eraser.end());
+
+			//? Update the details info box for process if active
+			if (not services and show_detailed and got_detailed) {
+				_collect_details(detailed_pid, detailed_name, systime, current_procs, totalMem);
+			}
+			else if (show_detailed and not got_detailed and detailed.status != "Stopped") {
+				detailed.status = "Stopped";
+				redraw = true;
+			}
+
+			old_cputimes = cputimes;
+		}
 		//* ---------------------------------------------Collection start----------------------------------------------
 		else {
 			should_filter = true;
@@ -2096,14 +2200,14 @@ namespace Proc {
 
 			do {
 				if (Runner::stopping) {
-					if (not Proc::WMI_requests.empty()) Proc::WMI_trigger();
+					flush_WMI_requests();
 					return current_procs;
 				}
 
 				const size_t pid = pe.th32ProcessID;
 				if (pid == 0) continue;
 				HandleWrapper pHandle(OpenProcess(PROCESS_QUERY_INFORMATION, FALSE, pe.th32ProcessID));
-				const bool hasWMI = WMIList.contains(pid);
+				const bool hasWMI = wmi_procs->contains(pid);
 				bool wmi_request = (not hasWMI and not Proc::WMI_running);
 				
 				found.push_back(pid);
@@ -2125,11 +2229,12 @@ namespace Proc {
 					new_proc.ppid = pe.th32ParentProcessID;
 
 					if (hasWMI) {
-						if (new_proc.name.empty()) new_proc.name = bstr2str(WMIList.at(pid).Name);
-						if (new_proc.ppid == 0) new_proc.ppid = WMIList.at(pid).ParentProcessId;
-						new_proc.cmd = bstr2str(WMIList.at(pid).CommandLine);
+						const auto& info = *wmi_procs->at(pid).info;
+						if (new_proc.name.empty()) new_proc.name = info.Name;
+						if (new_proc.ppid == 0) new_proc.ppid = info.ParentProcessId;
+						new_proc.cmd = info.CommandLine;
 						if (new_proc.cmd.empty())
-							new_proc.cmd = bstr2str(WMIList.at(pid).ExecutablePath);
+							new_proc.cmd = info.ExecutablePath;
 					}
 					if (new_proc.cmd.empty()) new_proc.cmd = new_proc.name;
 
@@ -2143,14 +2248,11 @@ namespace Proc {
 							if (dwLength > 0) {
 								std::unique_ptr<BYTE[]> ptu(new BYTE[dwLength]);
 								if (ptu != nullptr and GetTokenInformation(pToken.wHandle, TokenUser, ptu.get(), dwLength, &dwLength)) {
-									SID_NAME_USE SidType;
-									wchar_t lpName[260];
-									wchar_t lpDomain[260];
-									DWORD dwSize = 260;
-									if (LookupAccountSid(0, ((PTOKEN_USER)ptu.get())->User.Sid, lpName, &dwSize, lpDomain, &dwSize, &SidType)) {
-										new_proc.user = bstr2str(lpName);
-										if (new_proc.user.empty())
-											new_proc.user = bstr2str(lpDomain);
+									const PSID psid = ((PTOKEN_USER)ptu.get())->User.Sid;
+									string sid((const char*)psid, GetLengthSid(psid));
+									if (accounts.get(sid, new_proc.user) == Accounts::status::pending) {
+										new_proc.user = Accounts::placeholder;
+										pending_users[pid] = std::move(sid);
 									}
 								}
 							}
@@ -2160,10 +2262,20 @@ namespace Proc {
 					new_proc.WMI = hasWMI;
 				}
 
+				//? Check if the account name was resolved since last update, falls back to parent process username below if failed
+				if (not no_cache and new_proc.user == Accounts::placeholder) {
+					if (auto pending = pending_users.find(pid); pending == pending_users.end())
+						new_proc.user.clear();
+					else if (auto st = accounts.get(pending->second, new_proc.user); st != Accounts::status::pending) {
+						if (st == Accounts::status::failed) new_proc.user.clear();
+						pending_users.erase(pending);
+					}
+				}
+
 				//? Use parent process username if empty
 				if (not no_cache and new_proc.user.empty()) {
 					if (new_proc.ppid != 0) {
-						if (auto parent = rng::find(current_procs, new_proc.ppid, &proc_info::pid); parent != current_procs.end()) {
+						if (auto parent = rng::find(current_procs, new_proc.ppid, &proc_info::pid); parent != current_procs.end() and parent->user != Accounts::placeholder) {
 							new_proc.user = parent->user;
 						}
 					}
@@ -2191,7 +2303,7 @@ namespace Proc {
 
 				//? Process memory fallback to background WMI thread
 				if (new_proc.mem == 0 and hasWMI) {
-					new_proc.mem = _wtoi64(WMIList.at(pid).PrivateMemory);
+					new_proc.mem = wmi_procs->at(pid).PrivateMemory;
 					wmi_request = true;
 				}
 
@@ -2200,7 +2312,7 @@ namespace Proc {
 
 					//? Convert process creation CIM_DATETIME to FILETIME, (less accurate than GetProcessTimes() due to loss of microsecond count)
 					if (new_proc.cpu_s == 0) {
-						const string strdate = bstr2str(WMIList.at(pid).CreationDate);
+						const string& strdate = wmi_procs->at(pid).info->CreationDate;
 						if (strdate.size() > 18) {
 							SYSTEMTIME t = { 0 };
 							t.wYear = stoi(strdate.substr(0, 4));
@@ -2217,7 +2329,7 @@ namespace Proc {
 					}
 
 					//? Process cpu times
-					cpu_t = _wtoi64(WMIList.at(pid).KernelModeTime) + _wtoi64(WMIList.at(pid).UserModeTime);
+					cpu_t = wmi_procs->at(pid).KernelModeTime + wmi_procs->at(pid).UserModeTime;
 
 					wmi_request = true;
 				}
@@ -2239,7 +2351,7 @@ namespace Proc {
 					got_detailed = true;
 				}
 
-				if (wmi_request) Proc::WMI_requests.push_back(pid);
+				if (wmi_request) new_requests.push_back(pid);
 
 			} while (Process32Next(pSnap(), &pe));
 
@@ -2247,6 +2359,13 @@ namespace Proc {
 			auto eraser = rng::remove_if(current_procs, [&](const auto& element){ return not v_contains(found, element.pid); });
 			current_procs.erase(eraser.begin(), eraser.end());
 
+			for (auto it = pending_users.begin(); it != pending_users.end();) {
+				if (not v_contains(found, it->first))
+					it = pending_users.erase(it);
+				else
+					it++;
+			}
+
 			//? Update the details info box for process if active
 			if (not services and show_detailed and got_detailed) {
 				_collect_details(detailed_pid, detailed_name, systime, current_procs, totalMem);
@@ -2262,7 +2381,7 @@ namespace Proc {
 		//* Collect info for services using WMI if currently enabled
 		if (services and not no_update) {
 			bool got_detailed = false;
-			for (const auto& [name, svc] : WMISvcList) {
+			for (const auto& [name, svc] : *wmi_svcs) {
 				
 				//? Check if pid already exists in current_svcs
 				auto find_old = rng::find(current_svcs, name, &proc_info::name);
@@ -2279,8 +2398,8 @@ namespace Proc {
 
 				new_svc.name = name;
 				new_svc.pid = svc.ProcessID;
-				new_svc.cmd = bstr2str(svc.Caption);
-				new_svc.user = bstr2str(svc.State);
+				new_svc.cmd = svc.info->Caption;
+				new_svc.user = svc.State;
 				if (tree) new_svc.short_cmd = new_svc.cmd;
 
 				//? Find pid entry in current_procs
@@ -2311,7 +2430,7 @@ namespace Proc {
 			}
 
 			//? Clear missing services from current_svcs
-			auto eraser = rng::remove_if(current_svcs, [&](const auto& element) { return not WMISvcList.contains(element.name); });
+			auto eraser = rng::remove_if(current_svcs, [&](const auto& element) { return not wmi_svcs->contains(element.name); });
 			current_svcs.erase(eraser.begin(), eraser.end());
 		}
 
@@ -2407,7 +2526,7 @@ namespace Proc {
 		}
 
 		numpids = (int)out_vec.size() - filter_found;
-		if (not Proc::WMI_requests.empty()) Proc::WMI_trigger();
+		flush_WMI_requests();
 		return out_vec;
 	}
 }
@@ -88,6 +88,23 @@ namespace Config {
 
 		{"update_ms", 			"#* Update time in milliseconds, recommended 2000 ms or above for better sample times for graphs."},
 
+		{"update_ms_cpu", 		"#* Separate update times in milliseconds for each box, 0 to use update_ms. For example a low value for the cpu box\n"
+								"#* gives smoother cpu graphs without running the more expensive process scan as often."},
+
+		{"update_ms_mem", 		""},
+
+		{"update_ms_net", 		""},
+
+		{"update_ms_proc", 		""},
+
+		{"cpu_sample_ms", 		"#* Sample cpu usage every cpu_sample_ms milliseconds between updates, 0 to disable. The peak of the samples is shown\n"
+								"#* in the core graphs and as cpu graph \"max\", to catch short bursts that average out over a longer update time."},
+
+		{"adaptive_sampling", 	"#* Adapt update times to system activity. The process list is updated less often while the top processes and total\n"
+								"#* cpu usage are stable, cpu and process updates run at double rate for a while when usage crosses adaptive_threshold."},
+
+		{"adaptive_threshold", 	"#* Cpu usage in percent of total cpu or of the selected process that triggers faster updates with adaptive_sampling."},
+
 		{"proc_sorting",		"#* Processes sorting, \"pid\" \"program\" \"arguments\" \"threads\" \"user\" \"memory\" \"cpu lazy\" \"cpu direct\",\n"
 								"#* \"cpu lazy\" sorts top process over time (easier to follow), \"cpu direct\" updates top process directly."},
 		
@@ -110,6 +127,14 @@ namespace Config {
 
 		{"proc_left",			"#* Show proc box on left side of screen instead of right."},
 
+		{"flight_recorder_mb",	"#* Memory in MiB for recording process lists, step back and forward through them with \"<\" and \">\", 0 to disable."},
+
+		{"record_segment_mb",	"#* Size in MiB of each file written when recording with argument \"--record\", a new file is started when full."},
+
+		{"record_max_mb",		"#* Total size in MiB of recording files to keep, oldest files are removed when exceeded, 0 to keep all."},
+
+		{"metrics_port",		"#* Serve the latest collected data in Prometheus text format at http://127.0.0.1:<port>/metrics, 0 to disable."},
+
 		{"cpu_graph_upper", 	"#* Sets the CPU stat shown in upper half of the CPU graph, \"total\" is always available.\n"
 								"#* Select from a list of detected attributes from the options menu."},
 
@@ -215,6 +240,7 @@ namespace Config {
 		{"truecolor", true},
 		{"rounded_corners", false},
 		{"proc_services", false},
+		{"adaptive_sampling", false},
 		{"proc_reversed", false},
 		{"proc_tree", false},
 		{"proc_colors", true},
@@ -255,6 +281,16 @@ namespace Config {
 
 	unordered_flat_map<string, int> ints = {
 		{"update_ms", 1500},
+		{"update_ms_cpu", 0},
+		{"update_ms_mem", 0},
+		{"update_ms_net", 0},
+		{"update_ms_proc", 0},
+		{"adaptive_threshold", 80},
+		{"cpu_sample_ms", 0},
+		{"flight_recorder_mb", 32},
+		{"record_segment_mb", 64},
+		{"record_max_mb", 1024},
+		{"metrics_port", 0},
 		{"net_download", 100},
 		{"net_upload", 100},
 		{"detailed_pid", 0},
@@ -378,6 +414,30 @@ namespace Config {
 		else if (name == "update_ms" and i_value > 86400000)
 			validError = "Config value update_ms set too high (>86400000).";
 
+		else if (name.starts_with("update_ms_") and i_value != 0 and i_value < 100)
+			validError = "Config value " + name + " set too low (<100), use 0 to follow update_ms.";
+
+		else if (name.starts_with("update_ms_") and i_value > 86400000)
+			validError = "Config value " + name + " set too high (>86400000).";
+
+		else if (name == "cpu_sample_ms" and i_value != 0 and (i_value < 10 or i_value > 1000))
+			validError = "Config value cpu_sample_ms out of range (10-1000), use 0 to disable.";
+
+		else if (name == "flight_recorder_mb" and (i_value < 0 or i_value > 4096))
+			validError = "Config value flight_recorder_mb out of range (0-4096).";
+
+		else if (name == "record_segment_mb" and (i_value < 1 or i_value > 4096))
+			validError = "Config value record_segment_mb out of range (1-4096).";
+
+		else if (name == "record_max_mb" and i_value < 0)
+			validError = "Config value record_max_mb can't be negative.";
+
+		else if (name == "metrics_port" and (i_value < 0 or i_value > 65535))
+			validError = "Config value metrics_port out of range (0-65535).";
+
+		else if (name == "adaptive_threshold" and (i_value < 1 or i_value > 100))
+			validError = "Config value adaptive_threshold out of range (1-100).";
+
 		else
 			return true;
 
@@ -30,12 +30,15 @@ tab-size = 4
 #include <btop_tools.hpp>
 #include <btop_input.hpp>
 #include <btop_menu.hpp>
+#include <btop_record.hpp>
+#include <btop_remote.hpp>
 
 
 using 	std::round, std::views::iota, std::string_literals::operator""s, std::clamp, std::array, std::floor, std::max, std::min,
 		std::to_string, std::cmp_equal, std::cmp_less, std::cmp_greater, std::cmp_less_equal;
 
 using namespace Tools;
+using Draw::zoom, Draw::zoom_names, Draw::zoom_data, Draw::zoom_same;
 namespace rng = std::ranges;
 
 namespace Symbols {
@@ -280,11 +283,12 @@ namespace Draw {
 		static size_t clock_len = 0;
 		static string clock_str;
 
-		if (auto n_time = time_ms() / 1000; not force and n_time == c_time)
+		//? Show time of the replay position when replaying a recording
+		if (auto n_time = (Record::Replay::active ? Record::Replay::position() : time_ms()) / 1000; not force and n_time == c_time)
 			return false;
 		else {
 			c_time = n_time;
-			const auto new_clock = Tools::strf_time(clock_format);
+			const auto new_clock = Tools::strf_time(clock_format, (Record::Replay::active ? (time_t)n_time : 0));
 			if (not force and new_clock == clock_str) return false;
 			clock_str = new_clock;
 		}
@@ -359,7 +363,7 @@ namespace Draw {
 		long long data_value = 0;
 		if (mult and data_offset > 0) {
 			last = data.at(data_offset - 1);
-			if (max_value > 0) last = clamp((last + offset) * 100 / max_value, 0ll, 100ll);
+			if (max_value > 0 and last != graph_gap) last = clamp((last + offset) * 100 / max_value, 0ll, 100ll);
 		}
 
 		//? Horizontal iteration over values in <data>
@@ -372,7 +376,7 @@ namespace Draw {
 			}
 			else {
 				data_value = data.at(i);
-				if (max_value > 0) data_value = clamp((data_value + offset) * 100 / max_value, 0ll, 100ll);
+				if (max_value > 0 and data_value != graph_gap) data_value = clamp((data_value + offset) * 100 / max_value, 0ll, 100ll);
 			}
 
 			//? Vertical iteration over height of graph
@@ -381,7 +385,7 @@ namespace Draw {
 				const int cur_low = (height > 1) ? round(100.0 * (height - (horizon + 1)) / height) : 0;
 				//? Calculate previous + current value to fit two values in 1 braille character
 				for (int ai = 0; const auto& value : {last, data_value}) {
-					const int clamp_min = (no_zero and horizon == height - 1 and not (mult and i == data_offset and ai == 0)) ? 1 : 0;
+					const int clamp_min = (no_zero and value != graph_gap and horizon == height - 1 and not (mult and i == data_offset and ai == 0)) ? 1 : 0;
 					if (value >= cur_high)
 						result[ai++] = 4;
 					else if (value <= cur_low)
@@ -422,6 +426,33 @@ namespace Draw {
 
 	Graph::Graph() {}
 
+	atomic<int> zoom (0);
+	const array<string, 4> zoom_names = {"", "10s", "1m", "10m"};
+
+	const deque<long long>& zoom_data(const deque<long long>& raw, const Shared::History* history, const bool peak) {
+		static const deque<long long> empty;
+		if (zoom == 0) return raw;
+		if (history == nullptr) return empty;
+		const auto& level = history->levels.at(zoom - 1);
+		return (peak ? level.max : level.avg);
+	}
+
+	const deque<long long>& zoom_data(const deque<long long>& raw, const unordered_flat_map<string, Shared::History>& history, const string& name) {
+		const auto it = history.find(name);
+		//? Peak values keep their peaks when zoomed out
+		return zoom_data(raw, (it == history.end() ? nullptr : &it->second), name == "max");
+	}
+
+	bool zoom_same(const Shared::History* history) {
+		if (zoom == 0) return false;
+		return (history == nullptr or not history->levels.at(zoom - 1).updated);
+	}
+
+	bool zoom_same(const unordered_flat_map<string, Shared::History>& history, const string& name) {
+		const auto it = history.find(name);
+		return zoom_same(it == history.end() ? nullptr : &it->second);
+	}
+
 	Graph::Graph(int width, int height, const string& color_gradient, const deque<long long>& data, const string& symbol, bool invert, bool no_zero, long long max_value, long long offset)
 	: width(width), height(height), color_gradient(color_gradient), invert(invert), no_zero(no_zero), offset(offset) {
 		if (Config::getB("tty_mode") or symbol == "tty") this->symbol = "tty";
@@ -450,6 +481,12 @@ namespace Draw {
 	string& Graph::operator()(const deque<long long>& data, const bool data_same) {
 		if (data_same) return out;
 
+		//? Missed samples were added before the new value, recreate the graph to place them on the grid
+		if (data.size() >= 2 and data.at(data.size() - 2) == graph_gap) {
+			*this = Graph(width, height, color_gradient, data, symbol, invert, no_zero, max_value, offset);
+			return out;
+		}
+
 		//? Make room for new characters on graph
 		if (not tty_mode) current = not current;
 		for (const int& i : iota(0, height)) {
@@ -487,6 +524,12 @@ namespace Cpu {
 	Draw::Graph gpu_temp;
 	vector<Draw::Graph> core_graphs;
 	vector<Draw::Graph> temp_graphs;
+	string old_rates;
+
+	//? Replayed and remote data has no per core history
+	const Shared::History* core_history(const cpu_info& cpu, const size_t n) {
+		return (n < cpu.core_history.size() ? &cpu.core_history.at(n) : nullptr);
+	}
 
 	string draw(const cpu_info& cpu, const bool force_redraw, const bool data_same) {
 		if (Runner::stopping) return "";
@@ -531,13 +574,13 @@ namespace Cpu {
 			Input::mouse_mappings["+"] = {button_y, x + width - 5, 1, 2};
 
 			//? Graphs & meters
-			graph_upper = Draw::Graph{x + width - b_width - 3, graph_up_height, "cpu", cpu.cpu_percent.at(graph_up_field), graph_symbol, false, true};
+			graph_upper = Draw::Graph{x + width - b_width - 3, graph_up_height, "cpu", zoom_data(cpu.cpu_percent.at(graph_up_field), cpu.history, graph_up_field), graph_symbol, false, true};
 			cpu_meter = Draw::Meter{b_width - (show_temps ? 23 - (b_column_size <= 1 and b_columns == 1 ? 6 : 0) : 11), "cpu"};
 			if (show_gpu) {
 				gpu_meter = Draw::Meter{ b_width - 23 - (b_column_size <= 1 and b_columns == 1 ? 6 : 0), "cpu" };
 			}
 			if (not single_graph)
-				graph_lower = Draw::Graph{x + width - b_width - 3, graph_low_height, "cpu", cpu.cpu_percent.at(graph_lo_field), graph_symbol, Config::getB("cpu_invert_lower"), true};
+				graph_lower = Draw::Graph{x + width - b_width - 3, graph_low_height, "cpu", zoom_data(cpu.cpu_percent.at(graph_lo_field), cpu.history, graph_lo_field), graph_symbol, Config::getB("cpu_invert_lower"), true};
 			if (mid_line) {
 				auto upper_text = (graph_up_field == "total" and graph_lo_field == "gpu" ? "cpu"s : graph_up_field);
 				out += Mv::to(y + graph_up_height + 1, x) + Fx::ub + Theme::c("cpu_box") + Symbols::div_left + Theme::c("div_line")
@@ -547,8 +590,8 @@ namespace Cpu {
 			}
 			if (b_column_size > 0 or extra_width > 0) {
 				core_graphs.clear();
-				for (const auto& core_data : cpu.core_percent) {
-					core_graphs.emplace_back(5 * b_column_size + extra_width, 1, "cpu", core_data, graph_symbol);
+				for (size_t n = 0; n < cpu.core_max.size(); n++) {
+					core_graphs.emplace_back(5 * b_column_size + extra_width, 1, "cpu", zoom_data(cpu.core_max.at(n), core_history(cpu, n), true), graph_symbol);
 				}
 			}
 			if (show_temps) {
@@ -608,11 +651,48 @@ namespace Cpu {
 			bat_pos = bat_len = 0;
 		}
 
+		//? Graph zoom level and effective cpu and proc update times when adaptive sampling is enabled, shown on the border opposite of the buttons
+		const int rates_y = (cpu_bottom ? y : y + height - 1);
+		string rates;
+		if (zoom > 0) rates = "zoom " + zoom_names.at(zoom);
+		if (Record::Replay::active) {
+			//? Replay state and a timeline, clicking the timeline seeks to that point of the recording
+			const uint64_t first = Record::Replay::first(), last = Record::Replay::last(), position = Record::Replay::position();
+			const string state = (Record::Replay::paused ? "paused " : "replay ") + to_string(Record::Replay::speed) + "x ";
+			const int bar_len = width - 42 - (int)state.size();
+			rates = state;
+			if (bar_len >= 10) {
+				const int marker = (last > first ? (int)((position - first) * (bar_len - 1) / (last - first)) : 0);
+				rates += Symbols::h_line * marker + "●" + Symbols::h_line * (bar_len - marker - 1) + ' ';
+				Input::mouse_mappings["replay_seek"] = {rates_y, x + 11 + (int)state.size(), 1, bar_len};
+			}
+			rates += strf_time("%Y-%m-%d %H:%M:%S", position / 1000);
+		}
+		else if (Remote::viewer) {
+			rates += (rates.empty() ? "" : " ") + "agent "s + Remote::agent_name + (Remote::connected() ? "" : " (offline)");
+		}
+		else if (Config::getB("adaptive_sampling") and width >= 50 + (zoom > 0 ? 10 : 0)) {
+			const auto fmt_ms = [](const uint64_t ms) {
+				return (ms < 1000 ? to_string(ms) + "ms" : to_string(ms / 1000) + '.' + to_string(ms % 1000 / 100) + 's');
+			};
+			rates += (rates.empty() ? "" : " ") + "auto cpu "s + fmt_ms(Runner::interval("cpu")) + " proc " + fmt_ms(Runner::interval("proc"));
+		}
+		if (redraw or rates != old_rates) {
+			if (not redraw and not old_rates.empty())
+				out += Mv::to(rates_y, x + 10) + Fx::ub + Theme::c("cpu_box") + Symbols::h_line * (ulen(old_rates) + 2);
+			if (not rates.empty())
+				out += Mv::to(rates_y, x + 10) + Theme::c("cpu_box") + (cpu_bottom ? Symbols::title_left : Symbols::title_left_down)
+					+ Theme::c("title") + Fx::b + rates + Fx::ub + Theme::c("cpu_box") + (cpu_bottom ? Symbols::title_right : Symbols::title_right_down);
+			old_rates = rates;
+		}
+
 		try {
 		//? Cpu graphs
-		out += Fx::ub + Mv::to(y + 1, x + 1) + graph_upper(cpu.cpu_percent.at(graph_up_field), (data_same or redraw));
+		out += Fx::ub + Mv::to(y + 1, x + 1) + graph_upper(zoom_data(cpu.cpu_percent.at(graph_up_field), cpu.history, graph_up_field),
+			(data_same or redraw or zoom_same(cpu.history, graph_up_field)));
 		if (not single_graph)
-			out += Mv::to( y + graph_up_height + 1 + (mid_line ? 1 : 0), x + 1) + graph_lower(cpu.cpu_percent.at(graph_lo_field), (data_same or redraw));
+			out += Mv::to( y + graph_up_height + 1 + (mid_line ? 1 : 0), x + 1) + graph_lower(zoom_data(cpu.cpu_percent.at(graph_lo_field), cpu.history, graph_lo_field),
+				(data_same or redraw or zoom_same(cpu.history, graph_lo_field)));
 
 		//? Uptime
 		if (Config::getB("show_uptime")) {
@@ -648,7 +728,7 @@ namespace Cpu {
 				+ ljust(to_string(n), core_width);
 			if (b_column_size > 0 or extra_width > 0)
 				out += Theme::c("inactive_fg") + graph_bg * (5 * b_column_size + extra_width) + Mv::l(5 * b_column_size + extra_width)
-					+ core_graphs.at(n)(cpu.core_percent.at(n), data_same or redraw);
+					+ core_graphs.at(n)(zoom_data(cpu.core_max.at(n), core_history(cpu, n), true), data_same or redraw or zoom_same(core_history(cpu, n)));
 			
 			out += Theme::g("cpu").at(clamp(cpu.core_percent.at(n).back(), 0ll, 100ll));
 			out += rjust(to_string(cpu.core_percent.at(n).back()), (b_column_size < 2 ? 3 : 4)) + Theme::c("main_fg") + '%';
@@ -731,6 +811,17 @@ namespace Mem {
 	unordered_flat_map<string, Draw::Meter> disk_meters_free;
 	unordered_flat_map<string, Draw::Graph> io_graphs;
 
+	//? Read and write history added together for the combined io graph, missed samples are kept as gaps
+	deque<long long> io_combined(const disk_info& disk) {
+		const auto& io_read = zoom_data(disk.io_read, disk.history, "read");
+		const auto& io_write = zoom_data(disk.io_write, disk.history, "write");
+		deque<long long> combined(min(io_read.size(), io_write.size()), 0);
+		rng::transform(io_read, io_write, combined.begin(), [](const long long read, const long long write) {
+			return (read == graph_gap ? graph_gap : read + write);
+		});
+		return combined;
+	}
+
 	string draw(const mem_info& mem, const bool force_redraw, const bool data_same) {
 		if (Runner::stopping) return "";
 		if (force_redraw) redraw = true;
@@ -761,21 +852,21 @@ namespace Mem {
 			for (const string name : { "used", "available", "cached", "commit" }) {
 				const string color = (name == "commit" ? "available" : name == "available" ? "free" : name);
 				if (use_graphs)
-					mem_graphs[name] = Draw::Graph{mem_meter, graph_height, color, mem.percent.at(name), graph_symbol};
+					mem_graphs[name] = Draw::Graph{mem_meter, graph_height, color, zoom_data(mem.percent.at(name), mem.history, name), graph_symbol};
 				else
 					mem_meters[name] = Draw::Meter{ mem_meter, color };
 			}
 
 			if (show_gpu) {
 				if (use_graphs)
-					mem_graphs["gpu_used"] = Draw::Graph{ mem_meter, graph_height, "cpu", mem.percent.at("gpu_used"), graph_symbol };
+					mem_graphs["gpu_used"] = Draw::Graph{ mem_meter, graph_height, "cpu", zoom_data(mem.percent.at("gpu_used"), mem.history, "gpu_used"), graph_symbol };
 				else
 					mem_meters["gpu_used"] = Draw::Meter{ mem_meter, "cpu" };
 			}
 
 			if (show_swap and has_swap) {
 				if (use_graphs)
-					mem_graphs["page_used"] = Draw::Graph{mem_meter, graph_height, "cpu", mem.percent.at("page_used"), graph_symbol};
+					mem_graphs["page_used"] = Draw::Graph{mem_meter, graph_height, "cpu", zoom_data(mem.percent.at("page_used"), mem.history, "page_used"), graph_symbol};
 				else
 					mem_meters["page_used"] = Draw::Meter{mem_meter, "cpu"};
 			}
@@ -805,19 +896,17 @@ namespace Mem {
 					for (const auto& [name, disk] : mem.disks) {
 						if (disk.io_read.empty()) continue;
 
-						io_graphs[name + "_activity"] = Draw::Graph{disks_width - 6, 1, "available", disk.io_activity, graph_symbol};
+						io_graphs[name + "_activity"] = Draw::Graph{disks_width - 6, 1, "available", zoom_data(disk.io_activity, disk.history, "activity"), graph_symbol};
 
 						if (io_mode) {
 							//? Create one combined graph for IO read/write if enabled
 							long long speed = static_cast<long long>(custom_speeds.contains(name) ? custom_speeds.at(name) : 100) << 20;
 							if (io_graph_combined) {
-								deque<long long> combined(disk.io_read.size(), 0);
-								rng::transform(disk.io_read, disk.io_write, combined.begin(), std::plus<long long>());
-								io_graphs[name] = Draw::Graph{disks_width - (io_mode ? 0 : 6), disks_io_h, "available", combined, graph_symbol, false, true, speed};
+								io_graphs[name] = Draw::Graph{disks_width - (io_mode ? 0 : 6), disks_io_h, "available", io_combined(disk), graph_symbol, false, true, speed};
 							}
 							else {
-								io_graphs[name + "_read"] = Draw::Graph{disks_width, half_height, "free", disk.io_read, graph_symbol, false, true, speed};
-								io_graphs[name + "_write"] = Draw::Graph{disks_width, disks_io_h - half_height, "used", disk.io_write, graph_symbol, true, true, speed};
+								io_graphs[name + "_read"] = Draw::Graph{disks_width, half_height, "free", zoom_data(disk.io_read, disk.history, "read"), graph_symbol, false, true, speed};
+								io_graphs[name + "_write"] = Draw::Graph{disks_width, disks_io_h - half_height, "used", zoom_data(disk.io_write, disk.history, "write"), graph_symbol, true, true, speed};
 							}
 						}
 					}
@@ -879,7 +968,9 @@ namespace Mem {
 
 			const string humanized = floating_humanizer(mem.stats.at(name));
 			const int offset = max(0, divider.empty() ? 9 - (int)humanized.size() : 0);
-			const string graphics = (use_graphs ? mem_graphs.at(name)(mem.percent.at(name), redraw or data_same) : mem_meters.at(name)(mem.percent.at(name).back()));
+			const string graphics = (use_graphs
+				? mem_graphs.at(name)(zoom_data(mem.percent.at(name), mem.history, name), redraw or data_same or zoom_same(mem.history, name))
+				: mem_meters.at(name)(mem.percent.at(name).back()));
 			if (mem_size > 2) {
 				out += Mv::to(y+1+cy, x+1+cx) + divider + title.substr(0, big_mem ? 10 : 5) + ":"
 					+ Mv::to(y+1+cy, x+cx + mem_width - 2 - humanized.size()) + (divider.empty() ? Mv::l(offset) + string(" ") * offset + humanized : trans(humanized))
@@ -916,14 +1007,14 @@ namespace Mem {
 						out += Mv::to(y+1+cy, x+1+cx + round((double)disks_width / 2) - round((double)used_percent.size() / 2) - 1) + hu_div + used_percent + '%' + hu_div;
 					}
 					out += Mv::to(y+2+cy++, x+1+cx) + (big_disk ? " IO% " : " IO   " + Mv::l(2)) + Theme::c("inactive_fg") + graph_bg * (disks_width - 6)
-						+ Mv::l(disks_width - 6) + io_graphs.at(mount + "_activity")(disk.io_activity, redraw or data_same) + Theme::c("main_fg");
+						+ Mv::l(disks_width - 6) + io_graphs.at(mount + "_activity")(zoom_data(disk.io_activity, disk.history, "activity"), redraw or data_same or zoom_same(disk.history, "activity")) + Theme::c("main_fg");
 					if (++cy > height - 3) break;
 					if (io_graph_combined) {
 						auto comb_val = disk.io_read.back() + disk.io_write.back();
 						const string humanized = (disk.io_write.back() > 0 ? "▼"s : ""s) + (disk.io_read.back() > 0 ? "▲"s : ""s)
 												+ (comb_val > 0 ? Mv::r(1) + floating_humanizer(comb_val, true) : "RW");
 						if (disks_io_h == 1) out += Mv::to(y+1+cy, x+1+cx) + string(5, ' ');
-						out += Mv::to(y+1+cy, x+1+cx) + io_graphs.at(mount)({comb_val}, redraw or data_same)
+						out += Mv::to(y+1+cy, x+1+cx) + io_graphs.at(mount)(io_combined(disk), redraw or data_same or zoom_same(disk.history, "read"))
 							+ Mv::to(y+1+cy, x+1+cx) + Theme::c("main_fg") + humanized;
 						cy += disks_io_h;
 					}
@@ -931,8 +1022,8 @@ namespace Mem {
 						const string human_read = (disk.io_read.back() > 0 ? "▲" + floating_humanizer(disk.io_read.back(), true) : "R");
 						const string human_write = (disk.io_write.back() > 0 ? "▼" + floating_humanizer(disk.io_write.back(), true) : "W");
 						if (disks_io_h <= 3) out += Mv::to(y+1+cy, x+1+cx) + string(5, ' ') + Mv::to(y+cy + disks_io_h, x+1+cx) + string(5, ' ');
-						out += Mv::to(y+1+cy, x+1+cx) + io_graphs.at(mount + "_read")(disk.io_read, redraw or data_same) + Mv::l(disks_width)
-							+ Mv::d(1) + io_graphs.at(mount + "_write")(disk.io_write, redraw or data_same)
+						out += Mv::to(y+1+cy, x+1+cx) + io_graphs.at(mount + "_read")(zoom_data(disk.io_read, disk.history, "read"), redraw or data_same or zoom_same(disk.history, "read")) + Mv::l(disks_width)
+							+ Mv::d(1) + io_graphs.at(mount + "_write")(zoom_data(disk.io_write, disk.history, "write"), redraw or data_same or zoom_same(disk.history, "write"))
 							+ Mv::to(y+1+cy, x+1+cx) + human_read + Mv::to(y+cy + disks_io_h, x+1+cx) + human_write;
 						cy += disks_io_h;
 					}
@@ -957,7 +1048,7 @@ namespace Mem {
 					if (++cy > height - 3) break;
 					if (show_io_stat and io_graphs.contains(mount + "_activity")) {
 						out += Mv::to(y+1+cy, x+1+cx) + (big_disk ? " IO% " : " IO   " + Mv::l(2)) + Theme::c("inactive_fg") + graph_bg * (disks_width - 6) + Theme::g("available").at(clamp(disk.io_activity.back(), 50ll, 100ll))
-							+ Mv::l(disks_width - 6) + io_graphs.at(mount + "_activity")(disk.io_activity, redraw or data_same) + Theme::c("main_fg");
+							+ Mv::l(disks_width - 6) + io_graphs.at(mount + "_activity")(zoom_data(disk.io_activity, disk.history, "activity"), redraw or data_same or zoom_same(disk.history, "activity")) + Theme::c("main_fg");
 						if (not big_disk) out += Mv::to(y+1+cy, x+cx+1) + Theme::c("main_fg") + human_io;
 						if (++cy > height - 3) break;
 					}
@@ -1025,8 +1116,8 @@ namespace Net {
 			graphs.clear();
 			if (net.bandwidth.at("download").empty() or net.bandwidth.at("upload").empty())
 				return out + Fx::reset;
-			graphs["download"] = Draw::Graph{width - b_width - 2, u_graph_height, "download", net.bandwidth.at("download"), graph_symbol, false, true, down_max};
-			graphs["upload"] = Draw::Graph{width - b_width - 2, d_graph_height, "upload", net.bandwidth.at("upload"), graph_symbol, true, true, up_max};
+			graphs["download"] = Draw::Graph{width - b_width - 2, u_graph_height, "download", zoom_data(net.bandwidth.at("download"), net.history, "download"), graph_symbol, false, true, down_max};
+			graphs["upload"] = Draw::Graph{width - b_width - 2, d_graph_height, "upload", zoom_data(net.bandwidth.at("upload"), net.history, "upload"), graph_symbol, true, true, up_max};
 
 			//? Interface selector and buttons
 
@@ -1058,7 +1149,7 @@ namespace Net {
 		//? Graphs and stats
 		int cy = 0;
 		for (const string dir : {"download", "upload"}) {
-			out += Mv::to(y+1 + (dir == "upload" ? u_graph_height : 0), x + 1) + graphs.at(dir)(net.bandwidth.at(dir), redraw or data_same or not net.connected)
+			out += Mv::to(y+1 + (dir == "upload" ? u_graph_height : 0), x + 1) + graphs.at(dir)(zoom_data(net.bandwidth.at(dir), net.history, dir), redraw or data_same or not net.connected or zoom_same(net.history, dir))
 				+ Mv::to(y+1 + (dir == "upload" ? height - 3: 0), x + 1) + Fx::ub + Theme::c("graph_text")
 				+ floating_humanizer((dir == "upload" ? up_max : down_max), true);
 			const string speed = floating_humanizer(net.stat.at(dir).speed, false, 0, false, true);
@@ -1103,6 +1194,12 @@ namespace Proc {
 	Draw::Graph detailed_mem_graph;
 	int user_size, thread_size, prog_size, cmd_size, tree_size;
 	int dgraph_x, dgraph_width, d_width, d_x, d_y;
+	atomic<bool> selection_only = false;
+
+	//? State of the last drawn list, used to only redraw changed rows when the selection or view moves
+	const vector<proc_info>* last_plist = nullptr;
+	int last_start = -1, last_selected = -1, last_numpids = -1;
+	bool last_detailed = false;
 
 	string box;
 
@@ -1166,7 +1263,7 @@ namespace Proc {
 		return (not changed ? -1 : selected);
 	}
 
-	string draw(const vector<proc_info>& plist, const bool force_redraw, const bool data_same) {
+	string draw(const vector<proc_info>& plist, const bool force_redraw, const bool data_same, const bool selection_only) {
 		if (Runner::stopping) return "";
 		auto& services = Config::getB("proc_services");
 		const bool proc_tree = (not services and Config::getB("proc_tree"));
@@ -1378,6 +1475,14 @@ namespace Proc {
 				if (selected > 0) Input::mouse_mappings["t"] = { y + height - 1, mouse_x, 1, 9 };
 				mouse_x += 11;
 			}
+
+			//? Time of the recorded snapshot shown instead of live data
+			if (Record::Flight::scrub_time > 0 and width > 58) {
+				out += title_left_down + Fx::b + Theme::c("hi_fg") + '<' + Theme::c("title") + " rec " + strf_time("%H:%M:%S", Record::Flight::scrub_wall / 1000) + ' '
+					+ Theme::c("hi_fg") + '>' + Fx::ub + title_right_down;
+				Input::mouse_mappings["<"] = {y + height - 1, mouse_x, 1, 1};
+				Input::mouse_mappings[">"] = {y + height - 1, mouse_x + 15, 1, 1};
+			}
 			
 			/*if (width > 55) {
 				out += title_left_down + Fx::b + hi_color + (vim_keys ? 'K' : 'k') + t_color + "ill" + Fx::ub + title_right_down;
@@ -1404,8 +1509,43 @@ namespace Proc {
 		}
 		//* End of redraw block
 
+		//? Check bounds of current selection and view
+		if (start > 0 and numpids <= select_max)
+			start = 0;
+		if (start > numpids - select_max)
+			start = max(0, numpids - select_max);
+		if (selected > select_max)
+			selected = select_max;
+		if (selected > numpids)
+			selected = numpids;
+
+		//? Only redraw the rows that changed if nothing but the selection or view moved since the last draw
+		const int scroll = start - last_start;
+		const bool fast_path = (selection_only and data_same and not redraw and &plist == last_plist and numpids == last_numpids
+			and show_detailed == last_detailed and std::abs(scroll) < select_max);
+		int dirty_first = 0, dirty_last = select_max - 1;
+		int dirty_old = -1, dirty_new = -1;
+		if (fast_path and not proc_gradient) {
+			//? Shift the rows still visible with a scrolling region and only draw the newly exposed ones,
+			//? lines are scrolled at full terminal width so this is only possible when the box spans the whole width
+			if (scroll != 0 and x == 1 and width == Term::width) {
+				out += Term::scroll_region(y + 2, y + 1 + select_max) + (scroll > 0 ? Term::scroll_up(scroll) : Term::scroll_down(-scroll)) + Term::scroll_reset;
+				dirty_first = (scroll > 0 ? select_max - scroll : 0);
+				dirty_last = (scroll > 0 ? select_max - 1 : -scroll - 1);
+			}
+			else if (scroll == 0) {
+				dirty_first = select_max;
+				dirty_last = -1;
+			}
+			dirty_old = last_selected - 1 - scroll;
+			dirty_new = selected - 1;
+		}
+		const auto row_dirty = [&](const int row) {
+			return (not fast_path or (row >= dirty_first and row <= dirty_last) or row == dirty_old or row == dirty_new);
+		};
+
 		//? Draw details box if shown
-		if (show_detailed) {
+		if (show_detailed and not fast_path) {
 			const bool alive = detailed.status != "Stopped";
 			const int item_fit = floor((double)(d_width - 2) / 10);
 			const int item_width = floor((double)(d_width - 2) / min(item_fit, 7));
@@ -1442,16 +1582,6 @@ namespace Proc {
 				+ Theme::c("title") + Fx::b + detailed.memory;
 		}
 
-		//? Check bounds of current selection and view
-		if (start > 0 and numpids <= select_max)
-			start = 0;
-		if (start > numpids - select_max)
-			start = max(0, numpids - select_max);
-		if (selected > select_max)
-			selected = select_max;
-		if (selected > numpids)
-			selected = numpids;
-
 		//* Iteration over processes
 		int lc = 0;
 		for (int n=0; auto& p : plist) {
@@ -1480,6 +1610,11 @@ namespace Proc {
 					p_counters.at(p.pid) = 0;
 			}
 
+			if (not row_dirty(lc)) {
+				if (lc++ > height - 5) break;
+				continue;
+			}
+
 			out += Fx::reset;
 
 			//? Set correct gradient colors if enabled
@@ -1566,10 +1701,14 @@ namespace Proc {
 		}
 
 		out += Fx::reset;
-		while (lc++ < height - 5) out += Mv::to(y+lc+1, x+1) + string(width - 2, ' ');
+		while (lc++ < height - 5) if (row_dirty(lc - 1)) out += Mv::to(y+lc+1, x+1) + string(width - 2, ' ');
 
 		//? Draw scrollbar if needed
 		if (numpids > select_max) {
+			if (fast_path) {
+				for (int i = 0; i < select_max; i++)
+					if (not row_dirty(i)) out += Mv::to(y + 2 + i, x + width - 2) + ' ';
+			}
 			const int scroll_pos = clamp((int)round((double)start * select_max / (numpids - select_max)), 0, height - 5);
 			out += Mv::to(y + 1, x + width - 2) + Fx::b + Theme::c("main_fg") + Symbols::up
 				+ Mv::to(y + height - 2, x + width - 2) + Symbols::down
@@ -1611,6 +1750,11 @@ namespace Proc {
 			selected_name.clear();
 			selected_status.clear();
 		}
+		last_plist = &plist;
+		last_start = start;
+		last_selected = selected;
+		last_numpids = numpids;
+		last_detailed = show_detailed;
 		redraw = false;
 		return out + Fx::reset;
 	}
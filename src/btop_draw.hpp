@@ -21,6 +21,7 @@ tab-size = 4
 #include <string>
 #include <vector>
 #include <array>
+#include <atomic>
 #include <robin_hood.h>
 #include <deque>
 
@@ -55,8 +56,26 @@ namespace Symbols {
 	const string enter = "┙";
 }
 
+namespace Shared {
+	class History;
+}
+
 namespace Draw {
 
+	//* Time scale of the cpu, core, mem, disk io and net graphs, 0 for the latest samples or 1-3 for the levels of Shared::History
+	extern std::atomic<int> zoom;
+	extern const array<string, 4> zoom_names;
+
+	//* Returns <raw> at zoom level 0, otherwise the averages, or maxima if <peak>, for the current zoom level from <history>
+	const deque<long long>& zoom_data(const deque<long long>& raw, const Shared::History* history, const bool peak=false);
+
+	//* Returns <raw> at zoom level 0, otherwise the values for the current zoom level from <history> at <name>
+	const deque<long long>& zoom_data(const deque<long long>& raw, const unordered_flat_map<string, Shared::History>& history, const string& name);
+
+	//* True if zoomed and the data from zoom_data() hasn't changed with the last collect
+	bool zoom_same(const Shared::History* history);
+	bool zoom_same(const unordered_flat_map<string, Shared::History>& history, const string& name);
+
 	//* Generate if needed and return the btop++ banner
 	string banner_gen(int y=0, int x=0, bool centered=false, bool redraw=false);
 
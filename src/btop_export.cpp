@@ -0,0 +1,709 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#include <iostream>
+#include <fstream>
+#include <mutex>
+#include <charconv>
+#include <string_view>
+#include <ranges>
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+
+#define _WIN32_WINNT 0x0600
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#define VC_EXTRALEAN
+#include <winsock2.h>
+#include <WS2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+
+#include <btop_export.hpp>
+#include <btop_shared.hpp>
+#include <btop_tools.hpp>
+#include <btop_config.hpp>
+#include <btop_perf.hpp>
+
+using std::string_view, std::array, std::min, std::to_string;
+namespace fs = std::filesystem;
+namespace rng = std::ranges;
+using namespace Tools;
+
+namespace Export {
+	bool active = false;
+	string format = "json";
+	fs::path file;
+	string fields = "cpu,cores,mem,disks,net,procs";
+	int top_procs = 10;
+	int count = 0;
+
+	namespace {
+		std::ofstream fwrite;
+		std::ostream* out = &std::cout;
+		std::mutex out_lock;
+		bool csv = false;
+		int written = 0;
+		bool s_cpu, s_cores, s_mem, s_disks, s_net, s_procs;
+
+		const array<string, 8> cpu_fields = { "total", "kernel", "user", "dpc", "interrupt", "idle", "gpu", "max" };
+		const array<string, 7> mem_fields = { "used", "available", "cached", "commit", "page_total", "page_used", "page_free" };
+		const array<string, 3> gpu_fields = { "gpu_total", "gpu_used", "gpu_free" };
+		const array<string, 2> net_dirs = { "download", "upload" };
+
+		//* Builds a record in reusable buffers straight from the collected data. JSON objects and arrays become
+		//* dot separated column names in CSV, where <header> is built alongside the values of each record
+		class Emitter {
+			string scopes, path, column;
+			vector<size_t> path_len;
+			bool first = true;
+			char idx[24], num[64];
+
+			void json_str(string& buf, const string_view str) {
+				buf += '"';
+				for (const char c : str) {
+					if (c == '"' or c == '\\') { buf += '\\'; buf += c; }
+					else if (c == '\n') buf += "\\n";
+					else if (c == '\r') buf += "\\r";
+					else if (c == '\t') buf += "\\t";
+					else if ((unsigned char)c < 0x20) {
+						auto [end, ec] = std::to_chars(num, num + 2, (unsigned char)c, 16);
+						buf += (end - num == 1 ? "\\u000" : "\\u00");
+						buf.append(num, end);
+					}
+					else buf += c;
+				}
+				buf += '"';
+			}
+
+			void csv_str(string& buf, const string_view str) {
+				if (str.find_first_of(",\"\r\n") == string_view::npos) {
+					buf += str;
+					return;
+				}
+				buf += '"';
+				for (const char c : str) {
+					if (c == '"') buf += '"';
+					buf += c;
+				}
+				buf += '"';
+			}
+
+			void key(const string_view name) {
+				if (csv) {
+					if (not first) {
+						line += ',';
+						header += ',';
+					}
+					column.assign(path).append(name);
+					csv_str(header, column);
+				}
+				else {
+					if (not first) line += ',';
+					if (scopes.back() == '{') {
+						json_str(line, name);
+						line += ':';
+					}
+				}
+				first = false;
+			}
+
+		public:
+			string line, header;
+
+			void start() {
+				line.clear();
+				header.clear();
+				path.clear();
+				path_len.clear();
+				scopes = "{";
+				first = true;
+				if (not csv) line += '{';
+			}
+
+			void finish() {
+				if (not csv) line += '}';
+				line += '\n';
+				if (csv) header += '\n';
+			}
+
+			//* Start a named object (bracket '{') or array (bracket '[')
+			void begin(const string_view name, const char bracket) {
+				if (csv) {
+					path_len.push_back(path.size());
+					path.append(name);
+					path += '.';
+				}
+				else {
+					key(name);
+					line += bracket;
+					first = true;
+				}
+				scopes += bracket;
+			}
+
+			//* Start an object in an array, identified by field "name" in JSON and by the column prefix in CSV
+			void item(const string_view name) {
+				begin(name, '{');
+				if (not csv) text("name", name);
+			}
+
+			void end() {
+				if (csv) {
+					path.resize(path_len.back());
+					path_len.pop_back();
+				}
+				else line += (scopes.back() == '{' ? '}' : ']');
+				scopes.pop_back();
+				first = false;
+			}
+
+			//* Returns <i> as a name for array members, only valid until the next call
+			string_view index(const size_t i) {
+				auto [end, ec] = std::to_chars(idx, idx + sizeof(idx), i);
+				return string_view(idx, end - idx);
+			}
+
+			void number(const string_view name, const long long value) {
+				key(name);
+				auto [end, ec] = std::to_chars(num, num + sizeof(num), value);
+				line.append(num, end);
+			}
+
+			void decimal(const string_view name, const double value, const int precision) {
+				key(name);
+				auto [end, ec] = std::to_chars(num, num + sizeof(num), value, std::chars_format::fixed, precision);
+				line.append(num, end);
+			}
+
+			void missing(const string_view name) {
+				key(name);
+				if (not csv) line += "null";
+			}
+
+			void text(const string_view name, const string_view value) {
+				key(name);
+				if (csv) csv_str(line, value);
+				else json_str(line, value);
+			}
+
+			//* Latest value of a graph series, missing if empty or a gap
+			void latest(const string_view name, const std::deque<long long>& data) {
+				if (data.empty() or data.back() == graph_gap) missing(name);
+				else number(name, data.back());
+			}
+		};
+
+		Emitter emit;
+		string last_header;
+		vector<const Proc::proc_info*> top;
+
+		//* Fill <out> with the <n> processes with highest cpu usage in descending order, returns the number selected
+		size_t select_top(const vector<Proc::proc_info>& procs, const size_t n, vector<const Proc::proc_info*>& out) {
+			out.clear();
+			for (const auto& p : procs) out.push_back(&p);
+			const size_t count = min(out.size(), n);
+			rng::partial_sort(out, out.begin() + count, [](const auto* a, const auto* b) { return a->cpu_p > b->cpu_p; });
+			return count;
+		}
+	}
+
+	void init() {
+		csv = (format == "csv");
+		const auto selected = ssplit(fields, ',');
+		s_cpu = v_contains(selected, "cpu");
+		s_cores = v_contains(selected, "cores");
+		s_mem = v_contains(selected, "mem");
+		s_disks = v_contains(selected, "disks");
+		s_net = v_contains(selected, "net");
+		s_procs = v_contains(selected, "procs");
+
+		if (not file.empty()) {
+			fwrite.open(file, std::ios::app | std::ios::binary);
+			if (not fwrite.good()) throw std::runtime_error("Could not open \"" + file.string() + "\" for writing");
+			out = &fwrite;
+		}
+
+		Shared::headless_setup(s_cpu or s_cores, s_mem or s_disks, s_net, s_procs);
+		if (s_disks) Config::set("show_disks", true);
+
+		Logger::info("Starting batch mode, writing ", format, " records to ", (file.empty() ? "stdout" : file.string()));
+	}
+
+	bool write() {
+		const Cpu::cpu_info* cpu = (s_cpu or s_cores ? &Cpu::collect() : nullptr);
+		const Mem::mem_info* mem = (s_mem or s_disks ? &Mem::collect() : nullptr);
+		if (s_net) Net::collect();
+		const vector<Proc::proc_info>* procs = (s_procs ? &Proc::collect() : nullptr);
+
+		emit.start();
+		emit.number("time", (long long)time_ms());
+
+		if (s_cpu) {
+			emit.begin("cpu", '{');
+			for (const auto& field : cpu_fields) {
+				if (field == "gpu" and not Cpu::has_gpu) continue;
+				emit.latest(field, cpu->cpu_percent.at(field));
+			}
+			if (Cpu::got_sensors) emit.latest("temp", cpu->temp.at(0));
+			emit.begin("load_avg", '[');
+			for (size_t i = 0; i < cpu->load_avg.size(); i++) emit.decimal(emit.index(i), cpu->load_avg[i], 2);
+			emit.end();
+			emit.end();
+		}
+
+		if (s_cores) {
+			emit.begin("cores", '[');
+			for (size_t i = 0; i < cpu->core_percent.size(); i++) emit.latest(emit.index(i), cpu->core_percent[i]);
+			emit.end();
+			if (Cpu::got_sensors and not Cpu::cpu_temp_only) {
+				emit.begin("core_temps", '[');
+				for (size_t i = 1; i < cpu->temp.size(); i++) emit.latest(emit.index(i - 1), cpu->temp[i]);
+				emit.end();
+			}
+		}
+
+		if (s_mem) {
+			emit.begin("mem", '{');
+			emit.number("total", Mem::totalMem);
+			for (const auto& name : mem_fields) emit.number(name, (long long)mem->stats.at(name));
+			if (Cpu::has_gpu) {
+				for (const auto& name : gpu_fields) emit.number(name, (long long)mem->stats.at(name));
+			}
+			emit.end();
+		}
+
+		if (s_disks) {
+			emit.begin("disks", '[');
+			for (const auto& name : mem->disks_order) {
+				const auto& disk = mem->disks.at(name);
+				emit.item(name);
+				emit.number("total", disk.total);
+				emit.number("used", disk.used);
+				emit.number("free", disk.free);
+				emit.latest("io_read", disk.io_read);
+				emit.latest("io_write", disk.io_write);
+				emit.latest("io_activity", disk.io_activity);
+				emit.end();
+			}
+			emit.end();
+		}
+
+		if (s_net) {
+			emit.begin("net", '[');
+			for (const auto& name : Net::interfaces) {
+				const auto& net = Net::current_net.at(name);
+				emit.item(name);
+				emit.number("connected", net.connected);
+				for (const auto& dir : net_dirs) {
+					const auto& stat = net.stat.at(dir);
+					emit.begin(dir, '{');
+					emit.number("speed", stat.speed);
+					emit.number("top", stat.top);
+					emit.number("total", stat.total);
+					emit.end();
+				}
+				emit.end();
+			}
+			emit.end();
+		}
+
+		if (s_procs) {
+			const size_t n = select_top(*procs, top_procs, top);
+			emit.begin("procs", '[');
+			for (size_t i = 0; i < n; i++) {
+				const auto& p = *top[i];
+				emit.begin(emit.index(i), '{');
+				emit.number("pid", p.pid);
+				emit.text("name", p.name);
+				emit.text("cmd", p.cmd);
+				emit.text("user", p.user);
+				emit.number("threads", p.threads);
+				emit.number("mem", p.mem);
+				emit.decimal("cpu", p.cpu_p, 1);
+				emit.end();
+			}
+			emit.end();
+		}
+
+		emit.finish();
+
+		Metrics::update(cpu, mem, (s_net ? &Net::current_net : nullptr), procs);
+
+		//? A new header line is written in CSV mode whenever the set of columns changes, for example when a disk is added
+		std::lock_guard lock(out_lock);
+		if (csv and emit.header != last_header) {
+			out->write(emit.header.data(), emit.header.size());
+			std::swap(last_header, emit.header);
+		}
+		out->write(emit.line.data(), emit.line.size());
+		out->flush();
+		if (not out->good()) throw std::runtime_error("Export::write() -> Failed to write record");
+
+		return (count == 0 or ++written < count);
+	}
+
+	void close() {
+		if (not active) return;
+		std::lock_guard lock(out_lock);
+		out->flush();
+		if (fwrite.is_open()) fwrite.close();
+	}
+
+	namespace Metrics {
+		atomic<int> port (0);
+
+		namespace {
+			enum boxes { cpu_box, mem_box, net_box, proc_box };
+
+			//? Latest rendering of each box, only touched by the thread calling update()
+			array<string, 4> rendered;
+			vector<std::shared_ptr<string>> pool;
+			vector<const Proc::proc_info*> top_list;
+			string labels;
+			char num[64], idx[24];
+
+			snapshot_cell<string> current;
+
+			const size_t max_clients = 256;
+			const size_t max_request = 8192;
+			const uint64_t client_timeout = 5000;
+
+			void family(string& out, const string_view name, const string_view type, const string_view help) {
+				out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+				out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+			}
+
+			//* Returns <i> as a label value, only valid until the next call
+			string_view index(const size_t i) {
+				auto [end, ec] = std::to_chars(idx, idx + sizeof(idx), i);
+				return string_view(idx, end - idx);
+			}
+
+			//* Set labels for the next samples from key/value pairs, values are escaped
+			const string& with(std::initializer_list<std::pair<string_view, string_view>> pairs) {
+				labels.clear();
+				for (const auto& [key, value] : pairs) {
+					labels.append(labels.empty() ? "{" : ",").append(key).append("=\"");
+					for (const char c : value) {
+						if (c == '\\' or c == '"') labels += '\\';
+						if (c == '\n') labels += "\\n";
+						else labels += c;
+					}
+					labels += '"';
+				}
+				if (not labels.empty()) labels += '}';
+				return labels;
+			}
+
+			void sample(string& out, const string_view name, const string_view lbl, const long long value) {
+				auto [end, ec] = std::to_chars(num, num + sizeof(num), value);
+				out.append(name).append(lbl).append(" ").append(num, end - num).append("\n");
+			}
+
+			void sample(string& out, const string_view name, const string_view lbl, const double value) {
+				auto [end, ec] = std::to_chars(num, num + sizeof(num), value);
+				out.append(name).append(lbl).append(" ").append(num, end - num).append("\n");
+			}
+
+			//* Latest value of a graph series, skipped if empty or a gap
+			void latest(string& out, const string_view name, const string_view lbl, const std::deque<long long>& data) {
+				if (not data.empty() and data.back() != graph_gap) sample(out, name, lbl, data.back());
+			}
+
+			void render_cpu(string& out, const Cpu::cpu_info& cpu) {
+				out.clear();
+				family(out, "btop_cpu_percent", "gauge", "Cpu usage in percent by time field.");
+				for (const auto& field : cpu_fields) {
+					if (field == "gpu" and not Cpu::has_gpu) continue;
+					latest(out, "btop_cpu_percent", with({{"field", field}}), cpu.cpu_percent.at(field));
+				}
+				family(out, "btop_cpu_core_percent", "gauge", "Cpu usage in percent per core.");
+				for (size_t i = 0; i < cpu.core_percent.size(); i++)
+					latest(out, "btop_cpu_core_percent", with({{"core", index(i)}}), cpu.core_percent[i]);
+
+				if (Cpu::got_sensors) {
+					family(out, "btop_cpu_temperature_celsius", "gauge", "Cpu package and core temperatures.");
+					latest(out, "btop_cpu_temperature_celsius", with({{"sensor", "package"}}), cpu.temp.at(0));
+					if (not Cpu::cpu_temp_only) {
+						for (size_t i = 1; i < cpu.temp.size(); i++)
+							latest(out, "btop_cpu_temperature_celsius", with({{"sensor", "core"}, {"core", index(i - 1)}}), cpu.temp[i]);
+					}
+				}
+
+				family(out, "btop_load_average", "gauge", "Load average calculated from the processor queue length.");
+				for (size_t i = 0; const auto period : { "1m", "5m", "15m" })
+					sample(out, "btop_load_average", with({{"period", period}}), (double)cpu.load_avg.at(i++));
+			}
+
+			void render_mem(string& out, const Mem::mem_info& mem) {
+				out.clear();
+				family(out, "btop_memory_bytes", "gauge", "Memory, page file and gpu memory in bytes.");
+				sample(out, "btop_memory_bytes", with({{"type", "total"}}), (long long)Mem::totalMem);
+				for (const auto& name : mem_fields) sample(out, "btop_memory_bytes", with({{"type", name}}), (long long)mem.stats.at(name));
+				if (Cpu::has_gpu) {
+					for (const auto& name : gpu_fields) sample(out, "btop_memory_bytes", with({{"type", name}}), (long long)mem.stats.at(name));
+				}
+
+				if (mem.disks_order.empty()) return;
+				const auto disk_family = [&](const string_view name, const string_view help, const auto member) {
+					family(out, name, "gauge", help);
+					for (const auto& disk_name : mem.disks_order) {
+						const auto& value = mem.disks.at(disk_name).*member;
+						if constexpr (std::is_same_v<std::decay_t<decltype(value)>, std::deque<long long>>) latest(out, name, with({{"disk", disk_name}}), value);
+						else sample(out, name, with({{"disk", disk_name}}), (long long)value);
+					}
+				};
+				disk_family("btop_disk_total_bytes", "Disk size in bytes.", &Mem::disk_info::total);
+				disk_family("btop_disk_used_bytes", "Disk space used in bytes.", &Mem::disk_info::used);
+				disk_family("btop_disk_free_bytes", "Disk space free in bytes.", &Mem::disk_info::free);
+				disk_family("btop_disk_read_bytes_per_second", "Disk read speed in bytes per second.", &Mem::disk_info::io_read);
+				disk_family("btop_disk_write_bytes_per_second", "Disk write speed in bytes per second.", &Mem::disk_info::io_write);
+				disk_family("btop_disk_io_percent", "Disk busy time in percent.", &Mem::disk_info::io_activity);
+			}
+
+			void render_net(string& out, const unordered_flat_map<string, Net::net_info>& net) {
+				out.clear();
+				family(out, "btop_network_up", "gauge", "1 if the interface is connected.");
+				for (const auto& iface : Net::interfaces) {
+					if (const auto it = net.find(iface); it != net.end()) sample(out, "btop_network_up", with({{"interface", iface}}), (long long)it->second.connected);
+				}
+				//? Interfaces skipped by adaptive sampling have no current values and are left out until collected again
+				const auto net_family = [&](const string_view name, const string_view type, const string_view help, const string& dir, const auto member) {
+					family(out, name, type, help);
+					for (const auto& iface : Net::interfaces) {
+						if (const auto it = net.find(iface); it != net.end() and not it->second.stale)
+							sample(out, name, with({{"interface", iface}}), (long long)(it->second.stat.at(dir).*member));
+					}
+				};
+				net_family("btop_network_receive_bytes_per_second", "gauge", "Download speed in bytes per second.", net_dirs[0], &Net::net_stat::speed);
+				net_family("btop_network_transmit_bytes_per_second", "gauge", "Upload speed in bytes per second.", net_dirs[1], &Net::net_stat::speed);
+				net_family("btop_network_receive_bytes_total", "counter", "Bytes downloaded.", net_dirs[0], &Net::net_stat::total);
+				net_family("btop_network_transmit_bytes_total", "counter", "Bytes uploaded.", net_dirs[1], &Net::net_stat::total);
+			}
+
+			void render_proc(string& out, const vector<Proc::proc_info>& procs) {
+				out.clear();
+				const size_t n = select_top(procs, top_procs, top_list);
+
+				//? Value series are labeled by rank only and stay at <top_procs> series. Process identity is kept in an info series
+				//? joined on rank, which gets a new series for every pid, name and user combination that reaches the top list
+				family(out, "btop_process_info", "gauge", "Pid, name and user of the process at each rank, always 1. Creates a new series for every process reaching the top list.");
+				for (size_t i = 0; i < n; i++) {
+					const auto& p = *top_list[i];
+					char pid[24];
+					auto [end, ec] = std::to_chars(pid, pid + sizeof(pid), p.pid);
+					sample(out, "btop_process_info", with({{"rank", index(i + 1)}, {"pid", string_view(pid, end - pid)}, {"name", p.name}, {"user", p.user}}), 1ll);
+				}
+
+				const auto proc_family = [&](const string_view name, const string_view help, const auto value) {
+					family(out, name, "gauge", help);
+					for (size_t i = 0; i < n; i++) sample(out, name, with({{"rank", index(i + 1)}}), value(*top_list[i]));
+				};
+				proc_family("btop_process_cpu_percent", "Cpu usage in percent of the processes with highest cpu usage.",
+					[](const Proc::proc_info& p) { return p.cpu_p; });
+				proc_family("btop_process_memory_bytes", "Memory used in bytes of the processes with highest cpu usage.",
+					[](const Proc::proc_info& p) { return (long long)p.mem; });
+				proc_family("btop_process_threads", "Threads of the processes with highest cpu usage.",
+					[](const Proc::proc_info& p) { return (long long)p.threads; });
+			}
+
+			struct Client {
+				SOCKET sock = INVALID_SOCKET;
+				string request, head;
+				std::shared_ptr<const string> body;
+				size_t sent = 0;
+				uint64_t deadline = 0;
+				bool responding = false;
+			};
+
+			void respond(Client& client) {
+				const string_view req = client.request;
+				string_view status = "200 OK";
+				if (not req.starts_with("GET "))
+					status = "405 Method Not Allowed";
+				else if (const auto path = req.substr(4, req.find(' ', 4) - 4); path != "/metrics" and not path.starts_with("/metrics?"))
+					status = "404 Not Found";
+				else
+					client.body = current.load();
+
+				client.head.assign("HTTP/1.1 ").append(status)
+					.append("\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: ")
+					.append(to_string(client.body ? client.body->size() : 0))
+					.append("\r\nConnection: close\r\n\r\n");
+				client.responding = true;
+			}
+
+			//* Read available request data, returns false if the connection should be closed
+			bool read_some(Client& client) {
+				char buf[2048];
+				while (not client.responding) {
+					const int n = recv(client.sock, buf, sizeof(buf), 0);
+					if (n == 0) return false;
+					else if (n == SOCKET_ERROR) return (WSAGetLastError() == WSAEWOULDBLOCK);
+					client.request.append(buf, n);
+					if (client.request.find("\r\n\r\n") != string::npos) respond(client);
+					else if (client.request.size() > max_request) return false;
+				}
+				return true;
+			}
+
+			//* Send as much of the response as the socket accepts, returns true when done or on error
+			bool send_some(Client& client) {
+				while (true) {
+					const string_view body = (client.body ? string_view(*client.body) : string_view{});
+					const string_view part = (client.sent < client.head.size()
+						? string_view(client.head).substr(client.sent)
+						: body.substr(client.sent - client.head.size()));
+					if (part.empty()) return true;
+					const int n = send(client.sock, part.data(), (int)min(part.size(), (size_t)INT_MAX), 0);
+					if (n == SOCKET_ERROR) return (WSAGetLastError() != WSAEWOULDBLOCK);
+					client.sent += n;
+				}
+			}
+
+			SOCKET listen_on(const int port_num) {
+				SOCKET sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+				if (sock == INVALID_SOCKET) {
+					Logger::error("Export::Metrics::listen_on() -> socket() failed with error " + to_string(WSAGetLastError()));
+					return INVALID_SOCKET;
+				}
+				//? Only reachable from the local machine, and no other socket can bind the same port while in use
+				sockaddr_in addr{};
+				addr.sin_family = AF_INET;
+				addr.sin_port = htons((u_short)port_num);
+				addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+				const int exclusive = 1;
+				u_long nonblocking = 1;
+				if (setsockopt(sock, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (const char*)&exclusive, sizeof(exclusive)) == SOCKET_ERROR
+					or bind(sock, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR
+					or listen(sock, SOMAXCONN) == SOCKET_ERROR
+					or ioctlsocket(sock, FIONBIO, &nonblocking) == SOCKET_ERROR) {
+					Logger::error("Metrics endpoint failed to listen on 127.0.0.1:" + to_string(port_num) + ", error " + to_string(WSAGetLastError()));
+					closesocket(sock);
+					return INVALID_SOCKET;
+				}
+				Logger::info("Serving metrics at http://127.0.0.1:", port_num, "/metrics");
+				return sock;
+			}
+		}
+
+		void update(const Cpu::cpu_info* cpu, const Mem::mem_info* mem,
+					const unordered_flat_map<string, Net::net_info>* net, const vector<Proc::proc_info>* procs) {
+			const int conf_port = Config::getI("metrics_port");
+			if (port.exchange(conf_port) != conf_port) port.notify_all();
+			if (conf_port == 0) return;
+
+			const uint64_t start = time_micros();
+			//? Boxes hidden since the last update are dropped instead of serving stale values
+			const array<bool, 4> shown = { Cpu::shown, Mem::shown, Net::shown, Proc::shown and not Config::getB("proc_services") };
+			for (size_t i = 0; i < rendered.size(); i++) {
+				if (not shown[i]) rendered[i].clear();
+			}
+			if (cpu != nullptr) render_cpu(rendered[cpu_box], *cpu);
+			if (mem != nullptr) render_mem(rendered[mem_box], *mem);
+			if (net != nullptr) render_net(rendered[net_box], *net);
+			if (procs != nullptr) render_proc(rendered[proc_box], *procs);
+
+			//? Reuse a buffer from an earlier snapshot that neither the cell nor any request is holding anymore
+			std::shared_ptr<string> buffer;
+			for (const auto& pooled : pool) {
+				if (pooled.use_count() == 1) {
+					std::atomic_thread_fence(std::memory_order_acquire);
+					buffer = pooled;
+					break;
+				}
+			}
+			if (not buffer) buffer = pool.emplace_back(std::make_shared<string>());
+
+			buffer->clear();
+			for (const auto& box : rendered) buffer->append(box);
+			family(*buffer, "btop_render_microseconds", "gauge", "Time used rendering this response.");
+			sample(*buffer, "btop_render_microseconds", "", (long long)(time_micros() - start));
+			current.publish(std::shared_ptr<const string>(std::move(buffer)));
+		}
+
+		void serve() {
+			Trace::thread_name("metrics");
+			WSADATA wsa_data;
+			if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+				Logger::error("Export::Metrics::serve() -> WSAStartup() failed, metrics endpoint disabled.");
+				return;
+			}
+
+			SOCKET listener = INVALID_SOCKET;
+			int bound = 0;
+			vector<Client> clients;
+			vector<WSAPOLLFD> fds;
+
+			while (not Global::quitting) {
+				//? (Re)bind when the configured port changes, idle while disabled or if binding failed
+				if (const int wanted = port.load(); wanted != bound) {
+					for (auto& client : clients) closesocket(client.sock);
+					clients.clear();
+					if (listener != INVALID_SOCKET) closesocket(listener);
+					bound = wanted;
+					listener = (wanted > 0 ? listen_on(wanted) : INVALID_SOCKET);
+				}
+				if (listener == INVALID_SOCKET) {
+					port.wait(bound);
+					continue;
+				}
+
+				fds.clear();
+				fds.push_back({listener, (SHORT)(clients.size() < max_clients ? POLLRDNORM : 0), 0});
+				for (const auto& client : clients) fds.push_back({client.sock, (SHORT)(client.responding ? POLLWRNORM : POLLRDNORM), 0});
+
+				if (WSAPoll(fds.data(), (ULONG)fds.size(), 250) == SOCKET_ERROR) {
+					Logger::warning("Export::Metrics::serve() -> WSAPoll() failed with error " + to_string(WSAGetLastError()));
+					sleep_ms(250);
+					continue;
+				}
+				const uint64_t now = steady_ms();
+
+				//? Finished, failed and timed out connections are closed, iterating backwards to swap them out with the last client
+				for (size_t i = clients.size(); i-- > 0;) {
+					auto& client = clients[i];
+					const SHORT events = fds[i + 1].revents;
+					bool done = false;
+					if (events & (POLLERR | POLLNVAL)) done = true;
+					else if (events & (POLLRDNORM | POLLHUP) and not client.responding) done = (not read_some(client) or (client.responding and send_some(client)));
+					else if (events & POLLWRNORM) done = send_some(client);
+					if (now > client.deadline) done = true;
+
+					if (done) {
+						closesocket(client.sock);
+						if (i != clients.size() - 1) client = std::move(clients.back());
+						clients.pop_back();
+					}
+				}
+
+				if (fds[0].revents & POLLRDNORM) {
+					while (clients.size() < max_clients) {
+						const SOCKET sock = accept(listener, nullptr, nullptr);
+						if (sock == INVALID_SOCKET) break;
+						u_long nonblocking = 1;
+						ioctlsocket(sock, FIONBIO, &nonblocking);
+						clients.push_back({sock});
+						clients.back().deadline = now + client_timeout;
+					}
+				}
+			}
+		}
+	}
+}
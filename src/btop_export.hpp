@@ -0,0 +1,81 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <filesystem>
+
+#include <btop_shared.hpp>
+
+using std::string, std::vector, std::atomic;
+
+//* Headless batch mode started with argument "--batch", collectors run on the scheduler and one record is written
+//* per update_ms interval as JSON Lines or CSV without initializing the terminal, draw or input layers
+namespace Export {
+
+	//* Sections that can be selected with "--batch-fields"
+	const vector<string> valid_fields = { "cpu", "cores", "mem", "disks", "net", "procs" };
+
+	//* Set by argument "--batch"
+	extern bool active;
+
+	//* Output format, "json" or "csv"
+	extern string format;
+
+	//* File to append records to, stdout if empty
+	extern std::filesystem::path file;
+
+	//* Comma separated list of sections from <valid_fields> to include in each record
+	extern string fields;
+
+	//* Number of processes included in section "procs", highest cpu usage first
+	extern int top_procs;
+
+	//* Number of records to write before quitting, 0 for no limit
+	extern int count;
+
+	//* Open output and set up collectors for batch mode, called before Shared::init(). Throws std::runtime_error on failure
+	void init();
+
+	//* Collect the selected sections and write one record, returns false when <count> records has been written
+	bool write();
+
+	//* Flush and close output, safe to call from any thread
+	void close();
+
+	//* Prometheus text format endpoint on 127.0.0.1 at config value metrics_port, serving the last collected data at "/metrics".
+	//* Each box is rendered once per collect by the runner and requests are answered from an immutable snapshot of the result
+	namespace Metrics {
+
+		//* Number of processes exported, highest cpu usage first
+		const size_t top_procs = 10;
+
+		//* Port currently wanted by config, the listener thread idles while 0
+		extern atomic<int> port;
+
+		//* Render the boxes that was collected, nullptr for boxes not collected, and publish a new snapshot. Called by the runner
+		void update(const Cpu::cpu_info* cpu, const Mem::mem_info* mem,
+					const unordered_flat_map<string, Net::net_info>* net, const vector<Proc::proc_info>* procs);
+
+		//* Listener thread, binds to metrics_port when set and rebinds when it changes
+		void serve();
+	}
+}
@@ -35,9 +35,12 @@ tab-size = 4
 #include <btop_shared.hpp>
 #include <btop_menu.hpp>
 #include <btop_draw.hpp>
+#include <btop_perf.hpp>
+#include <btop_record.hpp>
+#include <btop_remote.hpp>
 #include <signal.h>
 
-using std::cin, std::vector, std::string_literals::operator""s;
+using std::cin, std::vector, std::max, std::string_literals::operator""s;
 using namespace Tools;
 namespace rng = std::ranges;
 
@@ -83,22 +86,71 @@ namespace Input {
 	int last_mouse_button = 0;
 	string old_filter;
 
+	//? Auto-reset event used to wake up a thread blocked in poll() from set_interrupt()
+	HANDLE wake_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+
+	void set_interrupt() {
+		interrupt = true;
+		SetEvent(wake_event);
+	}
+
+	//* Consume input records at the front of the buffer that wouldn't produce a key and collapse runs of mouse moves into the last one
+	//* Returns true if a record is left for get(), sets <resized> if a window resize event was consumed
+	bool drain(HANDLE handleIn, bool& resized) {
+		array<INPUT_RECORD, 64> recs;
+		DWORD count = 0;
+		while (PeekConsoleInput(handleIn, recs.data(), (DWORD)recs.size(), &count) and count > 0) {
+			DWORD skip = 0;
+			for (; skip < count; skip++) {
+				const auto& rec = recs[skip];
+				const bool next_is_move = (skip + 1 < count and recs[skip + 1].EventType == MOUSE_EVENT
+											and recs[skip + 1].Event.MouseEvent.dwEventFlags == MOUSE_MOVED);
+				if (rec.EventType == WINDOW_BUFFER_SIZE_EVENT) resized = true;
+				else if (not ((rec.EventType == KEY_EVENT and not rec.Event.KeyEvent.bKeyDown)
+					or rec.EventType == FOCUS_EVENT or rec.EventType == MENU_EVENT
+					or (rec.EventType == MOUSE_EVENT and rec.Event.MouseEvent.dwEventFlags == MOUSE_MOVED
+						and (rec.Event.MouseEvent.dwButtonState == 0 or next_is_move))))
+					break;
+			}
+			if (skip == 0) return true;
+			DWORD read;
+			if (not ReadConsoleInput(handleIn, recs.data(), skip, &read))
+				throw std::runtime_error("Failed reading input!");
+			if (skip < count) return true;
+		}
+		return false;
+	}
+
 	bool poll(int timeout) {
-		HANDLE handleIn = GetStdHandle(STD_INPUT_HANDLE);
-		DWORD waiting;
-		
-		while (timeout > 0) {
+		static const HANDLE handleIn = GetStdHandle(STD_INPUT_HANDLE);
+		const array<HANDLE, 2> handles = { wake_event, handleIn };
+		const uint64_t deadline = steady_ms() + max(0, timeout);
+
+		while (true) {
 			if (interrupt) {
 				interrupt = false;
 				return false;
 			}
-			if (not GetNumberOfConsoleInputEvents(handleIn, &waiting))
-				throw std::runtime_error("Failed getting number of input events!");
-			if (waiting > 0) return true;
-			sleep_ms(timeout < 10 ? timeout : 10);
-			timeout -= 10;
+
+			//? Input handle is signaled while there is anything in the buffer, remove records that would never produce a key
+			//? and return early on resize to let the main loop check the terminal size
+			bool resized = false;
+			if (drain(handleIn, resized)) return true;
+			if (resized) return false;
+
+			const uint64_t now = steady_ms();
+			if (now >= deadline) return false;
+
+			//? Sleep until input arrives, set_interrupt() is called or timeout
+			switch (WaitForMultipleObjects((DWORD)handles.size(), handles.data(), FALSE, (DWORD)(deadline - now))) {
+				case WAIT_TIMEOUT:
+					return false;
+				case WAIT_FAILED:
+					throw std::runtime_error("Failed waiting for input events!");
+				default:
+					continue;
+			}
 		}
-		return false;
 	}
 
 	string get() {
@@ -112,7 +164,7 @@ namespace Input {
 
 		if (cNumRead > 0) {
 			if (iRec.EventType == WINDOW_BUFFER_SIZE_EVENT) {
-				Input::interrupt = true;
+				set_interrupt();
 				return "";
 			}
 			else if (iRec.EventType == KEY_EVENT and iRec.Event.KeyEvent.bKeyDown) {
@@ -216,6 +268,32 @@ namespace Input {
 					Runner::run("all", false, true);
 					return;
 				}
+				else if (Record::Replay::active and is_in(key, "space", "+", "-", "<", ">", "[", "]", "replay_seek")) {
+					if (key == "space")
+						Record::Replay::paused = not Record::Replay::paused;
+					else if (is_in(key, "+", "-")) {
+						const auto& speeds = Record::Replay::speeds;
+						const int index = (int)(rng::find(speeds, Record::Replay::speed.load()) - speeds.begin()) + (key == "+" ? 1 : -1);
+						Record::Replay::speed = speeds.at(std::clamp(index, 0, (int)speeds.size() - 1));
+					}
+					else if (key == "replay_seek") {
+						const auto& pos = mouse_mappings.at("replay_seek");
+						Record::Replay::seek_to((double)(mouse_pos[0] - pos.col) / max(1, pos.width - 1));
+					}
+					else
+						Record::Replay::seek((key == "<" or key == ">" ? 10'000 : 600'000) * (key == "<" or key == "[" ? -1 : 1));
+					Runner::run("all", false, true);
+					return;
+				}
+				else if (key == "Z" and not Record::Replay::active) {
+					Draw::zoom = (Draw::zoom + 1) % (int)Draw::zoom_names.size();
+					Runner::run("all", true, true);
+					return;
+				}
+				else if (key == "f12" and Trace::enabled) {
+					Trace::dump();
+					return;
+				}
 				else if (is_in(key, "p", "P") and Config::preset_list.size() > 1) {
 					if (key == "p") {
 						if (++Config::current_preset >= (int)Config::preset_list.size()) Config::current_preset = 0;
@@ -295,6 +373,9 @@ namespace Input {
 					Proc::filter = { Config::getS("proc_filter") };
 					old_filter = Proc::filter.text;
 				}
+				else if (is_in(key, "<", ">") and not Config::getB("proc_services")) {
+					Record::Flight::scrub_time = Record::Flight::step(Record::Flight::scrub_time, (key == "<" ? -1 : 1));
+				}
 				else if (key == "e" and not Config::getB("proc_services")) {
 					Config::flip("proc_tree");
 					no_update = false;
@@ -380,7 +461,7 @@ namespace Input {
 					if (key == "-" or key == "space") Proc::collapse = pid;
 					no_update = false;
 				}
-				else if (is_in(key, "t", kill_key) and (Config::getB("show_detailed") or Config::getI("selected_pid") > 0 or not Config::getS("selected_name").empty())) {
+				else if (is_in(key, "t", kill_key) and not Remote::viewer and (Config::getB("show_detailed") or Config::getI("selected_pid") > 0 or not Config::getS("selected_name").empty())) {
 					atomic_wait(Runner::active);
 					if (not Config::getB("proc_services") and Config::getB("show_detailed") and Config::getI("proc_selected") == 0 and Proc::detailed.status == "Stopped") return;
 					Menu::show(Menu::Menus::SignalSend);
@@ -396,7 +477,7 @@ namespace Input {
 					Menu::show(Menu::Menus::SignalConfig);
 					return;
 				}
-				else if (key == "s") {
+				else if (key == "s" and not Remote::viewer) {
 					atomic_wait(Runner::active);
 					Config::flip("proc_services");
 					Config::set("proc_selected", 0);
@@ -419,6 +500,8 @@ namespace Input {
 				else keep_going = true;
 
 				if (not keep_going) {
+					//? Only selection and mouse actions clear redraw, let the runner skip collect and redraw changed rows only
+					Proc::selection_only = (no_update and not redraw);
 					Runner::run("proc", no_update, redraw);
 					return;
 				}
@@ -432,19 +515,19 @@ namespace Input {
 				static uint64_t last_press = 0;
 
 				if (key == "+" and Config::getI("update_ms") <= 86399900) {
-					int add = (Config::getI("update_ms") <= 86399000 and last_press >= time_ms() - 200
+					int add = (Config::getI("update_ms") <= 86399000 and last_press >= steady_ms() - 200
 						and rng::all_of(Input::history, [](const auto& str){ return str == "+"; })
 						? 1000 : 100);
 					Config::set("update_ms", Config::getI("update_ms") + add);
-					last_press = time_ms();
+					last_press = steady_ms();
 					redraw = true;
 				}
 				else if (key == "-" and Config::getI("update_ms") >= 200) {
-					int sub = (Config::getI("update_ms") >= 2000 and last_press >= time_ms() - 200
+					int sub = (Config::getI("update_ms") >= 2000 and last_press >= steady_ms() - 200
 						and rng::all_of(Input::history, [](const auto& str){ return str == "-"; })
 						? 1000 : 100);
 					Config::set("update_ms", Config::getI("update_ms") - sub);
-					last_press = time_ms();
+					last_press = steady_ms();
 					redraw = true;
 				}
 				else keep_going = true;
@@ -50,7 +50,11 @@ namespace Input {
 	//* Last entered key
 	extern deque<string> history;
 
-	//* Poll keyboard & mouse input for <timeout> ms and return input availabilty as a bool
+	//* Set interrupt and wake up poll() if it's currently waiting, safe to call from any thread
+	void set_interrupt();
+
+	//* Wait for keyboard & mouse input for max <timeout> ms and return input availabilty as a bool
+	//* Blocks on the console input handle, returns early on interrupt or terminal resize
 	bool poll(int timeout=0);
 
 	//* Get a key or mouse action from input
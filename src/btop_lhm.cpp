@@ -0,0 +1,219 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#include <numeric>
+#include <functional>
+
+#include <btop_lhm.hpp>
+
+namespace Lhm {
+
+	bool Tokenizer::next(Line& line) {
+		while (pos < data.size()) {
+			size_t end = data.find('\n', pos);
+			if (end == string_view::npos) end = data.size();
+			string_view row = data.substr(pos, end - pos);
+			pos = end + 1;
+			number++;
+
+			if (row.ends_with('\r')) row.remove_suffix(1);
+			const size_t first = row.find('\t');
+			if (first == string_view::npos) continue;
+			const size_t second = row.find('\t', first + 1);
+			if (second == string_view::npos or second + 1 == row.size()) continue;
+
+			line.name = row.substr(0, first);
+			line.type = row.substr(first + 1, second - first - 1);
+			line.value = row.substr(second + 1, row.find('\t', second + 1) - second - 1);
+			return true;
+		}
+		return false;
+	}
+
+	void Errors::add(const size_t line_number, const Line& line) {
+		if (count++ == 0) {
+			this->line = line_number;
+			reason = "invalid value \"" + string(line.value) + "\" for " + string(line.type) + " sensor \"" + string(line.name) + '"';
+		}
+	}
+
+	size_t sensor_key(const Line& line) {
+		const std::hash<string_view> hash;
+		return hash(line.name) ^ (hash(line.type) * 31);
+	}
+
+	Mapping compile(const string_view output) {
+		Mapping mapping;
+		bool isGPU = false;
+		bool hasPackage = false;
+		bool hasGPUload = false;
+
+		Tokenizer lines(output);
+		Line line;
+		while (lines.next(line)) {
+			const auto& [name, type, value] = line;
+			const size_t n = mapping.lines = lines.line_number();
+			auto add = [&](const Slot slot) { mapping.sensors.push_back({n, slot, isGPU ? mapping.gpus.size() - 1 : 0, sensor_key(line)}); };
+
+			//? New sensor section
+			if (name == "Hardware") {
+				mapping.headers.push_back({n, string(type), string(value)});
+				isGPU = value.contains("Gpu");
+				if (isGPU) {
+					mapping.gpus.emplace_back(type.empty() ? value : type);
+					hasGPUload = false;
+				}
+			}
+			else if (isGPU) {
+				if (name.starts_with("GPU Core")) {
+					if (type == "Clock") add(Slot::gpu_clock);
+					else if (type == "Temperature") add(Slot::gpu_temp);
+					else if (type == "Load") {
+						add(Slot::gpu_load);
+						hasGPUload = true;
+					}
+				}
+				else if (not hasGPUload and name.starts_with("D3D 3D") and type == "Load")
+					add(Slot::gpu_d3d_load);
+				else if (name.starts_with("GPU Memory Used") or name == "D3D Shared Memory Used")
+					add(Slot::gpu_mem_used);
+				else if (name.starts_with("GPU Memory Total"))
+					add(Slot::gpu_mem_total);
+			}
+			else {
+				//? Cpu clock - using highest found value because an average of all cores doesn't do well on systems with efficiency cores
+				if ((name.starts_with("CPU Core") or name.starts_with("Core #")) and type == "Clock")
+					add(Slot::cpu_clock);
+				//? Cpu core and package temp, motherboard sensors are only used as fallback if found before the package sensor
+				else if (type == "Temperature") {
+					if (name.starts_with("CPU Core #") and not name.contains("TjMax"))
+						add(Slot::cpu_core_temp);
+					else if (not hasPackage and (name.starts_with("CPU Package") or name == "Core (Tctl/Tdie)")) {
+						add(Slot::cpu_package_temp);
+						hasPackage = true;
+					}
+					else if (not hasPackage and name == "CPU")
+						add(Slot::mb_cpu_temp);
+					else if (not hasPackage and name == "System")
+						add(Slot::mb_system_temp);
+				}
+			}
+		}
+		return mapping;
+	}
+
+	bool extract(const string_view output, const Mapping& mapping, Cpu::OHMRraw& stats, Errors& errors) {
+		if (mapping.lines == 0) return false;
+		auto& cpu_temps = stats.CPU;
+		auto& cpu_clock = stats.CpuClock;
+		bool hasPackage = false;
+		int package = 0;
+		int mb_cpu = 0;
+		int mb_system = 0;
+
+		//? Entry of the gpu for the current sensor, only added to stats.GPUS when a value for it is found
+		size_t gpu_index = mapping.gpus.size();
+		Cpu::GpuRaw* gpu_ptr = nullptr;
+
+		Tokenizer lines(output);
+		Line line;
+		auto header = mapping.headers.begin();
+		auto sensor = mapping.sensors.begin();
+
+		//? Parse value of current line to <out>, records an error and returns false if malformed
+		auto number = [&](auto& out) {
+			if (to_number(line.value, out)) return true;
+			errors.add(lines.line_number(), line);
+			return false;
+		};
+		auto gpu = [&]() -> Cpu::GpuRaw& {
+			if (gpu_index != sensor->gpu) {
+				gpu_index = sensor->gpu;
+				gpu_ptr = &stats.GPUS[mapping.gpus[gpu_index]];
+			}
+			return *gpu_ptr;
+		};
+
+		while (lines.next(line)) {
+			const size_t n = lines.line_number();
+			if (n > mapping.lines) return false;
+
+			if (line.name == "Hardware") {
+				if (header == mapping.headers.end() or header->line != n or header->name != line.type or header->id != line.value) return false;
+				++header;
+				continue;
+			}
+			if (sensor == mapping.sensors.end() or sensor->line != n) continue;
+			if (sensor->key != sensor_key(line)) return false;
+
+			switch (sensor->slot) {
+			case Slot::cpu_clock:
+				if (int clock; number(clock) and clock > cpu_clock) cpu_clock = clock;
+				break;
+			case Slot::cpu_core_temp:
+				if (int temp; number(temp)) cpu_temps.push_back(temp);
+				break;
+			case Slot::cpu_package_temp:
+				hasPackage = number(package);
+				break;
+			case Slot::mb_cpu_temp:
+				number(mb_cpu);
+				break;
+			case Slot::mb_system_temp:
+				number(mb_system);
+				break;
+			case Slot::gpu_clock:
+				gpu().clock_mhz = string(line.value) + " Mhz";
+				break;
+			case Slot::gpu_temp:
+				if (int temp; number(temp)) gpu().temp = temp;
+				break;
+			case Slot::gpu_load:
+			case Slot::gpu_d3d_load:
+				if (int usage; number(usage)) {
+					auto& g = gpu();
+					g.usage = usage;
+					g.cpu_gpu = (sensor->slot == Slot::gpu_d3d_load);
+				}
+				break;
+			case Slot::gpu_mem_used:
+				if (long long mem; number(mem)) gpu().mem_used = mem << 20ll;
+				break;
+			case Slot::gpu_mem_total:
+				if (long long mem; number(mem)) gpu().mem_total = mem << 20ll;
+				break;
+			}
+			++sensor;
+		}
+		if (lines.line_number() != mapping.lines or header != mapping.headers.end()) return false;
+
+		stats.GPUorder = mapping.gpus;
+
+		if (hasPackage)
+			cpu_temps.insert(cpu_temps.begin(), package);
+		else if (mb_cpu > 0)
+			cpu_temps.insert(cpu_temps.begin(), mb_cpu);
+		else if (not cpu_temps.empty()) {
+			cpu_temps.insert(cpu_temps.begin(), std::accumulate(cpu_temps.begin(), cpu_temps.end(), 0) / (int)cpu_temps.size());
+		}
+		else if (mb_system > 0)
+			cpu_temps.insert(cpu_temps.begin(), mb_system);
+
+		return true;
+	}
+}
@@ -0,0 +1,111 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+
+#include <btop_shared.hpp>
+
+using std::string, std::string_view, std::vector;
+
+//* Parsing of the sensor values returned by FetchLHMValues() from LHM-CppExport (https://github.com/aristocratos/LHM-CppExport).
+//* The output has one sensor per line as "<name>\t<type>\t<value>", each hardware section starts with a line "Hardware\t<name>\t<identifier>"
+namespace Lhm {
+
+	//* Fields of a line, views into the output passed to the Tokenizer
+	struct Line {
+		string_view name, type, value;
+	};
+
+	//* Single pass split of output into lines and tab separated fields without copying, lines with less than 3 fields are skipped
+	class Tokenizer {
+		string_view data;
+		size_t pos = 0;
+		size_t number = 0;
+	public:
+		explicit Tokenizer(const string_view data) : data(data) {}
+
+		//* Get the next line with at least 3 fields, returns false at the end of output
+		bool next(Line& line);
+
+		//* 1-based line number of the last line returned by next()
+		size_t line_number() const { return number; }
+	};
+
+	//* Parse a leading integer in <value> to <out> the same way std::stoi() does, any fraction is ignored.
+	//* Returns false if <value> doesn't start with a number or the number doesn't fit in <T>
+	template <typename T>
+	bool to_number(string_view value, T& out) {
+		while (not value.empty() and value.front() == ' ') value.remove_prefix(1);
+		if (not value.empty() and value.front() == '+') value.remove_prefix(1);
+		return std::from_chars(value.data(), value.data() + value.size(), out).ec == std::errc{};
+	}
+
+	//* Malformed values found while parsing, lines with errors are skipped and the rest of the output is still used
+	struct Errors {
+		size_t count = 0;
+
+		//? Line number and description of the first error
+		size_t line = 0;
+		string reason;
+
+		void add(const size_t line_number, const Line& line);
+	};
+
+	//* Destination in OHMRraw of a sensor line
+	enum class Slot : uint8_t {
+		cpu_clock, cpu_core_temp, cpu_package_temp, mb_cpu_temp, mb_system_temp,
+		gpu_clock, gpu_temp, gpu_load, gpu_d3d_load, gpu_mem_used, gpu_mem_total
+	};
+
+	//* Hash of the name and type of a sensor line
+	size_t sensor_key(const Line& line);
+
+	//* Sensor layout of the output, maps line numbers to slots so values can be extracted without matching sensor names every update
+	struct Mapping {
+		struct Sensor {
+			size_t line;
+			Slot slot;
+			size_t gpu;	//? Index in <gpus> for gpu slots
+			size_t key;	//? sensor_key() of the line, catches sensors moved within a section
+		};
+		struct Header {
+			size_t line;
+			string name, id;
+		};
+
+		//? Line number of the last line with at least 3 fields, 0 if the output had no sensor lines
+		size_t lines = 0;
+		vector<Header> headers;
+		vector<Sensor> sensors;
+
+		//? Gpu names in the order of the output, used for OHMRraw::GPUorder
+		vector<string> gpus;
+	};
+
+	//* Find the role of each line in <output> by name and build the mapping, only needed again when the layout changes
+	Mapping compile(const string_view output);
+
+	//* Read values from <output> into <stats> by their position in <mapping>.
+	//* Returns false without a complete <stats> if the line count, any hardware header or the name or type of a mapped sensor differs from <mapping>
+	bool extract(const string_view output, const Mapping& mapping, Cpu::OHMRraw& stats, Errors& errors);
+}
@@ -120,6 +120,10 @@ namespace Menu {
 		{"F1, h", "Shows this window."},
 		{"q, ctrl + c", "Quits program."},
 		{"+, -", "Add/Subtract 100ms to/from update timer."},
+		{"shift + z", "Cycle graph time scale, latest/10s/1m/10m."},
+		{"Replay space", "Pause/resume replay of a recording."},
+		{"Replay +, -", "Increase/decrease replay speed, 1x-100x."},
+		{"Replay <, >, [, ]", "Seek 10 seconds or 10 minutes back/forward."},
 		{"Up, Down", "Select in process list."},
 		{"Enter", "Show detailed information for selected process."},
 		{"Spacebar", "Expand/collapse the selected process in tree view."},
@@ -136,6 +140,7 @@ namespace Menu {
 		{"c", "Toggle per-core cpu usage of processes."},
 		{"r", "Reverse sorting order in processes box."},
 		{"e", "Toggle processes tree view."},
+		{"<, >", "Step back/forward through recorded process lists."},
 		{"s", "Toggle services/processes."},
 		{"Selected +, -", "Expand/collapse the selected process in tree view."},
 		{"Selected t", "Terminate selected process"},
@@ -248,6 +253,80 @@ namespace Menu {
 				"",
 				"Min value: 100 ms",
 				"Max value: 86400000 ms = 24 hours."},
+			{"update_ms_cpu",
+				"Update time for the cpu box in ms.",
+				"",
+				"0 to use the main update time (update_ms).",
+				"",
+				"Lower values give smoother cpu graphs",
+				"without also updating the process list.",
+				"",
+				"Min value: 100 ms",
+				"Max value: 86400000 ms = 24 hours."},
+			{"update_ms_mem",
+				"Update time for the mem box in ms.",
+				"",
+				"0 to use the main update time (update_ms).",
+				"",
+				"Disk IO is shown as a per second rate",
+				"regardless of update time.",
+				"",
+				"Min value: 100 ms",
+				"Max value: 86400000 ms = 24 hours."},
+			{"update_ms_net",
+				"Update time for the net box in ms.",
+				"",
+				"0 to use the main update time (update_ms).",
+				"",
+				"Net speeds are calculated over the",
+				"actual time between updates.",
+				"",
+				"Min value: 100 ms",
+				"Max value: 86400000 ms = 24 hours."},
+			{"update_ms_proc",
+				"Update time for the proc box in ms.",
+				"",
+				"0 to use the main update time (update_ms).",
+				"",
+				"The process scan is the most expensive",
+				"collection, a higher value saves cpu time.",
+				"",
+				"Min value: 100 ms",
+				"Max value: 86400000 ms = 24 hours."},
+			{"cpu_sample_ms",
+				"Cpu sample time in ms between updates.",
+				"",
+				"0 to disable.",
+				"",
+				"Cpu usage is read in the background at",
+				"this rate and the peak of the samples is",
+				"shown in the core graphs and as cpu",
+				"graph \"max\", catching short bursts.",
+				"",
+				"Min value: 10 ms",
+				"Max value: 1000 ms"},
+			{"adaptive_sampling",
+				"Adapt update times to system activity.",
+				"",
+				"The process list is updated up to 4 times",
+				"less often while the top processes and",
+				"total cpu usage stay the same.",
+				"",
+				"Cpu and process updates run at double",
+				"rate for 10 seconds when cpu usage",
+				"crosses the adaptive threshold.",
+				"",
+				"Current rates are shown in the cpu box."},
+			{"adaptive_threshold",
+				"Cpu usage that triggers faster updates.",
+				"",
+				"Percent of total cpu, or of the selected",
+				"process in the process box.",
+				"",
+				"Only used with adaptive sampling.",
+				"",
+				"Min value: 1",
+				"Max value: 100"},
 			{"rounded_corners",
 				"Rounded corners on boxes.",
 				"",
@@ -315,7 +394,34 @@ namespace Menu {
 				"\"ERROR\", \"WARNING\", \"INFO\" and \"DEBUG\".",
 				"",
 				"The level set includes all lower levels,",
-				"i.e. \"DEBUG\" will show all logging info."}
+				"i.e. \"DEBUG\" will show all logging info."},
+			{"record_segment_mb",
+				"Size of each recording file in MiB.",
+				"",
+				"Used when started with argument",
+				"\"--record\", a new file is started",
+				"when the current one reaches this size.",
+				"",
+				"Takes effect on next start."},
+			{"record_max_mb",
+				"Max size of all recordings in MiB.",
+				"",
+				"The oldest recording files are removed",
+				"when the total size is exceeded.",
+				"",
+				"0 to keep all recordings.",
+				"",
+				"Takes effect on next start."},
+			{"metrics_port",
+				"Port for the metrics endpoint.",
+				"",
+				"Serves the latest collected data in",
+				"Prometheus text format at",
+				"http://127.0.0.1:<port>/metrics",
+				"",
+				"Only reachable from this machine.",
+				"",
+				"0 to disable."}
 		},
 		{
 			{"cpu_bottom",
@@ -338,6 +444,7 @@ namespace Menu {
 				"\"total\" = Total cpu usage.",
 				"\"user\" = User mode cpu usage.",
 				"\"system\" = Kernel mode cpu usage.",
+				"\"max\" = Peak cpu usage, see cpu_sample_ms.",
 				"+ more depending on kernel."},
 			{"cpu_graph_lower",
 				"Cpu lower graph.",
@@ -348,6 +455,7 @@ namespace Menu {
 				"\"total\" = Total cpu usage.",
 				"\"user\" = User mode cpu usage.",
 				"\"system\" = Kernel mode cpu usage.",
+				"\"max\" = Peak cpu usage, see cpu_sample_ms.",
 				"+ more depending on kernel."},
 			{"cpu_invert_lower",
 					"Toggles orientation of the lower CPU graph.",
@@ -596,6 +704,16 @@ namespace Menu {
 				" ",
 				"Will show percentage of total memory",
 				"if False."},
+			{"flight_recorder_mb",
+				"Process list recording in MiB.",
+				"",
+				"Memory used to record process lists",
+				"for stepping back and forward in time",
+				"with \"<\" and \">\" in the process box.",
+				"",
+				"Oldest recordings are dropped when full.",
+				"",
+				"0 to disable."},
 		}
 	};
 
@@ -1167,7 +1285,7 @@ namespace Menu {
 		else if (is_in(key, "left", "right") or (vim_keys and is_in(key, "h", "l"))) {
 			const auto& option = categories[selected_cat][item_height * page + selected][0];
 			if (selPred.test(isInt)) {
-				const int mod = (option == "update_ms" ? 100 : 1);
+				const int mod = (option.starts_with("update_ms") ? 100 : (option == "cpu_sample_ms" ? 10 : (option == "record_max_mb" ? 64 : 1)));
 				long value = Config::getI(option);
 				if (key == "right" or (vim_keys and key == "l")) value += mod;
 				else value -= mod;
@@ -1210,7 +1328,7 @@ namespace Menu {
 					theme_refresh = true;
 				else if (option == "log_level") {
 					Logger::set(optList.at(i));
-					Logger::info("Logger set to " + optList.at(i));
+					Logger::info("Logger set to ", optList.at(i));
 				}
 				else if (is_in(option, "proc_sorting", "services_sorting", "cpu_sensor") or option.starts_with("graph_symbol") or option.starts_with("cpu_graph_"))
 					screen_redraw = true;
@@ -0,0 +1,369 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#include <vector>
+#include <array>
+#include <deque>
+#include <bit>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <utility>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#define VC_EXTRALEAN
+#include <windows.h>
+
+#include <btop_perf.hpp>
+#include <btop_tools.hpp>
+#include <btop_config.hpp>
+#include <btop_theme.hpp>
+
+using std::vector, std::array, std::deque;
+namespace fs = std::filesystem;
+
+namespace Trace {
+	atomic<bool> enabled (false);
+
+	namespace {
+		//? Number of spans kept per thread, must be a power of two
+		constexpr uint64_t ring_size = 8192;
+
+		struct Event {
+			const char* name;
+			const char* cat;
+			uint64_t start;
+			uint64_t duration;
+		};
+
+		//* Slot sequence is odd while the event is being written and (index + 1) * 2 once event number <index> is complete
+		struct Slot {
+			atomic<uint64_t> seq = 0;
+			Event event;
+		};
+
+		//* Single producer ring, only written by the owning thread, <head> is published with release ordering
+		struct Ring {
+			DWORD tid;
+			string name;
+			atomic<uint64_t> head = 0;
+			std::unique_ptr<Slot[]> slots = std::make_unique<Slot[]>(ring_size);
+		};
+
+		//? Only locked when a thread registers its ring or when writing the trace file
+		std::mutex rings_lock;
+		vector<std::unique_ptr<Ring>> rings;
+		thread_local Ring* local_ring = nullptr;
+
+		Ring& get_ring() {
+			if (local_ring == nullptr) {
+				auto ring = std::make_unique<Ring>();
+				ring->tid = GetCurrentThreadId();
+				ring->name = "thread " + to_string(ring->tid);
+				std::lock_guard lock(rings_lock);
+				local_ring = rings.emplace_back(std::move(ring)).get();
+			}
+			return *local_ring;
+		}
+
+		string json_escape(const string& str) {
+			string out;
+			out.reserve(str.size());
+			for (const char c : str) {
+				if (c == '"' or c == '\\') out += '\\';
+				if ((unsigned char)c >= 0x20) out += c;
+			}
+			return out;
+		}
+	}
+
+	void thread_name(const char* name) {
+		if (not enabled) return;
+		auto& ring = get_ring();
+		std::lock_guard lock(rings_lock);
+		ring.name = name;
+	}
+
+	void record(const char* name, const char* cat, const uint64_t start, const uint64_t duration) {
+		auto& ring = get_ring();
+		const auto head = ring.head.load(std::memory_order_relaxed);
+		auto& slot = ring.slots[head & (ring_size - 1)];
+		slot.seq.store((head + 1) * 2 - 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.event = {name, cat, start, duration};
+		slot.seq.store((head + 1) * 2, std::memory_order_release);
+		ring.head.store(head + 1, std::memory_order_release);
+	}
+
+	bool write(const fs::path& path) {
+		std::ofstream file(path, std::ios::trunc);
+		if (not file.good()) return false;
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+			 << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"btop4win\"}}";
+
+		vector<Event> events;
+		std::lock_guard lock(rings_lock);
+		for (const auto& ring : rings) {
+			file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->tid
+				 << ",\"args\":{\"name\":\"" << json_escape(ring->name) << "\"}}";
+
+			//? Copy without stopping the producer, a slot is only kept if its sequence is unchanged across the copy
+			//? and still belongs to event <i>, slots overwritten or being written during the copy are discarded
+			const uint64_t head = ring->head.load(std::memory_order_acquire);
+			const uint64_t tail = (head > ring_size ? head - ring_size : 0);
+			events.clear();
+			for (uint64_t i = tail; i < head; i++) {
+				const auto& slot = ring->slots[i & (ring_size - 1)];
+				const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+				if (seq != (i + 1) * 2) continue;
+				const Event event = slot.event;
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+				events.push_back(event);
+			}
+
+			for (const auto& [name, cat, start, duration] : events) {
+				file << ",\n{\"name\":\"" << name << "\",\"cat\":\"" << cat << "\",\"ph\":\"X\",\"ts\":" << start
+					 << ",\"dur\":" << duration << ",\"pid\":1,\"tid\":" << ring->tid << "}";
+			}
+		}
+		file << "\n]}\n";
+		return file.good();
+	}
+
+	fs::path dump() {
+		fs::path path = Config::conf_dir / ("btop_trace_" + Tools::strf_time("%Y%m%d_%H%M%S") + ".json");
+		if (not write(path)) {
+			Logger::warning("Failed to write trace file: " + path.string());
+			return {};
+		}
+		Logger::info("Wrote trace file: ", path.string());
+		return path;
+	}
+}
+
+namespace Perf {
+	atomic<bool> enabled (false);
+	atomic<uint64_t> dropped_frames (0);
+
+	namespace {
+		//? Log-linear buckets, exact below 16 and 8 sub buckets per power of two above
+		constexpr int linear_max = 16;
+		constexpr int sub_bits = 3;
+		constexpr int max_bits = 40;
+		constexpr int bucket_count = linear_max + (max_bits - 4) * (1 << sub_bits);
+
+		//? 10 second slots, 6 slots for the 1 minute window and 30 slots for the 5 minute window
+		constexpr int64_t slot_seconds = 10;
+		constexpr int64_t short_slots = 6;
+		constexpr int64_t slot_count = 30;
+
+		//? Number of frames shown in the frame time sparkline
+		constexpr size_t spark_len = width - 4;
+
+		inline int bucket_index(uint64_t value) {
+			if (value < linear_max) return (int)value;
+			value = std::min<uint64_t>(value, (1ull << max_bits) - 1);
+			const int msb = std::bit_width(value) - 1;
+			return linear_max + (msb - 4) * (1 << sub_bits) + (int)((value >> (msb - sub_bits)) & ((1 << sub_bits) - 1));
+		}
+
+		//? Middle value of bucket <index>, keeps the error within half a bucket
+		inline uint64_t bucket_value(const int index) {
+			if (index < linear_max) return index;
+			const int msb = (index - linear_max) / (1 << sub_bits) + 4;
+			const uint64_t sub = (index - linear_max) % (1 << sub_bits);
+			return (((1ull << sub_bits) + sub) << (msb - sub_bits)) + (1ull << (msb - sub_bits - 1));
+		}
+
+		inline size_t slot_index(const int64_t epoch) {
+			return (size_t)(((epoch % slot_count) + slot_count) % slot_count);
+		}
+
+		//* Histogram ring of <slot_count> time slots, keeps running sums for both windows so adding a sample is O(1)
+		class Rolling {
+			array<array<uint32_t, bucket_count>, slot_count> slots{};
+			array<uint64_t, slot_count> slot_max{};
+			array<uint32_t, bucket_count> sum_short{};
+			array<uint32_t, bucket_count> sum_long{};
+			int64_t epoch = -1;
+			uint64_t last = 0;
+
+			void advance(const int64_t now_epoch) {
+				if (epoch < 0 or now_epoch - epoch >= slot_count) {
+					for (auto& slot : slots) slot.fill(0);
+					slot_max.fill(0);
+					sum_short.fill(0);
+					sum_long.fill(0);
+					epoch = now_epoch;
+					return;
+				}
+				while (epoch < now_epoch) {
+					epoch++;
+					const auto& leaving = slots[slot_index(epoch - short_slots)];
+					auto& reused = slots[slot_index(epoch)];
+					for (int i = 0; i < bucket_count; i++) {
+						sum_short[i] -= leaving[i];
+						sum_long[i] -= reused[i];
+					}
+					reused.fill(0);
+					slot_max[slot_index(epoch)] = 0;
+				}
+			}
+
+		public:
+			void add(const uint64_t value, const int64_t now_epoch) {
+				advance(now_epoch);
+				const int index = bucket_index(value);
+				slots[slot_index(epoch)][index]++;
+				sum_short[index]++;
+				sum_long[index]++;
+				auto& cur_max = slot_max[slot_index(epoch)];
+				if (value > cur_max) cur_max = value;
+				last = value;
+			}
+
+			summary get(const int minutes, const int64_t now_epoch) {
+				advance(now_epoch);
+				const bool is_short = (minutes <= 1);
+				const auto& sum = (is_short ? sum_short : sum_long);
+				summary out;
+				out.last = last;
+				for (int64_t i = 0; i < (is_short ? short_slots : slot_count); i++)
+					out.max = std::max(out.max, slot_max[slot_index(epoch - i)]);
+				for (const auto& count : sum) out.samples += count;
+				if (out.samples == 0) return out;
+
+				const array<uint64_t, 3> ranks = {
+					(out.samples * 50 + 99) / 100,
+					(out.samples * 95 + 99) / 100,
+					(out.samples * 99 + 99) / 100
+				};
+				array<uint64_t*, 3> targets = {&out.p50, &out.p95, &out.p99};
+				uint64_t cumulative = 0;
+				size_t next = 0;
+				for (int i = 0; i < bucket_count and next < ranks.size(); i++) {
+					cumulative += sum[i];
+					while (next < ranks.size() and cumulative >= ranks[next])
+						*targets[next++] = std::min(bucket_value(i), out.max);
+				}
+				return out;
+			}
+		};
+
+		std::mutex perf_lock;
+		std::unique_ptr<array<Rolling, stage_count>> rolling;
+		deque<uint64_t> frame_times;
+		uint64_t input_time = 0; //? Only accessed from the main thread
+
+		inline int64_t current_epoch() {
+			return (int64_t)(Trace::now() / 1'000'000) / slot_seconds;
+		}
+
+		string fmt_time(const uint64_t value) {
+			if (value < 10'000) return to_string(value) + "us";
+			if (value < 10'000'000) return to_string(value / 1000) + "ms";
+			return to_string(value / 1'000'000) + "s";
+		}
+
+		const array<string, stage_count> stage_names = {
+			"cpu col", "cpu draw", "mem col", "mem draw", "net col", "net draw", "proc col", "proc draw",
+			"write", "frame", "bytes", "input", "*WMI", "*LHM"
+		};
+	}
+
+	void add(const stages stage, const uint64_t value) {
+		if (not enabled) return;
+		const auto epoch = current_epoch();
+		std::lock_guard lock(perf_lock);
+		if (not rolling) rolling = std::make_unique<array<Rolling, stage_count>>();
+		rolling->at(stage).add(value, epoch);
+		if (stage == frame_total) {
+			frame_times.push_back(value);
+			if (frame_times.size() > spark_len) frame_times.pop_front();
+		}
+	}
+
+	summary get(const stages stage, const int minutes) {
+		const auto epoch = current_epoch();
+		std::lock_guard lock(perf_lock);
+		if (not rolling) return {};
+		return rolling->at(stage).get(minutes, epoch);
+	}
+
+	void input_mark() {
+		if (enabled) input_time = Trace::now();
+	}
+
+	uint64_t input_take() {
+		return std::exchange(input_time, 0);
+	}
+
+	string draw(const int x, const int y) {
+		using namespace Tools;
+		const auto draw_start = Trace::now();
+		static const array<string, 8> spark_symbols = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+		const auto& main_fg = Theme::c("main_fg");
+		const auto& div_fg = Theme::c("div_line");
+		static uint64_t last_draw_time = 0;
+
+		string out = Mv::to(y + 1, x + 1) + Theme::c("title") + Fx::b + ljust(" Stage", 9) + rjust("now", 7)
+			+ div_fg + " │" + Theme::c("title") + rjust("1m p50", 7) + rjust("p95", 7) + rjust("p99", 7) + rjust("max", 7)
+			+ div_fg + " │" + Theme::c("title") + rjust("5m p50", 7) + rjust("p95", 7) + rjust("p99", 7) + rjust("max", 7) + Fx::ub;
+
+		uint64_t samples_short = 0, samples_long = 0;
+		for (int i = 0; i < stage_count; i++) {
+			const auto stage = (stages)i;
+			const auto fmt = [&stage](const uint64_t value) {
+				return (stage == frame_bytes ? floating_humanizer(value, true) : fmt_time(value));
+			};
+			const auto one = get(stage, 1);
+			const auto five = get(stage, 5);
+			if (stage == frame_total) {
+				samples_short = one.samples;
+				samples_long = five.samples;
+			}
+			out += Mv::to(y + 2 + i, x + 1) + (stage == frame_total ? Fx::b : "") + main_fg + ljust(" " + stage_names[i], 9) + rjust(fmt(one.last), 7)
+				+ div_fg + " │" + main_fg + rjust(fmt(one.p50), 7) + rjust(fmt(one.p95), 7) + rjust(fmt(one.p99), 7) + rjust(fmt(one.max), 7)
+				+ div_fg + " │" + main_fg + rjust(fmt(five.p50), 7) + rjust(fmt(five.p95), 7) + rjust(fmt(five.p99), 7) + rjust(fmt(five.max), 7) + Fx::ub;
+		}
+
+		//? Sparkline of total frame time for the last frames, scaled to the highest visible value
+		deque<uint64_t> frames;
+		{
+			std::lock_guard lock(perf_lock);
+			frames = frame_times;
+		}
+		const uint64_t spark_max = (frames.empty() ? 0 : *std::max_element(frames.begin(), frames.end()));
+		out += Mv::to(y + 2 + stage_count, x + 1) + Theme::c("title") + " Frame time, last " + to_string(frames.size())
+			+ " frames (max " + fmt_time(spark_max) + ")" + Mv::to(y + 3 + stage_count, x + 2) + string(spark_len - frames.size(), ' ');
+		for (const auto& value : frames) {
+			const int level = (spark_max == 0 ? 0 : (int)std::min<uint64_t>(7, value * 8 / (spark_max + 1)));
+			out += Theme::g("cpu").at(std::min(100, (level + 1) * 100 / 8)) + spark_symbols[level];
+		}
+
+		out += Mv::to(y + 4 + stage_count, x + 1) + main_fg + " Samples 1m: " + to_string(samples_short) + "  5m: " + to_string(samples_long)
+			+ "  Dropped: " + to_string(dropped_frames.load()) + "  HUD: " + fmt_time(last_draw_time);
+
+		last_draw_time = Trace::now() - draw_start;
+		return out;
+	}
+}
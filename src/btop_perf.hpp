@@ -0,0 +1,125 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+using std::string, std::atomic;
+
+//* Span recorder for exporting thread timelines in Chrome trace-event format (chrome://tracing, ui.perfetto.dev)
+namespace Trace {
+
+	//* Set by argument "--trace", spans are only recorded when true
+	extern atomic<bool> enabled;
+
+	//* Microseconds since program start from a monotonic clock
+	inline uint64_t now() {
+		static const auto epoch = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	//* Name the calling thread in the trace output, also registers the threads ring buffer
+	void thread_name(const char* name);
+
+	//* Store a finished span in the calling threads ring buffer, <name> and <cat> must be string literals
+	void record(const char* name, const char* cat, const uint64_t start, const uint64_t duration);
+
+	//* RAII span, records the time from construction until destruction or end()
+	class Span {
+		const char* name;
+		const char* cat;
+		uint64_t start = 0;
+		bool active = false;
+	public:
+		Span(const char* name, const char* cat = "btop") : name(name), cat(cat) {
+			if (enabled.load(std::memory_order_relaxed)) {
+				start = now();
+				active = true;
+			}
+		}
+		~Span() { end(); }
+		Span(const Span&) = delete;
+		Span& operator=(const Span&) = delete;
+
+		void end() {
+			if (active) {
+				active = false;
+				record(name, cat, start, now() - start);
+			}
+		}
+	};
+
+	//* Write all buffered spans as trace-event JSON to <path>, returns false on failure
+	bool write(const std::filesystem::path& path);
+
+	//* Write trace to a timestamped file in config directory and return the path, empty path on failure
+	std::filesystem::path dump();
+}
+
+//* Rolling latency histograms per runner stage for the performance HUD shown in debug mode
+namespace Perf {
+
+	//* Set when starting in debug mode, samples are only stored when true
+	extern atomic<bool> enabled;
+
+	//* Number of frames replaced by a newer frame before the terminal writer got to them
+	extern atomic<uint64_t> dropped_frames;
+
+	enum stages {
+		cpu_collect, cpu_draw,
+		mem_collect, mem_draw,
+		net_collect, net_draw,
+		proc_collect, proc_draw,
+		output_write,
+		frame_total,
+		frame_bytes,
+		input_latency,
+		wmi_collect,
+		lhm_collect,
+		stage_count
+	};
+
+	//* Size of the box needed for the HUD
+	const int width = 78;
+	const int height = 20;
+
+	//* Latest value and percentiles of a stage for a time window, times in microseconds
+	struct summary {
+		uint64_t last = 0, p50 = 0, p95 = 0, p99 = 0, max = 0, samples = 0;
+	};
+
+	//* Add a sample for <stage>, safe to call from any thread
+	void add(const stages stage, const uint64_t value);
+
+	//* Get summary of <stage> over the last <minutes>, only 1 and 5 are tracked
+	summary get(const stages stage, const int minutes);
+
+	//* Mark the time an input event was read, called from the main thread before processing it
+	void input_mark();
+
+	//* Returns and clears the time of the last input event not yet handed to a frame, 0 if none.
+	//* Called by Runner::run() to measure input to screen latency, and after input processing to drop inputs not causing a redraw
+	uint64_t input_take();
+
+	//* Returns the HUD content for a box with top left corner at <x>, <y>
+	string draw(const int x, const int y);
+}
@@ -0,0 +1,833 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#include <deque>
+#include <array>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <fstream>
+#include <utility>
+#include <ranges>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#define VC_EXTRALEAN
+#include <windows.h>
+
+#include <btop_record.hpp>
+#include <btop_series.hpp>
+#include <btop_tools.hpp>
+#include <btop_config.hpp>
+#include <btop_perf.hpp>
+
+using std::deque, std::array, std::pair, std::min, std::max, std::clamp;
+namespace fs = std::filesystem;
+namespace rng = std::ranges;
+using namespace Tools;
+
+namespace Record::Flight {
+	atomic<uint64_t> scrub_time (0);
+	atomic<uint64_t> scrub_wall (0);
+
+	namespace {
+		//? Number of delta frames between key frames, a key frame is also forced when the deltas outgrow the last key frame
+		constexpr size_t key_interval = 60;
+
+		//* Fields tracked between key frames, everything else is kept from when the process was first seen
+		struct Change {
+			uint32_t pid;
+			uint32_t threads;
+			uint64_t mem;
+			float cpu_p;
+		};
+
+		struct Frame {
+			uint64_t time, wall;
+			bool key = false;
+			vector<Proc::proc_info> spawned;
+			vector<Change> changed;
+			vector<uint32_t> exited;
+			size_t bytes = 0;
+		};
+
+		std::mutex lock;
+		deque<Frame> frames;
+		size_t total_bytes = 0, key_frames = 0;
+
+		//? State after the newest frame, pid -> (process, generation last seen)
+		unordered_flat_map<size_t, std::pair<Proc::proc_info, uint64_t>> current;
+		uint64_t generation = 0;
+		size_t since_key = 0, delta_bytes = 0, key_bytes = 0;
+
+		size_t proc_bytes(const Proc::proc_info& p) {
+			return sizeof(Proc::proc_info) + p.name.size() + p.cmd.size() + p.short_cmd.size() + p.user.size();
+		}
+
+		void clear() {
+			frames.clear();
+			current.clear();
+			total_bytes = key_frames = since_key = delta_bytes = key_bytes = 0;
+			scrub_time = 0;
+		}
+	}
+
+	void add(const vector<Proc::proc_info>& procs) {
+		const size_t max_bytes = (size_t)Config::getI("flight_recorder_mb") << 20;
+		std::lock_guard lck(lock);
+		if (max_bytes == 0) {
+			if (not frames.empty()) clear();
+			return;
+		}
+
+		Frame frame{steady_ms(), time_ms()};
+		frame.key = (frames.empty() or since_key >= key_interval or delta_bytes > key_bytes);
+		generation++;
+
+		for (const auto& p : procs) {
+			auto [it, inserted] = current.try_emplace(p.pid, p, generation);
+			auto& [state, seen] = it->second;
+			seen = generation;
+
+			//? A reused pid is stored as an exit of the old process and a spawn of the new one, start time can be 0 until known
+			const bool reused = (not inserted and (state.name != p.name or (state.cpu_s != 0 and p.cpu_s != 0 and state.cpu_s != p.cpu_s)));
+			if (reused and not frame.key) frame.exited.push_back((uint32_t)p.pid);
+			if (state.cpu_s == 0) state.cpu_s = p.cpu_s;
+
+			if (inserted or reused or frame.key) {
+				if (not inserted) state = p;
+				frame.spawned.push_back(p);
+				frame.bytes += proc_bytes(p);
+			}
+			else if (state.cpu_p != p.cpu_p or state.mem != p.mem or state.threads != p.threads) {
+				state.cpu_p = p.cpu_p;
+				state.mem = p.mem;
+				state.threads = p.threads;
+				frame.changed.push_back({(uint32_t)p.pid, (uint32_t)p.threads, p.mem, (float)p.cpu_p});
+			}
+		}
+
+		//? Processes not in <procs> have exited, key frames hold the full list and don't need to record them
+		for (auto it = current.begin(); it != current.end();) {
+			if (it->second.second != generation) {
+				if (not frame.key) frame.exited.push_back((uint32_t)it->first);
+				it = current.erase(it);
+			}
+			else ++it;
+		}
+
+		frame.bytes += sizeof(Frame) + frame.changed.size() * sizeof(Change) + frame.exited.size() * sizeof(uint32_t);
+		if (frame.key) {
+			key_frames++;
+			key_bytes = frame.bytes;
+			since_key = delta_bytes = 0;
+		}
+		else {
+			since_key++;
+			delta_bytes += frame.bytes;
+		}
+		total_bytes += frame.bytes;
+		frames.push_back(std::move(frame));
+
+		//? Evict the oldest key frame together with its deltas, the newest key frame group is always kept
+		while (total_bytes > max_bytes and key_frames > 1) {
+			do {
+				total_bytes -= frames.front().bytes;
+				frames.pop_front();
+			} while (not frames.front().key);
+			key_frames--;
+		}
+	}
+
+	uint64_t get(const uint64_t time, vector<Proc::proc_info>& out, const string& filter) {
+		std::lock_guard lck(lock);
+		if (frames.empty() or time < frames.front().time) return 0;
+
+		const auto end = rng::upper_bound(frames, time, rng::less{}, &Frame::time);
+		auto it = end - 1;
+		const uint64_t wall = it->wall;
+		while (not it->key) --it;
+
+		unordered_flat_map<size_t, Proc::proc_info> procs;
+		procs.reserve(it->spawned.size());
+		for (; it != end; ++it) {
+			//? Exits first, a reused pid is both exited and spawned in the same frame
+			for (const auto& pid : it->exited) procs.erase(pid);
+			for (const auto& p : it->spawned) procs.insert_or_assign(p.pid, p);
+			for (const auto& c : it->changed) {
+				if (auto found = procs.find(c.pid); found != procs.end()) {
+					auto& p = found->second;
+					p.cpu_p = c.cpu_p;
+					p.mem = c.mem;
+					p.threads = c.threads;
+				}
+			}
+		}
+
+		//? Tree layout isn't stored, snapshots are shown as a flat list
+		out.clear();
+		out.reserve(procs.size());
+		for (auto& [pid, p] : procs) {
+			p.prefix.clear();
+			p.depth = 0;
+			p.collapsed = false;
+			p.filtered = (not filter.empty()
+				and not s_contains(std::to_string(p.pid), filter)
+				and not s_contains_ic(p.name, filter)
+				and not s_contains_ic(p.cmd, filter)
+				and not s_contains_ic(p.user, filter));
+			out.push_back(std::move(p));
+		}
+		return wall;
+	}
+
+	uint64_t step(const uint64_t time, const int steps) {
+		std::lock_guard lck(lock);
+		if (frames.empty()) return 0;
+
+		long long index = (long long)frames.size();
+		if (time > 0)
+			index = max(0ll, (long long)(rng::upper_bound(frames, time, rng::less{}, &Frame::time) - frames.begin()) - 1);
+
+		index += steps;
+		if (index >= (long long)frames.size()) return 0;
+		return frames.at(max(0ll, index)).time;
+	}
+
+	size_t bytes() {
+		std::lock_guard lck(lock);
+		return total_bytes;
+	}
+}
+
+namespace Record::Disk {
+	atomic<bool> enabled (false);
+	fs::path dir;
+
+	namespace {
+		enum boxes { cpu_box, mem_box, net_box, proc_box, box_count };
+
+		struct Sample {
+			uint64_t time = 0;
+			array<bool, box_count> collected{};
+			array<vector<pair<string, double>>, box_count> boxes;
+			vector<pair<string, string>> strings;
+		};
+
+		std::mutex lock;
+		std::condition_variable cv;
+		vector<Sample> queue;
+		constexpr size_t max_queue = 1000;
+		bool stopping = false, running = false, dropped = false;
+
+		//? Writer thread state, latest values of each box are repeated until the box is collected again
+		array<vector<pair<string, double>>, box_count> latest;
+
+		Series::Block block;
+
+		std::ofstream file;
+		uint64_t file_bytes = 0, segment_bytes = 0, max_bytes = 0;
+
+		//? Missing values and graph gaps are stored as NaN
+		const double missing = std::numeric_limits<double>::quiet_NaN();
+
+		double value_of(const deque<long long>& data) {
+			return (data.empty() or data.back() == graph_gap ? missing : (double)data.back());
+		}
+
+		//* Remove the oldest segments while all segments are above max_bytes, the open segment is never removed
+		void cleanup(const fs::path& current) {
+			if (max_bytes == 0) return;
+			std::error_code ec;
+			vector<pair<fs::path, uint64_t>> segments;
+			uint64_t total = 0;
+			for (const auto& entry : fs::directory_iterator(dir, ec)) {
+				const string name = entry.path().filename().string();
+				if (not name.starts_with("btop_") or not name.ends_with(".rec") or not entry.is_regular_file(ec)) continue;
+				const uint64_t size = entry.file_size(ec);
+				segments.push_back({entry.path(), size});
+				total += size;
+			}
+			rng::sort(segments);
+			for (const auto& [path, size] : segments) {
+				if (total <= max_bytes) break;
+				if (path == current) continue;
+				if (fs::remove(path, ec)) total -= size;
+				else Logger::warning("Failed to remove old recording: " + path.string());
+			}
+		}
+
+		bool open_segment() {
+			if (file.is_open()) file.close();
+			fs::path path = dir / ("btop_" + strf_time("%Y%m%d_%H%M%S") + ".rec");
+			for (int i = 1; fs::exists(path); i++)
+				path = dir / ("btop_" + strf_time("%Y%m%d_%H%M%S") + "_" + to_string(i) + ".rec");
+
+			file.open(path, std::ios::binary);
+			if (not file.good()) {
+				Logger::error("Failed to create recording file: " + path.string());
+				return false;
+			}
+			file.write(file_magic.data(), file_magic.size());
+			file_bytes = file_magic.size();
+			cleanup(path);
+			return true;
+		}
+
+		//* Serialize and write the current block, opens a new segment when the current one is full
+		void write_block() {
+			if (block.samples == 0 or not file.is_open()) return;
+			vector<char> buf;
+			block.write(buf);
+			const uint32_t size = (uint32_t)buf.size();
+
+			file.write(buf.data(), buf.size());
+			file.flush();
+			if (not file.good()) {
+				Logger::error("Failed to write recording, recording stopped.");
+				file.close();
+				enabled = false;
+				return;
+			}
+			file_bytes += size;
+			if (file_bytes >= segment_bytes and not open_segment()) enabled = false;
+		}
+
+		void encode(Sample& sample) {
+			for (int i = 0; i < box_count; i++) {
+				if (sample.collected[i]) latest[i] = std::move(sample.boxes[i]);
+			}
+
+			//? A new block is started when full or when the set of series changes
+			size_t count = 0;
+			bool same = (block.samples > 0 and block.samples < block_samples);
+			for (const auto& values : latest) {
+				for (const auto& [name, value] : values) {
+					if (same and (count >= block.names.size() or block.names[count] != name)) same = false;
+					count++;
+				}
+			}
+			if (not same or count != block.names.size()) {
+				write_block();
+				block = {};
+				block.start = sample.time;
+				block.names.reserve(count);
+				for (const auto& values : latest) {
+					for (const auto& [name, value] : values) block.names.push_back(name);
+				}
+				block.values.resize(count);
+			}
+
+			block.times.add(sample.time);
+			size_t i = 0;
+			for (const auto& values : latest) {
+				for (const auto& [name, value] : values) block.values[i++].add(value);
+			}
+			for (auto& [key, value] : sample.strings) block.strings.insert_or_assign(std::move(key), std::move(value));
+			block.end = sample.time;
+			block.samples++;
+		}
+
+		void _writer() {
+			Trace::thread_name("recorder");
+			vector<Sample> batch;
+			while (true) {
+				bool stop = false;
+				{
+					std::unique_lock lck(lock);
+					cv.wait(lck, [] { return stopping or not queue.empty(); });
+					batch.swap(queue);
+					stop = stopping;
+				}
+				for (auto& sample : batch) encode(sample);
+				batch.clear();
+				if (stop) {
+					write_block();
+					file.close();
+					std::lock_guard lck(lock);
+					running = false;
+					cv.notify_all();
+					return;
+				}
+			}
+		}
+	}
+
+	bool start() {
+		segment_bytes = (uint64_t)max(1, Config::getI("record_segment_mb")) << 20;
+		max_bytes = (uint64_t)Config::getI("record_max_mb") << 20;
+		std::error_code ec;
+		if (not fs::is_directory(dir, ec) and not fs::create_directories(dir, ec)) {
+			Logger::error("Failed to create recording directory: " + dir.string());
+			enabled = false;
+			return false;
+		}
+		if (not open_segment()) {
+			enabled = false;
+			return false;
+		}
+		running = true;
+		std::thread(_writer).detach();
+		Logger::info("Recording to ", dir.string());
+		return true;
+	}
+
+	void stop() {
+		std::unique_lock lck(lock);
+		if (not running) return;
+		enabled = false;
+		stopping = true;
+		cv.notify_all();
+		cv.wait_for(lck, std::chrono::seconds(5), [] { return not running; });
+	}
+
+	void add(const uint64_t time, const Cpu::cpu_info* cpu, const Mem::mem_info* mem,
+			 const unordered_flat_map<string, Net::net_info>* net, const vector<Proc::proc_info>* procs) {
+		{
+			std::lock_guard lck(lock);
+			if (not running) return;
+		}
+		Sample sample;
+		sample.time = time;
+
+		if (cpu != nullptr) {
+			auto& values = sample.boxes[cpu_box];
+			for (const auto& [field, data] : cpu->cpu_percent) values.push_back({"cpu." + field, value_of(data)});
+			for (size_t i = 0; i < cpu->core_percent.size(); i++) values.push_back({"cpu.core." + to_string(i), value_of(cpu->core_percent[i])});
+			for (size_t i = 0; i < cpu->core_max.size(); i++) values.push_back({"cpu.core_max." + to_string(i), value_of(cpu->core_max[i])});
+			for (size_t i = 0; i < cpu->temp.size(); i++) values.push_back({"cpu.temp." + to_string(i), value_of(cpu->temp[i])});
+			values.push_back({"cpu.gpu_temp", value_of(cpu->gpu_temp)});
+			sample.collected[cpu_box] = true;
+		}
+
+		if (mem != nullptr) {
+			auto& values = sample.boxes[mem_box];
+			for (const auto& [name, value] : mem->stats) values.push_back({"mem." + name, (double)value});
+			for (const auto& [name, data] : mem->percent) values.push_back({"mem.percent." + name, value_of(data)});
+			for (const auto& name : mem->disks_order) {
+				const auto& disk = mem->disks.at(name);
+				const string prefix = "disk." + name + '.';
+				values.push_back({prefix + "total", (double)disk.total});
+				values.push_back({prefix + "used", (double)disk.used});
+				values.push_back({prefix + "free", (double)disk.free});
+				values.push_back({prefix + "io_read", value_of(disk.io_read)});
+				values.push_back({prefix + "io_write", value_of(disk.io_write)});
+				values.push_back({prefix + "io_activity", value_of(disk.io_activity)});
+			}
+			sample.collected[mem_box] = true;
+		}
+
+		if (net != nullptr) {
+			auto& values = sample.boxes[net_box];
+			for (const auto& [iface, info] : *net) {
+				for (const string dir : {"download", "upload"}) {
+					const string prefix = "net." + iface + '.' + dir + '.';
+					const auto& stat = info.stat.at(dir);
+					//? Interfaces skipped by adaptive sampling have no new values, they are recorded as missing
+					values.push_back({prefix + "speed", (info.stale ? missing : value_of(info.bandwidth.at(dir)))});
+					values.push_back({prefix + "top", (info.stale ? missing : (double)stat.top)});
+					values.push_back({prefix + "total", (info.stale ? missing : (double)stat.total)});
+				}
+			}
+			sample.collected[net_box] = true;
+		}
+
+		//? Top processes by cpu usage, always <top_procs> series so the series set stays the same
+		if (procs != nullptr) {
+			auto& values = sample.boxes[proc_box];
+			vector<const Proc::proc_info*> top;
+			top.reserve(procs->size());
+			for (const auto& p : *procs) top.push_back(&p);
+			const size_t count = min(top_procs, top.size());
+			rng::partial_sort(top, top.begin() + count, rng::greater{}, &Proc::proc_info::cpu_p);
+			for (size_t i = 0; i < top_procs; i++) {
+				const string prefix = "proc." + to_string(i) + '.';
+				const Proc::proc_info* p = (i < count ? top[i] : nullptr);
+				values.push_back({prefix + "pid", (p != nullptr ? (double)p->pid : missing)});
+				values.push_back({prefix + "cpu", (p != nullptr ? p->cpu_p : missing)});
+				values.push_back({prefix + "mem", (p != nullptr ? (double)p->mem : missing)});
+				values.push_back({prefix + "threads", (p != nullptr ? (double)p->threads : missing)});
+				if (p != nullptr) {
+					const string key = "proc." + to_string(p->pid) + '.';
+					sample.strings.push_back({key + "name", p->name});
+					sample.strings.push_back({key + "cmd", p->cmd});
+					sample.strings.push_back({key + "user", p->user});
+				}
+			}
+			sample.collected[proc_box] = true;
+		}
+
+		{
+			std::lock_guard lck(lock);
+			if (not running) return;
+			//? Drop samples rather than growing without bound if the disk can't keep up
+			if (queue.size() >= max_queue) {
+				if (not dropped) Logger::warning("Recording writer can't keep up, dropping samples.");
+				dropped = true;
+				return;
+			}
+			queue.push_back(std::move(sample));
+		}
+		cv.notify_one();
+	}
+}
+
+namespace Record::Replay {
+	atomic<bool> active (false);
+	fs::path path;
+	atomic<bool> paused (false);
+	atomic<int> speed (1);
+
+	namespace {
+		using Disk::file_magic, Series::BlockRef;
+		const double missing = std::numeric_limits<double>::quiet_NaN();
+
+		struct Mapping {
+			HANDLE file = INVALID_HANDLE_VALUE, map = nullptr;
+			const char* data = nullptr;
+			size_t size = 0;
+		};
+		vector<Mapping> mappings;
+
+		vector<BlockRef> blocks;
+
+		struct Decoded : Series::Decoded {
+			size_t index = 0;
+		};
+
+		//? Most recently used decoded blocks at the back, shared so a block stays valid for its holder after eviction
+		constexpr size_t cache_size = 32;
+		deque<std::shared_ptr<const Decoded>> cache;
+
+		std::mutex lock;
+		uint64_t pos = 0, last_fill = 0, last_time = 0;
+		bool jumped = true;
+
+		void map_file(const fs::path& file) {
+			Mapping m;
+			m.file = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (m.file == INVALID_HANDLE_VALUE) {
+				Logger::warning("Failed to open recording: " + file.string());
+				return;
+			}
+			LARGE_INTEGER size;
+			if (not GetFileSizeEx(m.file, &size) or size.QuadPart <= (LONGLONG)file_magic.size()
+			or (m.map = CreateFileMappingW(m.file, nullptr, PAGE_READONLY, 0, 0, nullptr)) == nullptr
+			or (m.data = (const char*)MapViewOfFile(m.map, FILE_MAP_READ, 0, 0, 0)) == nullptr) {
+				if (m.map != nullptr) CloseHandle(m.map);
+				CloseHandle(m.file);
+				return;
+			}
+			m.size = (size_t)size.QuadPart;
+			if (string(m.data, file_magic.size()) != file_magic) {
+				Logger::warning("Not a btop recording: " + file.string());
+				UnmapViewOfFile(m.data);
+				CloseHandle(m.map);
+				CloseHandle(m.file);
+				return;
+			}
+
+			//? Index block headers, a truncated block at the end of a segment still being written is skipped
+			BlockRef ref;
+			for (size_t offset = file_magic.size(); Series::index(m.data + offset, m.size - offset, ref); offset += ref.size) {
+				if (ref.samples > 0) blocks.push_back(ref);
+			}
+			mappings.push_back(m);
+		}
+
+		std::shared_ptr<const Decoded> decode(const size_t index) {
+			if (auto it = rng::find_if(cache, [&](const auto& cached) { return cached->index == index; }); it != cache.end()) {
+				auto found = std::move(*it);
+				cache.erase(it);
+				cache.push_back(found);
+				return found;
+			}
+			if (cache.size() >= cache_size) cache.pop_front();
+
+			const auto& ref = blocks.at(index);
+			auto decoded = std::make_shared<Decoded>();
+			decoded->index = index;
+			if (not Series::decode(ref, *decoded))
+				Logger::warning("Corrupt block in recording at " + strf_time("%Y-%m-%d %H:%M:%S", ref.start / 1000));
+			cache.push_back(decoded);
+			return decoded;
+		}
+
+		//* Where the value of a series goes, graph series push to <graph> and the rest overwrite a scalar
+		struct Slot {
+			deque<long long>* graph = nullptr;
+			uint64_t* u64 = nullptr;
+			int64_t* i64 = nullptr;
+			double* f64 = nullptr;
+		};
+
+		//? Latest values of the recorded top processes, pid, cpu, mem and threads
+		array<array<double, 4>, Disk::top_procs> top;
+
+		size_t index_after(const string& name, const string& prefix) {
+			return (size_t)std::stoul(name.substr(prefix.size()));
+		}
+
+		//* Create containers for all series of <block> first, then take pointers since the containers can reallocate
+		vector<Slot> resolve(const Decoded& block, Cpu::cpu_info& cpu, Mem::mem_info& mem, unordered_flat_map<string, Net::net_info>& net) {
+			vector<Slot> slots(block.names.size());
+			for (const int pass : {0, 1}) {
+				for (size_t i = 0; i < block.names.size(); i++) {
+					const string& name = block.names[i];
+					auto& slot = slots[i];
+					try {
+						if (name.starts_with("cpu.core.") or name.starts_with("cpu.core_max.") or name.starts_with("cpu.temp.")) {
+							const bool is_max = name.starts_with("cpu.core_max."), is_temp = name.starts_with("cpu.temp.");
+							auto& list = (is_max ? cpu.core_max : (is_temp ? cpu.temp : cpu.core_percent));
+							const size_t n = index_after(name, (is_max ? "cpu.core_max." : (is_temp ? "cpu.temp." : "cpu.core.")));
+							if (pass == 0 and n >= list.size()) list.resize(n + 1);
+							else if (pass == 1) slot.graph = &list.at(n);
+						}
+						else if (name == "cpu.gpu_temp") {
+							if (pass == 1) slot.graph = &cpu.gpu_temp;
+						}
+						else if (name.starts_with("cpu.")) {
+							if (pass == 0) cpu.cpu_percent[name.substr(4)];
+							else slot.graph = &cpu.cpu_percent.at(name.substr(4));
+						}
+						else if (name.starts_with("mem.percent.")) {
+							if (pass == 0) mem.percent[name.substr(12)];
+							else slot.graph = &mem.percent.at(name.substr(12));
+						}
+						else if (name.starts_with("mem.")) {
+							if (pass == 0) mem.stats[name.substr(4)];
+							else slot.u64 = &mem.stats.at(name.substr(4));
+						}
+						else if (name.starts_with("disk.")) {
+							const size_t dot = name.rfind('.');
+							const string mount = name.substr(5, dot - 5), field = name.substr(dot + 1);
+							if (pass == 0) {
+								if (not mem.disks.contains(mount)) {
+									mem.disks[mount].name = mount;
+									mem.disks_order.push_back(mount);
+								}
+								continue;
+							}
+							auto& disk = mem.disks.at(mount);
+							if (field == "total") slot.i64 = &disk.total;
+							else if (field == "used") slot.i64 = &disk.used;
+							else if (field == "free") slot.i64 = &disk.free;
+							else if (field == "io_read") slot.graph = &disk.io_read;
+							else if (field == "io_write") slot.graph = &disk.io_write;
+							else if (field == "io_activity") slot.graph = &disk.io_activity;
+						}
+						else if (name.starts_with("net.")) {
+							const size_t field_dot = name.rfind('.'), dir_dot = name.rfind('.', field_dot - 1);
+							const string iface = name.substr(4, dir_dot - 4), dir = name.substr(dir_dot + 1, field_dot - dir_dot - 1), field = name.substr(field_dot + 1);
+							if (pass == 0) {
+								net[iface].connected = true;
+								continue;
+							}
+							auto& info = net.at(iface);
+							if (not info.stat.contains(dir)) continue;
+							if (field == "speed") {
+								slot.graph = &info.bandwidth.at(dir);
+								slot.u64 = &info.stat.at(dir).speed;
+							}
+							else if (field == "top") slot.u64 = &info.stat.at(dir).top;
+							else if (field == "total") slot.u64 = &info.stat.at(dir).total;
+						}
+						else if (name.starts_with("proc.") and pass == 1) {
+							const size_t dot = name.rfind('.');
+							const size_t rank = index_after(name.substr(0, dot), "proc.");
+							const string field = name.substr(dot + 1);
+							const size_t f = (field == "pid" ? 0 : (field == "cpu" ? 1 : (field == "mem" ? 2 : 3)));
+							if (rank < top.size()) slot.f64 = &top[rank][f];
+						}
+					}
+					catch (const std::exception&) {
+						//? Series from a newer or damaged recording are skipped
+						slot = {};
+					}
+				}
+			}
+			return slots;
+		}
+	}
+
+	void open() {
+		std::error_code ec;
+		vector<fs::path> files;
+		if (fs::is_directory(path, ec)) {
+			for (const auto& entry : fs::directory_iterator(path, ec)) {
+				const string name = entry.path().filename().string();
+				if (name.starts_with("btop_") and name.ends_with(".rec")) files.push_back(entry.path());
+			}
+			rng::sort(files);
+		}
+		else files.push_back(path);
+
+		for (const auto& file : files) map_file(file);
+		rng::stable_sort(blocks, rng::less{}, &BlockRef::start);
+		if (blocks.empty()) throw std::runtime_error("No recorded samples found in " + path.string());
+
+		//? Layout of the cpu box depends on the core count of the recorded host
+		const auto block = decode(blocks.size() - 1);
+		const int cores = (int)rng::count_if(block->names, [](const auto& name) { return name.starts_with("cpu.core."); });
+		const int temps = (int)rng::count_if(block->names, [](const auto& name) { return name.starts_with("cpu.temp."); });
+		if (cores > 0) Shared::coreCount = cores;
+		Cpu::got_sensors = (temps > 0);
+		Cpu::cpu_temp_only = (temps == 1);
+
+		pos = blocks.front().start;
+		Logger::info("Replaying ", blocks.size(), " blocks from ", mappings.size(), " recording file(s)");
+	}
+
+	uint64_t first() {
+		return (blocks.empty() ? 0 : blocks.front().start);
+	}
+
+	uint64_t last() {
+		return (blocks.empty() ? 0 : blocks.back().end);
+	}
+
+	uint64_t position() {
+		std::lock_guard lck(lock);
+		return pos;
+	}
+
+	void seek(const int64_t offset) {
+		std::lock_guard lck(lock);
+		pos = clamp((int64_t)pos + offset, (int64_t)first(), (int64_t)last());
+		jumped = true;
+	}
+
+	void seek_to(const double fraction) {
+		std::lock_guard lck(lock);
+		pos = first() + (uint64_t)(clamp(fraction, 0.0, 1.0) * (last() - first()));
+		jumped = true;
+	}
+
+	int fill(Cpu::cpu_info& cpu, Mem::mem_info& mem, unordered_flat_map<string, Net::net_info>& net, vector<Proc::proc_info>& procs, const size_t samples) {
+		uint64_t time;
+		bool jump;
+		{
+			std::lock_guard lck(lock);
+			const uint64_t now = steady_ms();
+			if (not paused and last_fill > 0) pos += (now - last_fill) * speed;
+			if (pos >= last()) {
+				pos = last();
+				paused = true;
+			}
+			last_fill = now;
+			time = pos;
+			jump = std::exchange(jumped, false);
+		}
+		if (blocks.empty()) return 0;
+
+		//? Blocks ending at the position, walking back until enough samples for the graphs are found
+		const size_t end = max((size_t)1, (size_t)(rng::upper_bound(blocks, time, rng::less{}, &BlockRef::start) - blocks.begin()));
+		size_t begin = end - 1, count = rng::count_if(decode(begin)->times, [&](const uint64_t t) { return t <= time; });
+		while (begin > 0 and count < samples) count += blocks[--begin].samples;
+
+		for (auto& [field, data] : cpu.cpu_percent) data.clear();
+		cpu.core_percent.clear();
+		cpu.core_max.clear();
+		cpu.temp.clear();
+		cpu.gpu_temp.clear();
+		for (auto& [name, data] : mem.percent) data.clear();
+		mem.disks.clear();
+		mem.disks_order.clear();
+		net.clear();
+		for (auto& values : top) values.fill(missing);
+
+		uint64_t shown = 0, before = 0;
+		size_t skip = (count > samples ? count - samples : 0);
+		std::shared_ptr<const Decoded> newest;
+		for (size_t b = begin; b < end; b++) {
+			newest = decode(b);
+			const auto& block = *newest;
+			const auto slots = resolve(block, cpu, mem, net);
+			for (size_t s = 0; s < block.times.size() and block.times[s] <= time; s++) {
+				if (skip > 0) {
+					skip--;
+					continue;
+				}
+				for (size_t i = 0; i < slots.size(); i++) {
+					const double value = block.values[i][s];
+					const auto& slot = slots[i];
+					if (slot.graph != nullptr) slot.graph->push_back(std::isnan(value) ? graph_gap : (long long)value);
+					if (std::isnan(value)) continue;
+					if (slot.u64 != nullptr) *slot.u64 = (uint64_t)value;
+					if (slot.i64 != nullptr) *slot.i64 = (int64_t)value;
+					if (slot.f64 != nullptr) *slot.f64 = value;
+				}
+				before = std::exchange(shown, block.times[s]);
+			}
+		}
+
+		//? Draw functions expect the layout of the live host, fill in anything the recording is missing
+		const auto fix = [](deque<long long>& data) { if (data.empty()) data.push_back(0); };
+		for (auto& [field, data] : cpu.cpu_percent) fix(data);
+		cpu.core_percent.resize(Shared::coreCount);
+		cpu.core_max.resize(Shared::coreCount);
+		if (Cpu::got_sensors) cpu.temp.resize((Cpu::cpu_temp_only ? 1 : Shared::coreCount + 1));
+		for (auto* list : {&cpu.core_percent, &cpu.core_max, &cpu.temp}) for (auto& data : *list) fix(data);
+		fix(cpu.gpu_temp);
+
+		for (auto& [name, data] : mem.percent) fix(data);
+		Mem::totalMem = (int64_t)mem.stats.at("total");
+		Mem::disk_ios = 0;
+		for (auto& [mount, disk] : mem.disks) {
+			for (auto* data : {&disk.io_read, &disk.io_write, &disk.io_activity}) fix(*data);
+			disk.used_percent = (disk.total > 0 ? (int)std::round((double)disk.used * 100 / disk.total) : 0);
+			disk.free_percent = (disk.total > 0 ? 100 - disk.used_percent : 0);
+			Mem::disk_ios++;
+		}
+
+		Net::interfaces.clear();
+		for (const auto& [iface, info] : net) Net::interfaces.push_back(iface);
+		rng::sort(Net::interfaces);
+		if (not net.contains(Net::selected_iface))
+			Net::selected_iface = (Net::interfaces.empty() ? "" : Net::interfaces.front());
+		auto& selected = net[Net::selected_iface];
+		for (const string dir : {"download", "upload"}) {
+			fix(selected.bandwidth.at(dir));
+			Net::graph_max[dir] = max(10ll << 10, (long long)(rng::max(selected.bandwidth.at(dir)) * 1.2));
+		}
+
+		procs.clear();
+		for (const auto& [pid, cpu_p, mem_bytes, threads] : top) {
+			if (std::isnan(pid)) continue;
+			auto& p = procs.emplace_back();
+			p.pid = (size_t)pid;
+			p.cpu_p = (std::isnan(cpu_p) ? 0.0 : cpu_p);
+			p.mem = (std::isnan(mem_bytes) ? 0 : (uint64_t)mem_bytes);
+			p.threads = (std::isnan(threads) ? 0 : (size_t)threads);
+			if (newest != nullptr) {
+				const string key = "proc." + to_string(p.pid) + '.';
+				if (auto it = newest->strings.find(key + "name"); it != newest->strings.end()) p.name = p.short_cmd = it->second;
+				if (auto it = newest->strings.find(key + "cmd"); it != newest->strings.end()) p.cmd = it->second;
+				if (auto it = newest->strings.find(key + "user"); it != newest->strings.end()) p.user = it->second;
+			}
+		}
+
+		const int moved = (jump ? 2 : (shown == last_time ? 0 : (before == last_time ? 1 : 2)));
+		last_time = shown;
+		return moved;
+	}
+}
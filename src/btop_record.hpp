@@ -0,0 +1,118 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <filesystem>
+
+#include <btop_shared.hpp>
+
+using std::string, std::vector, std::atomic;
+
+//* Recording of collected data for looking back at earlier states
+namespace Record {
+
+	//* In-memory flight recorder of the process lists from Proc::collect(), stored as key frames followed by deltas
+	namespace Flight {
+
+		//* Time (Tools::steady_ms()) of the snapshot shown in the proc box, 0 when showing live data
+		extern atomic<uint64_t> scrub_time;
+
+		//* Wall clock time in milliseconds of the snapshot shown in the proc box, set by the runner
+		extern atomic<uint64_t> scrub_wall;
+
+		//* Store <procs> as a new snapshot, oldest snapshots are dropped when above config value flight_recorder_mb
+		void add(const vector<Proc::proc_info>& procs);
+
+		//* Rebuild the last snapshot at or before <time> into <out> with processes not matching <filter> marked as filtered.
+		//* Returns wall clock time in ms of the snapshot or 0 if none is retained
+		uint64_t get(const uint64_t time, vector<Proc::proc_info>& out, const string& filter);
+
+		//* Returns the time of the snapshot <steps> snapshots from <time> (0 for live), 0 when stepping past the newest snapshot
+		uint64_t step(const uint64_t time, const int steps);
+
+		//* Approximate memory used by retained snapshots in bytes
+		size_t bytes();
+	}
+
+	//* Compressed on-disk recording of all collected metrics, samples are encoded and written by a background thread.
+	//* Segment files start with <file_magic> followed by self contained Series blocks of up to <block_samples> samples,
+	//* timestamps are stored as delta-of-delta and values as XOR against the previous value of the same series
+	namespace Disk {
+		const string file_magic = "BTOPREC1";
+		constexpr uint32_t block_samples = 60;
+
+		//* Number of processes by cpu usage stored each sample
+		constexpr size_t top_procs = 10;
+
+		//* Set by argument "--record", samples are only queued when true
+		extern atomic<bool> enabled;
+
+		//* Directory for segment files, set by argument "--record <dir>", defaults to "recordings" in the config directory
+		extern std::filesystem::path dir;
+
+		//* Create directory and first segment and start the writer thread, disables recording and returns false on failure
+		bool start();
+
+		//* Write out queued samples and the current block, then stop the writer thread
+		void stop();
+
+		//* Queue values collected in a runner pass, boxes passed as nullptr keep the values from their last collect
+		void add(const uint64_t time, const Cpu::cpu_info* cpu, const Mem::mem_info* mem,
+				 const unordered_flat_map<string, Net::net_info>* net, const vector<Proc::proc_info>* procs);
+	}
+
+	//* Playback of recordings written by Disk, segment files are memory mapped and only block headers are read when opening,
+	//* blocks are decoded when needed around the current position and a limited number of decoded blocks are cached
+	namespace Replay {
+		//* Set by argument "--replay", collectors are replaced by samples read from the recording
+		extern atomic<bool> active;
+
+		//* Segment file or directory of segment files to play, set by argument "--replay <path>"
+		extern std::filesystem::path path;
+
+		extern atomic<bool> paused;
+
+		//* Playback speed multiplier, one of <speeds>
+		extern atomic<int> speed;
+		const array<int, 7> speeds = {1, 2, 5, 10, 20, 50, 100};
+
+		//* Map segment files and index their blocks, throws std::runtime_error if no recorded samples are found
+		void open();
+
+		//* Time in ms of the first and last recorded sample and of the current position
+		uint64_t first();
+		uint64_t last();
+		uint64_t position();
+
+		//* Move position <offset> ms forward or backward
+		void seek(const int64_t offset);
+
+		//* Move position to <fraction> (0.0-1.0) of the recording
+		void seek_to(const double fraction);
+
+		//* Advance position by the time since the last call multiplied by speed unless paused, then rebuild the data
+		//* with up to <samples> samples ending at the position. Returns 0 if the position is on the same sample as the
+		//* last call, 1 if it moved to the next sample and 2 for larger or backward moves where graphs needs a full redraw
+		int fill(Cpu::cpu_info& cpu, Mem::mem_info& mem, unordered_flat_map<string, Net::net_info>& net, vector<Proc::proc_info>& procs, const size_t samples);
+	}
+}
@@ -0,0 +1,698 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#include <array>
+#include <mutex>
+#include <thread>
+#include <cmath>
+#include <charconv>
+#include <stdexcept>
+#include <string_view>
+#include <ranges>
+#include <algorithm>
+
+#define _WIN32_WINNT 0x0600
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#define VC_EXTRALEAN
+#include <winsock2.h>
+#include <WS2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+
+#include <btop_remote.hpp>
+#include <btop_stream.hpp>
+#include <btop_shared.hpp>
+#include <btop_tools.hpp>
+#include <btop_config.hpp>
+#include <btop_perf.hpp>
+
+using std::string_view, std::array, std::deque, std::max, std::min, std::to_string;
+namespace rng = std::ranges;
+using namespace Tools;
+using namespace Stream;
+
+namespace Remote {
+	bool agent = false;
+	bool viewer = false;
+	string address;
+	int port = default_port;
+	string agent_name;
+
+	namespace {
+		//? Sent first in every greeting, bumped when the stream format changes
+		const string_view greeting = "btop4win";
+		const uint64_t protocol_version = 1;
+
+		//? Frames larger than this are treated as a corrupt stream by viewers
+		const uint32_t max_frame = 64 << 20;
+
+		//? Viewers falling this far behind are disconnected instead of buffering without limit
+		const size_t max_backlog = 16 << 20;
+
+		const size_t max_clients = 16;
+		const uint64_t reconnect_ms = 2000;
+		const uint64_t handshake_ms = 5000;
+
+		atomic<bool> stopping = false;
+
+		string endpoint() {
+			return (address.find(':') != string::npos ? '[' + address + ']' : address) + ':' + to_string(port);
+		}
+
+		//* Agent state, clients are added and removed by the network thread and frames are queued by publish()
+		struct Client {
+			SOCKET sock = INVALID_SOCKET;
+			string out;
+			size_t sent = 0;
+			bool keyed = false, dead = false;
+		};
+
+		SOCKET listener = INVALID_SOCKET;
+		std::mutex clients_lock;
+		vector<Client> clients;
+		string hello;
+		Encoder encoder;
+		string frame;
+		size_t since_key = key_interval;
+
+		//* Send as much of the backlog as the socket accepts, returns false if the connection failed
+		bool send_some(Client& client) {
+			while (client.sent < client.out.size()) {
+				const int n = send(client.sock, client.out.data() + client.sent, (int)min(client.out.size() - client.sent, (size_t)INT_MAX), 0);
+				if (n == SOCKET_ERROR) return (WSAGetLastError() == WSAEWOULDBLOCK);
+				client.sent += n;
+			}
+			client.out.clear();
+			client.sent = 0;
+			return true;
+		}
+
+		string peer_name(const sockaddr_storage& addr) {
+			array<char, 64> ip{};
+			const void* src = (addr.ss_family == AF_INET6
+				? (const void*)&reinterpret_cast<const sockaddr_in6*>(&addr)->sin6_addr
+				: (const void*)&reinterpret_cast<const sockaddr_in*>(&addr)->sin_addr);
+			if (inet_ntop(addr.ss_family, src, ip.data(), ip.size()) == nullptr) return "unknown";
+			return ip.data();
+		}
+
+		//* Network thread for agent mode, accepts viewers, flushes backlogs the main thread couldn't send and closes finished connections
+		void serve() {
+			Trace::thread_name("agent");
+			vector<WSAPOLLFD> fds;
+			array<char, 1024> drain;
+			while (not stopping) {
+				fds.clear();
+				{
+					std::lock_guard lck(clients_lock);
+					//? Connections wait in the listen backlog until the first collect has filled in the greeting
+					fds.push_back({listener, (SHORT)(clients.size() < max_clients and not hello.empty() ? POLLRDNORM : 0), 0});
+					for (const auto& client : clients)
+						fds.push_back({client.sock, (SHORT)(POLLRDNORM | (client.sent < client.out.size() ? POLLWRNORM : 0)), 0});
+				}
+
+				if (WSAPoll(fds.data(), (ULONG)fds.size(), 100) == SOCKET_ERROR) {
+					Logger::warning("Remote::serve() -> WSAPoll() failed with error " + to_string(WSAGetLastError()));
+					sleep_ms(100);
+					continue;
+				}
+
+				std::lock_guard lck(clients_lock);
+				//? Only this thread adds and removes clients, the indexes from before polling are still valid
+				for (size_t i = clients.size(); i-- > 0;) {
+					auto& client = clients[i];
+					const SHORT events = fds[i + 1].revents;
+					bool done = (client.dead or events & (POLLERR | POLLNVAL));
+					if (not done and events & (POLLRDNORM | POLLHUP)) {
+						//? Viewers never send anything, reading only detects closed connections
+						const int n = recv(client.sock, drain.data(), (int)drain.size(), 0);
+						done = (n == 0 or (n == SOCKET_ERROR and WSAGetLastError() != WSAEWOULDBLOCK));
+					}
+					if (not done and events & POLLWRNORM) done = not send_some(client);
+
+					if (done) {
+						closesocket(client.sock);
+						if (i != clients.size() - 1) client = std::move(clients.back());
+						clients.pop_back();
+						Logger::info("Viewer disconnected, ", clients.size(), " connected");
+					}
+				}
+
+				if (fds[0].revents & POLLRDNORM) {
+					while (clients.size() < max_clients) {
+						sockaddr_storage addr{};
+						int addr_len = sizeof(addr);
+						const SOCKET sock = accept(listener, (sockaddr*)&addr, &addr_len);
+						if (sock == INVALID_SOCKET) break;
+						u_long nonblocking = 1;
+						const int nodelay = 1;
+						ioctlsocket(sock, FIONBIO, &nonblocking);
+						setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&nodelay, sizeof(nodelay));
+						clients.push_back({sock, hello});
+						Logger::info("Viewer connected from ", peer_name(addr));
+					}
+				}
+			}
+
+			std::lock_guard lck(clients_lock);
+			for (auto& client : clients) closesocket(client.sock);
+			clients.clear();
+			closesocket(listener);
+		}
+
+		//* Current values of all fields and the process table as applied from the stream, guarded by <state_lock>
+		std::mutex state_lock;
+		Decoder decoder;
+		uint64_t frames = 0, filled = 0;
+		bool resynced = false;
+		atomic<bool> online = false;
+		atomic<SOCKET> conn = INVALID_SOCKET;
+		string cpu_name;
+		long cores = 0;
+		uint64_t agent_update = 0;
+
+		//* Read exactly <len> bytes, returns false on error, timeout or closed connection
+		bool recv_all(const SOCKET sock, char* buf, size_t len) {
+			while (len > 0) {
+				const int n = recv(sock, buf, (int)min(len, (size_t)INT_MAX), 0);
+				if (n <= 0) return false;
+				buf += n;
+				len -= n;
+			}
+			return true;
+		}
+
+		bool read_frame(const SOCKET sock, string& payload, char& type) {
+			array<char, head_size> head;
+			if (not recv_all(sock, head.data(), head.size())) return false;
+			const uint32_t size = payload_size(head.data());
+			if (size > max_frame) return false;
+			type = head[4];
+			payload.resize(size);
+			return recv_all(sock, payload.data(), size);
+		}
+
+		void set_timeout(const SOCKET sock, const uint64_t ms) {
+			const DWORD timeout = (DWORD)ms;
+			setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+		}
+
+		//* Connect to the agent and read its greeting, returns INVALID_SOCKET with the reason in <error> on failure
+		SOCKET open(string& error) {
+			addrinfo hints{};
+			hints.ai_family = AF_UNSPEC;
+			hints.ai_socktype = SOCK_STREAM;
+			hints.ai_protocol = IPPROTO_TCP;
+			addrinfo* found = nullptr;
+			if (getaddrinfo(address.c_str(), to_string(port).c_str(), &hints, &found) != 0) {
+				error = "could not resolve " + address;
+				return INVALID_SOCKET;
+			}
+			SOCKET sock = INVALID_SOCKET;
+			int last_error = 0;
+			for (auto a = found; a != nullptr; a = a->ai_next) {
+				sock = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+				if (sock == INVALID_SOCKET) continue;
+				if (::connect(sock, a->ai_addr, (int)a->ai_addrlen) == 0) break;
+				last_error = WSAGetLastError();
+				closesocket(sock);
+				sock = INVALID_SOCKET;
+			}
+			freeaddrinfo(found);
+			if (sock == INVALID_SOCKET) {
+				error = "could not connect to " + endpoint() + ", error " + to_string(last_error);
+				return INVALID_SOCKET;
+			}
+
+			set_timeout(sock, handshake_ms);
+			string payload;
+			char type = 0;
+			if (not read_frame(sock, payload, type) or type != type_hello) {
+				error = "no greeting from " + endpoint();
+				closesocket(sock);
+				return INVALID_SOCKET;
+			}
+			Cursor in(payload);
+			const string_view name = in.str();
+			const uint64_t version = in.var();
+			if (not in.ok or name != greeting) error = endpoint() + " is not a btop4win agent";
+			else if (version != protocol_version) error = "agent uses protocol version " + to_string(version) + ", expected " + to_string(protocol_version);
+			if (not error.empty()) {
+				closesocket(sock);
+				return INVALID_SOCKET;
+			}
+			agent_name = in.str();
+			cpu_name = in.str();
+			cores = (long)in.var();
+			agent_update = in.var();
+
+			//? Agents send a frame every update, a silent connection is treated as lost
+			set_timeout(sock, max((uint64_t)10'000, agent_update * 3));
+			return sock;
+		}
+
+		//* Apply a frame to the current state, returns false if the frame is malformed
+		bool apply_frame(const char type, const string_view payload) {
+			//? Unknown frame types are skipped for compatibility with newer agents
+			if (type != type_key and type != type_delta) return true;
+			std::lock_guard lck(state_lock);
+			if (not decoder.apply(type, payload)) return false;
+			if (type == type_key and std::exchange(resynced, false)) filled = 0;
+			frames++;
+			return true;
+		}
+
+		//* Receiver thread for viewer mode, applies frames as they arrive and reconnects when the connection is lost
+		void receive(SOCKET sock) {
+			Trace::thread_name("remote");
+			string payload;
+			char type = 0;
+			while (not stopping) {
+				if (sock == INVALID_SOCKET) {
+					sleep_ms(reconnect_ms);
+					string error;
+					if (stopping or (sock = open(error)) == INVALID_SOCKET) continue;
+					if (cores != Shared::coreCount)
+						Logger::warning("Agent at " + endpoint() + " now reports " + to_string(cores) + " cores, restart to resize the cpu box");
+					{
+						std::lock_guard lck(state_lock);
+						resynced = true;
+					}
+					conn = sock;
+					online = true;
+					Logger::info("Reconnected to agent at ", endpoint());
+				}
+
+				if (read_frame(sock, payload, type) and apply_frame(type, payload)) continue;
+				online = false;
+				if (not stopping) Logger::warning("Lost connection to agent at " + endpoint() + ", reconnecting");
+				conn.exchange(INVALID_SOCKET);
+				closesocket(sock);
+				sock = INVALID_SOCKET;
+			}
+		}
+
+		//* Push <value> to a graph kept at <samples> values
+		void push(deque<long long>& data, const long long value, const size_t samples) {
+			data.push_back(value);
+			while (data.size() > samples) data.pop_front();
+		}
+
+		//* Index at the start of <str>, numbers above <limit> are treated as invalid and returned as <limit>
+		size_t to_index(const string_view str, const size_t limit) {
+			size_t value = limit;
+			if (std::from_chars(str.data(), str.data() + str.size(), value).ec != std::errc{} or value > limit) return limit;
+			return value;
+		}
+	}
+
+	bool parse_address(const string& arg, const bool need_host) {
+		string host = arg, port_str;
+		if (arg.starts_with('[')) {
+			const size_t end = arg.find(']');
+			if (end == string::npos or (end + 1 < arg.size() and arg[end + 1] != ':')) return false;
+			host = arg.substr(1, end - 1);
+			if (end + 1 < arg.size()) port_str = arg.substr(end + 2);
+		}
+		else if (isint(arg)) {
+			host.clear();
+			port_str = arg;
+		}
+		else if (rng::count(arg, ':') == 1) {
+			host = arg.substr(0, arg.find(':'));
+			port_str = arg.substr(arg.find(':') + 1);
+		}
+
+		if (need_host and host.empty()) return false;
+		if (not port_str.empty() or arg.ends_with(':')) {
+			if (not isint(port_str) or port_str.size() > 5 or stoi(port_str) < 1 or stoi(port_str) > 65535) return false;
+			port = stoi(port_str);
+		}
+		address = host;
+		return true;
+	}
+
+	void listen() {
+		WSADATA wsa_data;
+		if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+			throw std::runtime_error("WSAStartup() failed");
+
+		//? Only reachable from the local machine unless an address to listen on is given
+		if (address.empty()) address = "127.0.0.1";
+		addrinfo hints{};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_protocol = IPPROTO_TCP;
+		hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST;
+		addrinfo* found = nullptr;
+		if (getaddrinfo(address.c_str(), to_string(port).c_str(), &hints, &found) != 0)
+			throw std::runtime_error("Invalid address to listen on: " + address);
+
+		listener = socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+		const int exclusive = 1;
+		u_long nonblocking = 1;
+		const bool failed = (listener == INVALID_SOCKET
+			or setsockopt(listener, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (const char*)&exclusive, sizeof(exclusive)) == SOCKET_ERROR
+			or bind(listener, found->ai_addr, (int)found->ai_addrlen) == SOCKET_ERROR
+			or ::listen(listener, SOMAXCONN) == SOCKET_ERROR
+			or ioctlsocket(listener, FIONBIO, &nonblocking) == SOCKET_ERROR);
+		freeaddrinfo(found);
+		if (failed) {
+			const int error = WSAGetLastError();
+			if (listener != INVALID_SOCKET) closesocket(listener);
+			listener = INVALID_SOCKET;
+			throw std::runtime_error("Failed to listen on " + endpoint() + ", error " + to_string(error));
+		}
+
+		//? All boxes are sent, viewers sort and filter processes with their own settings
+		Shared::headless_setup(true, true, true, true);
+
+		if (address != "127.0.0.1" and address != "::1")
+			Logger::warning("Agent is reachable from other machines on " + endpoint() + ", anyone who can connect can read all process command lines");
+		Logger::info("Agent listening on ", endpoint());
+		std::thread(serve).detach();
+	}
+
+	void publish() {
+		if (listener == INVALID_SOCKET or stopping) return;
+		Trace::Span span("remote::publish", "background");
+
+		//? Collectors run every update even without viewers to keep rates and graphs current
+		const auto& cpu = Cpu::collect();
+		const auto& mem = Mem::collect();
+		Net::collect();
+		const auto& procs = Proc::collect();
+
+		bool key = (++since_key >= key_interval);
+		{
+			std::lock_guard lck(clients_lock);
+			if (hello.empty()) {
+				begin_frame(hello, type_hello);
+				put_str(hello, greeting);
+				put_var(hello, protocol_version);
+				put_str(hello, hostname());
+				put_str(hello, Cpu::cpuName);
+				put_var(hello, (uint64_t)Shared::coreCount);
+				put_var(hello, (uint64_t)Config::getI("update_ms"));
+				end_frame(hello, 0);
+			}
+
+			//? Nothing is encoded while no viewer is connected, the next viewer starts with a keyframe
+			if (clients.empty()) {
+				since_key = key_interval;
+				return;
+			}
+			key = (key or rng::any_of(clients, [](const Client& c) { return not c.keyed; }));
+		}
+		if (key) since_key = 0;
+
+		encoder.begin(key);
+		string name;
+		const auto num = [&](const string& n, const int64_t value) { encoder.num(n, value); };
+
+		for (const auto& [field, data] : cpu.cpu_percent) if (not data.empty()) num("cpu/pct/" + field, data.back());
+		for (size_t i = 0; i < cpu.core_percent.size(); i++) if (not cpu.core_percent[i].empty()) num("cpu/core/" + to_string(i), cpu.core_percent[i].back());
+		for (size_t i = 0; i < cpu.core_max.size(); i++) if (not cpu.core_max[i].empty()) num("cpu/core_max/" + to_string(i), cpu.core_max[i].back());
+		for (size_t i = 0; i < cpu.temp.size(); i++) if (not cpu.temp[i].empty()) num("cpu/temp/" + to_string(i), cpu.temp[i].back());
+		if (not cpu.gpu_temp.empty()) num("cpu/gpu_temp", cpu.gpu_temp.back());
+		num("cpu/temp_max", cpu.temp_max);
+		for (size_t i = 0; i < cpu.load_avg.size(); i++) num("cpu/load/" + to_string(i), std::llround(cpu.load_avg[i] * 100));
+		encoder.text("cpu/hz", Cpu::cpuHz);
+		num("cpu/sensors", Cpu::got_sensors);
+		num("cpu/temp_only", Cpu::cpu_temp_only);
+		num("gpu/present", Cpu::has_gpu);
+		encoder.text("gpu/name", Cpu::gpu_name);
+		encoder.text("gpu/clock", Cpu::gpu_clock);
+		num("bat/present", Cpu::has_battery);
+		num("bat/percent", std::get<0>(Cpu::current_bat));
+		num("bat/seconds", std::get<1>(Cpu::current_bat));
+		encoder.text("bat/status", std::get<2>(Cpu::current_bat));
+
+		for (const auto& [stat, value] : mem.stats) num("mem/stat/" + stat, (int64_t)value);
+		for (const auto& [stat, data] : mem.percent) if (not data.empty()) num("mem/pct/" + stat, data.back());
+		num("mem/total", Mem::totalMem);
+		num("mem/swap", Mem::has_swap);
+		num("mem/cpu_gpu", Mem::cpu_gpu);
+		num("mem/pagevirt", mem.pagevirt);
+		num("mem/disk_ios", Mem::disk_ios);
+		string order;
+		for (const auto& mount : mem.disks_order) order.append(mount) += '\n';
+		encoder.text("disk/order", order);
+		for (const auto& [mount, disk] : mem.disks) {
+			name = "disk/" + mount + '/';
+			encoder.text(name + "name", disk.name);
+			num(name + "total", disk.total);
+			num(name + "used", disk.used);
+			num(name + "free", disk.free);
+			if (not disk.io_read.empty()) num(name + "read", disk.io_read.back());
+			if (not disk.io_write.empty()) num(name + "write", disk.io_write.back());
+			if (not disk.io_activity.empty()) num(name + "activity", disk.io_activity.back());
+		}
+
+		for (const auto& iface : Net::interfaces) {
+			const auto found = Net::current_net.find(iface);
+			if (found == Net::current_net.end()) continue;
+			const auto& info = found->second;
+			name = "net/" + iface + '/';
+			for (const auto& [dir, stat] : info.stat) {
+				num(name + dir + "/speed", (int64_t)stat.speed);
+				num(name + dir + "/top", (int64_t)stat.top);
+				num(name + dir + "/total", (int64_t)stat.total);
+			}
+			encoder.text(name + "ipv4", info.ipv4);
+			encoder.text(name + "ipv6", info.ipv6);
+			num(name + "connected", info.connected);
+		}
+
+		for (const auto& p : procs) encoder.proc(p);
+
+		frame.clear();
+		encoder.finish(frame, time_ms());
+
+		std::lock_guard lck(clients_lock);
+		for (auto& client : clients) {
+			if (client.dead or (not key and not client.keyed)) continue;
+			client.keyed = true;
+			if (client.sent > 0 and client.sent >= client.out.size() / 2) {
+				client.out.erase(0, client.sent);
+				client.sent = 0;
+			}
+			if (client.out.size() - client.sent + frame.size() > max_backlog) {
+				Logger::warning("Viewer fell more than " + to_string(max_backlog >> 20) + " MiB behind, disconnecting");
+				client.dead = true;
+				continue;
+			}
+			client.out += frame;
+			if (not send_some(client)) client.dead = true;
+		}
+	}
+
+	void connect() {
+		WSADATA wsa_data;
+		if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+			throw std::runtime_error("WSAStartup() failed");
+
+		string error;
+		const SOCKET sock = open(error);
+		if (sock == INVALID_SOCKET) throw std::runtime_error(error);
+
+		//? Boxes are drawn for the agents machine, the first keyframe is waited for to have something to draw
+		Cpu::cpuName = cpu_name;
+		Shared::coreCount = cores;
+		string payload;
+		char type = 0;
+		set_timeout(sock, max(handshake_ms, agent_update * 2 + handshake_ms));
+		bool received = false;
+		while ((received = read_frame(sock, payload, type)) and type != type_key);
+		if (not received or not apply_frame(type, payload)) {
+			closesocket(sock);
+			throw std::runtime_error("No data received from " + endpoint());
+		}
+		set_timeout(sock, max((uint64_t)10'000, agent_update * 3));
+
+		conn = sock;
+		online = true;
+		Logger::info("Connected to agent ", agent_name, " at ", endpoint());
+		std::thread(receive, sock).detach();
+	}
+
+	bool connected() {
+		return online;
+	}
+
+	void close() {
+		stopping = true;
+		if (const SOCKET sock = conn.exchange(INVALID_SOCKET); sock != INVALID_SOCKET) shutdown(sock, SD_BOTH);
+	}
+
+	int fill(Cpu::cpu_info& cpu, Mem::mem_info& mem, unordered_flat_map<string, Net::net_info>& net, vector<Proc::proc_info>& procs,
+			const size_t samples, const string& filter) {
+		std::lock_guard lck(state_lock);
+		if (frames == filled) return 0;
+		const int moved = (filled == 0 ? 2 : 1);
+		filled = frames;
+
+		size_t cores_seen = 0, temps_seen = 0;
+		vector<string> disks_seen, ifaces_seen;
+		for (const auto& value : decoder.values) {
+			if (not value.alive) continue;
+			const string_view name = value.name;
+			const size_t slash = name.find('/');
+			const string_view section = name.substr(0, slash);
+			const string_view key = (slash == string_view::npos ? string_view{} : name.substr(slash + 1));
+			const long long num = value.num;
+
+			if (section == "cpu") {
+				if (key.starts_with("pct/")) push(cpu.cpu_percent[string(key.substr(4))], num, samples);
+				else if (key.starts_with("core/") or key.starts_with("core_max/") or key.starts_with("temp/")) {
+					const bool is_temp = key.starts_with("temp/");
+					const size_t index = to_index(key.substr(key.find('/') + 1), 1024);
+					if (index == 1024) continue;
+					auto& list = (is_temp ? cpu.temp : (key.starts_with("core/") ? cpu.core_percent : cpu.core_max));
+					if (list.size() <= index) list.resize(index + 1);
+					push(list[index], num, (is_temp ? 20 : 40));
+					(is_temp ? temps_seen : cores_seen) = max((is_temp ? temps_seen : cores_seen), index + 1);
+				}
+				else if (key == "gpu_temp") push(cpu.gpu_temp, num, 40);
+				else if (key == "temp_max") cpu.temp_max = num;
+				else if (key.starts_with("load/")) {
+					if (const size_t index = to_index(key.substr(5), 3); index < 3) cpu.load_avg[index] = (float)num / 100;
+				}
+				else if (key == "hz") Cpu::cpuHz = value.str;
+				else if (key == "sensors") Cpu::got_sensors = (num != 0);
+				else if (key == "temp_only") Cpu::cpu_temp_only = (num != 0);
+			}
+			else if (section == "gpu") {
+				if (key == "present") Cpu::has_gpu = (num != 0);
+				else if (key == "name") Cpu::gpu_name = value.str;
+				else if (key == "clock") Cpu::gpu_clock = value.str;
+			}
+			else if (section == "bat") {
+				if (key == "present") Cpu::has_battery = (num != 0);
+				else if (key == "percent") std::get<0>(Cpu::current_bat) = (int)num;
+				else if (key == "seconds") std::get<1>(Cpu::current_bat) = (long)num;
+				else if (key == "status") std::get<2>(Cpu::current_bat) = value.str;
+			}
+			else if (section == "mem") {
+				if (key.starts_with("stat/")) mem.stats[string(key.substr(5))] = (uint64_t)num;
+				else if (key.starts_with("pct/")) push(mem.percent[string(key.substr(4))], num, samples);
+				else if (key == "total") Mem::totalMem = num;
+				else if (key == "swap") Mem::has_swap = (num != 0);
+				else if (key == "cpu_gpu") Mem::cpu_gpu = (num != 0);
+				else if (key == "pagevirt") mem.pagevirt = (num != 0);
+				else if (key == "disk_ios") Mem::disk_ios = (int)num;
+			}
+			else if (section == "disk") {
+				if (key == "order") {
+					mem.disks_order = ssplit(value.str, '\n');
+					continue;
+				}
+				const size_t split = key.rfind('/');
+				if (split == string_view::npos) continue;
+				const string mount(key.substr(0, split));
+				const string_view stat = key.substr(split + 1);
+				if (not v_contains(disks_seen, mount)) disks_seen.push_back(mount);
+				auto& disk = mem.disks[mount];
+				if (stat == "name") disk.name = value.str;
+				else if (stat == "total") disk.total = num;
+				else if (stat == "used") disk.used = num;
+				else if (stat == "free") disk.free = num;
+				else if (stat == "read") push(disk.io_read, num, samples);
+				else if (stat == "write") push(disk.io_write, num, samples);
+				else if (stat == "activity") push(disk.io_activity, num, samples);
+			}
+			else if (section == "net") {
+				//? Interface names can contain slashes, the keys after it are parsed from the end
+				size_t split = key.rfind('/');
+				if (split == string_view::npos) continue;
+				const string_view stat = key.substr(split + 1);
+				string_view dir;
+				if (is_in(stat, "speed", "top", "total")) {
+					const size_t dir_split = key.rfind('/', split - 1);
+					if (split == 0 or dir_split == string_view::npos) continue;
+					dir = key.substr(dir_split + 1, split - dir_split - 1);
+					split = dir_split;
+				}
+				const string iface(key.substr(0, split));
+				if (not v_contains(ifaces_seen, iface)) ifaces_seen.push_back(iface);
+				auto& info = net[iface];
+				if (not dir.empty()) {
+					if (not is_in(dir, "download", "upload")) continue;
+					auto& saved = info.stat.at(string(dir));
+					if (stat == "speed") {
+						saved.speed = (uint64_t)num;
+						push(info.bandwidth.at(string(dir)), num, samples);
+					}
+					else if (stat == "top") saved.top = (uint64_t)num;
+					else saved.total = (uint64_t)num;
+				}
+				else if (stat == "ipv4") info.ipv4 = value.str;
+				else if (stat == "ipv6") info.ipv6 = value.str;
+				else if (stat == "connected") info.connected = (num != 0);
+			}
+		}
+
+		//? Drop anything the agent no longer sends and fill in the layout the draw functions expect like Record::Replay::fill()
+		const auto fix = [](deque<long long>& data) { if (data.empty()) data.push_back(0); };
+		for (auto& [field, data] : cpu.cpu_percent) fix(data);
+		cpu.core_percent.resize(max((size_t)Shared::coreCount, cores_seen));
+		cpu.core_max.resize(cpu.core_percent.size());
+		cpu.temp.resize(temps_seen);
+		for (auto* list : {&cpu.core_percent, &cpu.core_max, &cpu.temp}) for (auto& data : *list) fix(data);
+		fix(cpu.gpu_temp);
+
+		for (auto& [stat, data] : mem.percent) fix(data);
+		std::erase_if(mem.disks_order, [&](const string& mount) { return not v_contains(disks_seen, mount); });
+		for (const auto& mount : disks_seen) {
+			auto& disk = mem.disks[mount];
+			for (auto* data : {&disk.io_read, &disk.io_write, &disk.io_activity}) fix(*data);
+			disk.used_percent = (disk.total > 0 ? (int)std::round((double)disk.used * 100 / disk.total) : 0);
+			disk.free_percent = (disk.total > 0 ? 100 - disk.used_percent : 0);
+		}
+		for (auto it = mem.disks.begin(); it != mem.disks.end();) {
+			if (v_contains(disks_seen, it->first)) ++it;
+			else it = mem.disks.erase(it);
+		}
+
+		for (auto it = net.begin(); it != net.end();) {
+			if (v_contains(ifaces_seen, it->first)) ++it;
+			else it = net.erase(it);
+		}
+		Net::interfaces = ifaces_seen;
+		if (not net.contains(Net::selected_iface))
+			Net::selected_iface = (Net::interfaces.empty() ? "" : Net::interfaces.front());
+		auto& selected = net[Net::selected_iface];
+		for (const string dir : {"download", "upload"}) {
+			fix(selected.bandwidth.at(dir));
+			Net::graph_max[dir] = max(10ll << 10, (long long)(rng::max(selected.bandwidth.at(dir)) * 1.2));
+		}
+
+		//? Tree layout isn't sent, processes are shown as a flat list
+		procs.clear();
+		procs.reserve(decoder.procs.size());
+		for (const auto& [pid, p] : decoder.procs) {
+			auto& out = procs.emplace_back(p);
+			out.filtered = (not filter.empty()
+				and not s_contains(to_string(out.pid), filter)
+				and not s_contains_ic(out.name, filter)
+				and not s_contains_ic(out.cmd, filter)
+				and not s_contains_ic(out.user, filter));
+		}
+		return moved;
+	}
+}
@@ -0,0 +1,76 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+
+#include <btop_shared.hpp>
+
+using std::string, std::vector, std::atomic;
+
+//* Streams collected data from a headless agent started with argument "--agent" to viewers on other machines over TCP.
+//* Each update the agent encodes cpu, mem, net and the process table as a framed binary delta against the last frame,
+//* holding only values that changed and processes that spawned, changed or exited. A keyframe with everything is sent
+//* periodically and when a viewer connects. Viewers started with "--connect" rebuild the boxes from the stream and
+//* draw them with the normal draw functions instead of collecting locally
+namespace Remote {
+
+	//* Port used when none is given
+	const int default_port = 47801;
+
+	//* Set by argument "--agent"
+	extern bool agent;
+
+	//* Set by argument "--connect"
+	extern bool viewer;
+
+	//* Address to listen on or connect to, "127.0.0.1" for agents unless given
+	extern string address;
+	extern int port;
+
+	//* Hostname of the agent as sent in its greeting, set by connect()
+	extern string agent_name;
+
+	//* Parse "[address:]port" for "--agent" or "address[:port]" for "--connect", returns false if invalid
+	bool parse_address(const string& arg, const bool need_host);
+
+	//* Bind the listening socket and set up collectors for agent mode, called before Shared::init(). Throws std::runtime_error on failure
+	void listen();
+
+	//* Collect all boxes and send a new frame to connected viewers, run by the scheduler in agent mode
+	void publish();
+
+	//* Connect to an agent and wait for its greeting, called after Shared::init(). Throws std::runtime_error on failure.
+	//* A background thread applies incoming frames and reconnects if the connection is lost
+	void connect();
+
+	//* True if connected to an agent
+	bool connected();
+
+	//* Close the listening socket and all connections, safe to call from any thread
+	void close();
+
+	//* Replace <cpu>, <mem>, <net> and <procs> with the latest frame from the agent, graphs are kept to <samples> values.
+	//* Processes are filtered with <filter> but not sorted. Returns 0 if no new frame arrived since the last call,
+	//* 1 for a new frame and 2 if the connection was reset and all boxes should be redrawn
+	int fill(Cpu::cpu_info& cpu, Mem::mem_info& mem, unordered_flat_map<string, Net::net_info>& net, vector<Proc::proc_info>& procs,
+			const size_t samples, const string& filter);
+}
@@ -0,0 +1,241 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#include <bit>
+#include <cstring>
+#include <algorithm>
+
+#include <btop_series.hpp>
+
+using std::min;
+
+namespace Series {
+	namespace {
+		template <typename T>
+		void put(vector<char>& buf, const T value) {
+			const size_t pos = buf.size();
+			buf.resize(pos + sizeof(T));
+			std::memcpy(buf.data() + pos, &value, sizeof(T));
+		}
+
+		void put_str(vector<char>& buf, const string& str) {
+			const uint16_t len = (uint16_t)min(str.size(), (size_t)UINT16_MAX);
+			put(buf, len);
+			buf.insert(buf.end(), str.begin(), str.begin() + len);
+		}
+
+		void put_bits(vector<char>& buf, const BitWriter& bits) {
+			put(buf, (uint32_t)bits.bytes.size());
+			buf.insert(buf.end(), bits.bytes.begin(), bits.bytes.end());
+		}
+
+		//* Bounds checked reader for block headers and tables, <ok> is cleared on reads past the end
+		struct Cursor {
+			const char* data;
+			size_t size, pos = 0;
+			bool ok = true;
+
+			template <typename T>
+			T get() {
+				T value{};
+				if (pos + sizeof(T) > size) ok = false;
+				else std::memcpy(&value, data + pos, sizeof(T));
+				pos += sizeof(T);
+				return value;
+			}
+
+			string get_str() {
+				const uint16_t len = get<uint16_t>();
+				if (not ok or pos + len > size) {
+					ok = false;
+					return "";
+				}
+				pos += len;
+				return string(data + pos - len, len);
+			}
+
+			BitReader get_bits() {
+				const uint32_t len = get<uint32_t>();
+				if (not ok or pos + len > size) {
+					ok = false;
+					return {};
+				}
+				pos += len;
+				return {(const uint8_t*)data + pos - len, len};
+			}
+		};
+	}
+
+	void BitWriter::write(const uint64_t value, int bits) {
+		while (bits > 0) {
+			if (free == 0) {
+				bytes.push_back(0);
+				free = 8;
+			}
+			const int n = min(bits, free);
+			bytes.back() |= (uint8_t)(((value >> (bits - n)) & ((1u << n) - 1)) << (free - n));
+			free -= n;
+			bits -= n;
+		}
+	}
+
+	uint64_t BitReader::read(int bits) {
+		uint64_t value = 0;
+		while (bits > 0) {
+			const int avail = 8 - (int)(pos % 8);
+			const int n = min(bits, avail);
+			const uint8_t byte = (pos / 8 < size ? data[pos / 8] : 0);
+			value = (value << n) | ((byte >> (avail - n)) & ((1u << n) - 1));
+			pos += n;
+			bits -= n;
+		}
+		return value;
+	}
+
+	void TimeEncoder::add(const uint64_t time) {
+		if (count++ == 0) {
+			bits.write(time, 64);
+			prev = time;
+			return;
+		}
+		const int64_t delta = (int64_t)(time - prev);
+		const int64_t dod = delta - prev_delta;
+		if (dod == 0) bits.write(0, 1);
+		else if (dod >= -63 and dod <= 64) { bits.write(0b10, 2); bits.write((uint64_t)(dod + 63), 7); }
+		else if (dod >= -255 and dod <= 256) { bits.write(0b110, 3); bits.write((uint64_t)(dod + 255), 9); }
+		else if (dod >= -2047 and dod <= 2048) { bits.write(0b1110, 4); bits.write((uint64_t)(dod + 2047), 12); }
+		else { bits.write(0b1111, 4); bits.write((uint64_t)dod, 64); }
+		prev = time;
+		prev_delta = delta;
+	}
+
+	uint64_t TimeDecoder::next() {
+		if (count++ == 0) return (prev = bits.read(64));
+		int64_t dod;
+		if (bits.read(1) == 0) dod = 0;
+		else if (bits.read(1) == 0) dod = (int64_t)bits.read(7) - 63;
+		else if (bits.read(1) == 0) dod = (int64_t)bits.read(9) - 255;
+		else if (bits.read(1) == 0) dod = (int64_t)bits.read(12) - 2047;
+		else dod = (int64_t)bits.read(64);
+		prev_delta += dod;
+		return (prev += prev_delta);
+	}
+
+	void ValueEncoder::add(const double value) {
+		const uint64_t v = std::bit_cast<uint64_t>(value);
+		if (count++ == 0) {
+			bits.write(v, 64);
+			prev = v;
+			return;
+		}
+		const uint64_t x = v ^ prev;
+		prev = v;
+		if (x == 0) {
+			bits.write(0, 1);
+			return;
+		}
+		const int l = min(std::countl_zero(x), 31);
+		const int t = std::countr_zero(x);
+		if (lead >= 0 and l >= lead and t >= trail) {
+			bits.write(0b10, 2);
+			bits.write(x >> trail, 64 - lead - trail);
+		}
+		else {
+			lead = l;
+			trail = t;
+			//? A window of all 64 bits is stored as 0, there is always at least one meaningful bit
+			const int sig = 64 - l - t;
+			bits.write(0b11, 2);
+			bits.write((uint64_t)l, 5);
+			bits.write((uint64_t)(sig & 63), 6);
+			bits.write(x >> t, sig);
+		}
+	}
+
+	double ValueDecoder::next() {
+		if (count++ == 0) prev = bits.read(64);
+		else if (bits.read(1) == 1) {
+			if (bits.read(1) == 1) {
+				lead = (int)bits.read(5);
+				int sig = (int)bits.read(6);
+				if (sig == 0) sig = 64;
+				trail = 64 - lead - sig;
+			}
+			prev ^= bits.read(64 - lead - trail) << trail;
+		}
+		return std::bit_cast<double>(prev);
+	}
+
+	void Block::write(vector<char>& buf) const {
+		const size_t begin = buf.size();
+		put(buf, block_magic);
+		put(buf, (uint32_t)0);
+		put(buf, start);
+		put(buf, end);
+		put(buf, samples);
+		put(buf, (uint32_t)names.size());
+		put(buf, (uint32_t)strings.size());
+		for (const auto& name : names) put_str(buf, name);
+		for (const auto& [key, value] : strings) {
+			put_str(buf, key);
+			put_str(buf, value);
+		}
+		put_bits(buf, times.bits);
+		for (const auto& series : values) put_bits(buf, series.bits);
+		const uint32_t size = (uint32_t)(buf.size() - begin);
+		std::memcpy(buf.data() + begin + sizeof(uint32_t), &size, sizeof(uint32_t));
+	}
+
+	bool index(const char* data, const size_t size, BlockRef& ref) {
+		if (size < head_size) return false;
+		Cursor c{data, size};
+		const auto magic = c.get<uint32_t>();
+		ref.size = c.get<uint32_t>();
+		if (magic != block_magic or ref.size < head_size or ref.size > size) return false;
+		ref.data = data;
+		ref.start = c.get<uint64_t>();
+		ref.end = c.get<uint64_t>();
+		ref.samples = c.get<uint32_t>();
+		return true;
+	}
+
+	bool decode(const BlockRef& ref, Decoded& out) {
+		Cursor c{ref.data, ref.size, 28};
+		const auto series = c.get<uint32_t>();
+		const auto strings = c.get<uint32_t>();
+		for (uint32_t i = 0; i < series and c.ok; i++) out.names.push_back(c.get_str());
+		for (uint32_t i = 0; i < strings and c.ok; i++) {
+			string key = c.get_str();
+			out.strings[key] = c.get_str();
+		}
+		TimeDecoder times{c.get_bits()};
+		out.times.reserve(ref.samples);
+		for (uint32_t i = 0; i < ref.samples; i++) out.times.push_back(times.next());
+		out.values.resize(out.names.size());
+		for (auto& values : out.values) {
+			ValueDecoder decoder{c.get_bits()};
+			values.reserve(ref.samples);
+			for (uint32_t i = 0; i < ref.samples; i++) values.push_back(decoder.next());
+		}
+		if (not c.ok) {
+			out.names.clear();
+			out.values.clear();
+		}
+		return c.ok;
+	}
+}
@@ -0,0 +1,137 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <btop_shared.hpp>
+
+using std::string, std::vector;
+
+//* Block format of the recordings written by Record::Disk, kept free of file handling so it can be tested on its own.
+//* A block is a header, the series names, the string values, the timestamps and one bit stream per series.
+//* Timestamps are stored as delta-of-delta and values as XOR against the previous value of the same series
+namespace Series {
+
+	constexpr uint32_t block_magic = 0x4B4C4252;
+
+	//* Magic, block size, start and end time, sample count, series count and string count
+	constexpr size_t head_size = 36;
+
+	//* Bit stream packed most significant bit first
+	class BitWriter {
+		int free = 0;
+	public:
+		vector<uint8_t> bytes;
+
+		//* Append the low <bits> bits of <value>, up to 64
+		void write(const uint64_t value, int bits);
+	};
+
+	//* Reads past the end of the stream return zero bits
+	class BitReader {
+		const uint8_t* data = nullptr;
+		size_t size = 0, pos = 0;
+	public:
+		BitReader() = default;
+		BitReader(const uint8_t* data, const size_t size) : data(data), size(size) {}
+
+		uint64_t read(int bits);
+	};
+
+	//* Timestamps as delta-of-delta in variable length buckets, a steady interval costs one bit per sample
+	class TimeEncoder {
+		uint64_t prev = 0;
+		int64_t prev_delta = 0;
+		uint32_t count = 0;
+	public:
+		BitWriter bits;
+
+		void add(const uint64_t time);
+	};
+
+	class TimeDecoder {
+		BitReader bits;
+		uint64_t prev = 0;
+		int64_t prev_delta = 0;
+		uint32_t count = 0;
+	public:
+		TimeDecoder(const BitReader bits) : bits(bits) {}
+
+		uint64_t next();
+	};
+
+	//* Values XOR:ed against the previous value, only the meaningful bits are stored and the
+	//* leading/trailing zero window is reused while the XOR fits inside it
+	class ValueEncoder {
+		uint64_t prev = 0;
+		int lead = -1, trail = 0;
+		uint32_t count = 0;
+	public:
+		BitWriter bits;
+
+		void add(const double value);
+	};
+
+	class ValueDecoder {
+		BitReader bits;
+		uint64_t prev = 0;
+		int lead = 0, trail = 0;
+		uint32_t count = 0;
+	public:
+		ValueDecoder(const BitReader bits) : bits(bits) {}
+
+		double next();
+	};
+
+	//* Block being filled by the writer, every series gets one value per sample
+	struct Block {
+		uint64_t start = 0, end = 0;
+		uint32_t samples = 0;
+		vector<string> names;
+		unordered_flat_map<string, string> strings;
+		TimeEncoder times;
+		vector<ValueEncoder> values;
+
+		//* Append the serialized block to <buf>
+		void write(vector<char>& buf) const;
+	};
+
+	//* Location and header of a block in a mapped file
+	struct BlockRef {
+		const char* data = nullptr;
+		uint32_t size = 0, samples = 0;
+		uint64_t start = 0, end = 0;
+	};
+
+	//* Read the header of the block at the start of <size> bytes at <data>, false if they don't hold a complete block
+	bool index(const char* data, const size_t size, BlockRef& ref);
+
+	struct Decoded {
+		vector<string> names;
+		unordered_flat_map<string, string> strings;
+		vector<uint64_t> times;
+		vector<vector<double>> values;
+	};
+
+	//* Decode the block at <ref> into <out>, returns false with <out> holding no series if the block is corrupt
+	bool decode(const BlockRef& ref, Decoded& out);
+}
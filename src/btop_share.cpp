@@ -0,0 +1,451 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#define VC_EXTRALEAN
+#include <windows.h>
+
+#include <btop_share.hpp>
+#include <btop_shared.hpp>
+#include <btop_tools.hpp>
+#include <btop_config.hpp>
+#include <btop_perf.hpp>
+
+using std::string_view, std::array, std::max, std::min, std::to_string;
+using namespace Tools;
+
+namespace Share {
+	bool daemon = false;
+
+	namespace {
+		const array<char, 8> magic = { 'B', 'T', 'O', 'P', 'S', 'H', 'M', '1' };
+
+		//? Bumped when the frame format changes, viewers ignore regions with another version
+		const uint32_t layout_version = 1;
+
+		//? The global namespace is visible to viewers in other sessions but needs SeCreateGlobalPrivilege to create
+		const array<const wchar_t*, 2> names = { L"Global\\btop4win_snapshot", L"Local\\btop4win_snapshot" };
+
+		//? Two frames, the daemon always writes to the one not pointed to by <latest>
+		const size_t frame_count = 2;
+		const size_t frame_size = 4 << 20;
+
+		//? Longest command line published, longer ones are cut
+		const size_t max_cmd = 4096;
+
+		//? Region header, counters are only accessed through std::atomic_ref since other processes read and write them
+		struct alignas(64) region_header {
+			array<char, 8> magic;
+			uint32_t version, frames;
+			uint64_t frame_size;
+			uint64_t pid;
+			uint64_t heartbeat;		//? Tools::steady_ms() at last publish, 0 when stopped
+			uint64_t interval;		//? update_ms of the daemon
+			uint64_t latest;		//? Index of the last completed frame
+		};
+
+		//? Frame header, <seq> is odd while the frame is being written
+		struct alignas(8) frame_header {
+			uint64_t seq;
+			uint32_t size;
+			array<uint32_t, 3> offset;
+		};
+
+		enum sections { sec_lhm, sec_drives, sec_procs };
+
+		const size_t region_size = sizeof(region_header) + frame_count * frame_size;
+
+		atomic<char*> region = nullptr;
+		HANDLE map = nullptr;
+		atomic<bool> stopped = false;
+		atomic<bool> alive = false;
+		bool overflow_logged = false;
+
+		inline uint64_t load(uint64_t& value, const std::memory_order order = std::memory_order_acquire) {
+			return std::atomic_ref<uint64_t>(value).load(order);
+		}
+
+		inline void store(uint64_t& value, const uint64_t new_value, const std::memory_order order = std::memory_order_release) {
+			std::atomic_ref<uint64_t>(value).store(new_value, order);
+		}
+
+		inline region_header& header() { return *reinterpret_cast<region_header*>(region.load()); }
+		inline char* frame(const size_t index) { return region.load() + sizeof(region_header) + index * frame_size; }
+		inline frame_header& frame_head(const size_t index) { return *reinterpret_cast<frame_header*>(frame(index)); }
+
+		//? Daemon is alive if it has published within a few intervals, steady clock time is the same for all processes
+		bool is_alive() {
+			auto& head = header();
+			const uint64_t beat = load(head.heartbeat);
+			const uint64_t now = steady_ms();
+			return beat != 0 and (now < beat or now - beat < max<uint64_t>(5000, load(head.interval, std::memory_order_relaxed) * 3));
+		}
+
+		//* Serializes values into a frame, values not fitting are dropped and <ok> is cleared
+		class Writer {
+			char* data;
+			size_t size;
+		public:
+			size_t pos = 0;
+			bool ok = true;
+
+			Writer(char* data, const size_t size) : data(data), size(size) {}
+
+			template <typename T> requires std::is_trivially_copyable_v<T>
+			void put(const T value) {
+				if (not ok or size - pos < sizeof(T)) { ok = false; return; }
+				std::memcpy(data + pos, &value, sizeof(T));
+				pos += sizeof(T);
+			}
+
+			//? Strings are cut at <max_len> bytes, moved back to the start of an utf-8 sequence if cut inside one
+			void put(string_view str, const size_t max_len = UINT16_MAX) {
+				if (str.size() > max_len) {
+					size_t len = max_len;
+					while (len > 0 and (static_cast<unsigned char>(str[len]) & 0xC0) == 0x80) len--;
+					str = str.substr(0, len);
+				}
+				put<uint32_t>((uint32_t)str.size());
+				if (not ok or size - pos < str.size()) { ok = false; return; }
+				std::memcpy(data + pos, str.data(), str.size());
+				pos += str.size();
+			}
+		};
+
+		//* Decodes values from a frame that can be rewritten while reading, all reads are bounds checked
+		//* and the result is only used if the frame sequence counter is unchanged afterwards
+		class Reader {
+			const char* data;
+			size_t size;
+		public:
+			size_t pos;
+			bool ok = true;
+
+			Reader(const char* data, const size_t size, const size_t start) : data(data), size(size), pos(min(start, size)) {}
+
+			template <typename T>
+			T get() {
+				static_assert(std::is_trivially_copyable_v<T>);
+				T value{};
+				if (not ok or size - pos < sizeof(T)) { ok = false; return value; }
+				std::memcpy(&value, data + pos, sizeof(T));
+				pos += sizeof(T);
+				return value;
+			}
+
+			void get(string& out) {
+				const auto len = get<uint32_t>();
+				if (not ok or size - pos < len) { ok = false; return; }
+				out.assign(data + pos, len);
+				pos += len;
+			}
+
+			//? Number of elements following, fails if the remaining data can't hold <min_size> bytes per element
+			size_t count(const size_t min_size) {
+				const auto n = get<uint32_t>();
+				if (not ok or n > (size - pos) / min_size) { ok = false; return 0; }
+				return n;
+			}
+		};
+
+		//* Decode section <sec> of the latest frame with <parse>, retried if the daemon rewrote the frame while reading
+		template <typename F>
+		bool read(const sections sec, F&& parse) {
+			if (not attached()) return false;
+			auto& head = header();
+			for (int attempt = 0; attempt < 4; attempt++) {
+				const uint64_t index = load(head.latest);
+				if (index >= frame_count) return false;
+				auto& fhead = frame_head(index);
+				const uint64_t seq = load(fhead.seq);
+				if (seq & 1) continue;
+
+				Reader in(frame(index) + sizeof(frame_header), frame_size - sizeof(frame_header), fhead.offset[sec]);
+				const bool parsed = parse(in) and in.ok;
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (load(fhead.seq, std::memory_order_relaxed) == seq) return parsed;
+			}
+			return false;
+		}
+	}
+
+	void create() {
+		size_t used = 0;
+		for (; used < names.size(); used++) {
+			map = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)region_size, names[used]);
+			if (map != nullptr) break;
+		}
+		if (map == nullptr)
+			throw std::runtime_error("Could not create shared memory, CreateFileMappingW() failed with error " + to_string(GetLastError()));
+		const bool existed = (GetLastError() == ERROR_ALREADY_EXISTS);
+
+		char* view = static_cast<char*>(MapViewOfFile(map, FILE_MAP_ALL_ACCESS, 0, 0, region_size));
+		if (view == nullptr)
+			throw std::runtime_error("Could not map shared memory, MapViewOfFile() failed with error " + to_string(GetLastError()));
+		region = view;
+		auto& head = header();
+
+		//? A region left by a stopped daemon is reused, viewers still mapping it continue with the new frames
+		if (existed) {
+			if (head.magic != magic or head.version != layout_version or head.frames != frame_count or head.frame_size != frame_size)
+				throw std::runtime_error("Shared memory is in use by another version of btop4win");
+			if (is_alive())
+				throw std::runtime_error("A collector daemon is already running with pid " + to_string(head.pid));
+		}
+		store(head.heartbeat, 0);
+		head.version = layout_version;
+		head.frames = frame_count;
+		head.frame_size = frame_size;
+		head.pid = GetCurrentProcessId();
+		store(head.latest, 0);
+		head.magic = magic;
+
+		//? Viewers collect network interfaces themselves, and sort and filter the published processes with their own settings
+		Shared::headless_setup(true, true, false, true);
+
+		if (used > 0) Logger::warning("No permission to create global shared memory, only viewers in this session can attach");
+		Logger::info("Starting collector daemon with ", region_size >> 20, " MiB of shared memory");
+	}
+
+	void publish() {
+		if (region == nullptr or stopped) return;
+		Trace::Span span("share::publish", "background");
+		auto& head = header();
+
+		//? Collect everything before touching the frame to keep the time the frame is inconsistent short
+		static vector<Mem::drive_raw> drives;
+		Mem::get_drives(drives);
+		const uint64_t drives_time = steady_ms();
+		const auto& procs = Proc::collect();
+		const auto lhm = (Cpu::has_OHMR ? Cpu::get_OHMR() : nullptr);
+
+		const size_t index = (load(head.latest, std::memory_order_relaxed) + 1) % frame_count;
+		auto& fhead = frame_head(index);
+		const uint64_t seq = load(fhead.seq, std::memory_order_relaxed);
+		store(fhead.seq, seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		Writer out(frame(index) + sizeof(frame_header), frame_size - sizeof(frame_header));
+
+		//? Sensors
+		fhead.offset[sec_lhm] = (uint32_t)out.pos;
+		out.put<uint8_t>(lhm != nullptr);
+		if (lhm != nullptr) {
+			static const Cpu::GpuRaw no_gpu;
+			out.put<int64_t>(Cpu::current_cpu.temp_max);
+			out.put<uint32_t>((uint32_t)Cpu::core_mapping.size());
+			for (const auto& [core, sensor] : Cpu::core_mapping) {
+				out.put<int32_t>(core);
+				out.put<int32_t>(sensor);
+			}
+			out.put<int32_t>(lhm->CpuClock);
+			out.put<uint32_t>((uint32_t)lhm->CPU.size());
+			for (const auto temp : lhm->CPU) out.put<int32_t>(temp);
+			out.put<uint32_t>((uint32_t)lhm->GPUorder.size());
+			for (const auto& name : lhm->GPUorder) {
+				const auto& gpu = (lhm->GPUS.contains(name) ? lhm->GPUS.at(name) : no_gpu);
+				out.put(name);
+				out.put<uint64_t>(gpu.usage);
+				out.put<uint64_t>(gpu.mem_total);
+				out.put<uint64_t>(gpu.mem_used);
+				out.put<uint64_t>(gpu.temp);
+				out.put<uint8_t>(gpu.cpu_gpu);
+				out.put(gpu.clock_mhz);
+			}
+		}
+
+		//? Drives
+		fhead.offset[sec_drives] = (uint32_t)out.pos;
+		out.put<uint64_t>(drives_time);
+		out.put<uint32_t>((uint32_t)drives.size());
+		for (const auto& drive : drives) {
+			out.put(drive.letter);
+			out.put(drive.name);
+			out.put<uint32_t>(drive.type);
+			out.put<uint8_t>(drive.has_space);
+			out.put<uint8_t>(drive.has_io);
+			out.put<uint64_t>(drive.total);
+			out.put<uint64_t>(drive.free);
+			out.put<uint64_t>(drive.free_priv);
+			out.put<int64_t>(drive.read);
+			out.put<int64_t>(drive.written);
+			out.put<int64_t>(drive.io_time);
+		}
+
+		//? Processes
+		fhead.offset[sec_procs] = (uint32_t)out.pos;
+		out.put<uint64_t>(Proc::cputimes);
+		out.put<uint32_t>((uint32_t)procs.size());
+		for (const auto& proc : procs) {
+			out.put<uint64_t>(proc.pid);
+			out.put<uint64_t>(proc.ppid);
+			out.put<uint64_t>(proc.threads);
+			out.put<uint64_t>(proc.mem);
+			out.put<uint64_t>(proc.cpu_s);
+			out.put<uint64_t>(proc.cpu_t);
+			out.put(proc.name);
+			out.put(proc.cmd, max_cmd);
+			out.put(proc.user);
+		}
+
+		fhead.size = (uint32_t)out.pos;
+		store(fhead.seq, seq + 2);
+
+		//? A frame that didn't fit is never made the latest, viewers keep reading the previous one
+		if (out.ok)
+			store(head.latest, index);
+		else if (not overflow_logged) {
+			Logger::warning("Collected data doesn't fit in shared memory frame of " + to_string(frame_size >> 20) + " MiB, skipping updates");
+			overflow_logged = true;
+		}
+
+		store(head.interval, (uint64_t)Config::getI("update_ms"), std::memory_order_relaxed);
+		store(head.heartbeat, steady_ms());
+
+		//? close() could have been called from another thread while publishing
+		if (stopped) store(head.heartbeat, 0);
+	}
+
+	void close() {
+		if (not daemon or region == nullptr or stopped.exchange(true)) return;
+		store(header().heartbeat, 0);
+		Logger::info("Collector daemon stopped");
+	}
+
+	bool attach() {
+		if (daemon) return false;
+		if (region == nullptr) {
+			HANDLE handle = nullptr;
+			for (const auto name : names) {
+				if ((handle = OpenFileMappingW(FILE_MAP_READ, FALSE, name)) != nullptr) break;
+			}
+			if (handle == nullptr) return false;
+
+			//? The view keeps the region alive after closing the handle, so a daemon started later creates the same region again.
+			//? The view is never unmapped since collectors on other threads could be reading from it at any time
+			char* view = static_cast<char*>(MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0));
+			CloseHandle(handle);
+			if (view == nullptr) return false;
+
+			const auto& head = *reinterpret_cast<const region_header*>(view);
+			if (head.magic != magic or head.version != layout_version or head.frames != frame_count or head.frame_size != frame_size) {
+				static bool logged = false;
+				if (not logged and head.magic == magic) Logger::warning("Ignoring collector daemon of another version of btop4win");
+				logged = true;
+				UnmapViewOfFile(view);
+				return false;
+			}
+			region = view;
+		}
+		return attached();
+	}
+
+	bool attached() {
+		if (daemon or region == nullptr) return false;
+		const bool now_alive = is_alive();
+		if (alive.exchange(now_alive) != now_alive) {
+			if (now_alive) Logger::info("Attached to collector daemon with pid ", header().pid);
+			else Logger::info("Collector daemon stopped publishing, collecting locally");
+		}
+		return now_alive;
+	}
+
+	bool read_procs(vector<proc_raw>& procs, uint64_t& cputimes) {
+		return read(sec_procs, [&](Reader& in) {
+			cputimes = in.get<uint64_t>();
+			procs.resize(in.count(6 * sizeof(uint64_t) + 3 * sizeof(uint32_t)));
+			for (auto& proc : procs) {
+				proc.pid = in.get<uint64_t>();
+				proc.ppid = in.get<uint64_t>();
+				proc.threads = in.get<uint64_t>();
+				proc.mem = in.get<uint64_t>();
+				proc.cpu_s = in.get<uint64_t>();
+				proc.cpu_t = in.get<uint64_t>();
+				in.get(proc.name);
+				in.get(proc.cmd);
+				in.get(proc.user);
+			}
+			return in.ok;
+		});
+	}
+
+	bool read_drives(vector<Mem::drive_raw>& drives, uint64_t& time) {
+		return read(sec_drives, [&](Reader& in) {
+			time = in.get<uint64_t>();
+			drives.resize(in.count(3 * sizeof(uint32_t) + 2 + 6 * sizeof(uint64_t)));
+			for (auto& drive : drives) {
+				in.get(drive.letter);
+				in.get(drive.name);
+				drive.type = in.get<uint32_t>();
+				drive.has_space = (in.get<uint8_t>() != 0);
+				drive.has_io = (in.get<uint8_t>() != 0);
+				drive.total = in.get<uint64_t>();
+				drive.free = in.get<uint64_t>();
+				drive.free_priv = in.get<uint64_t>();
+				drive.read = in.get<int64_t>();
+				drive.written = in.get<int64_t>();
+				drive.io_time = in.get<int64_t>();
+			}
+			return in.ok;
+		});
+	}
+
+	bool read_lhm(Cpu::OHMRraw& stats, long long* temp_max, unordered_flat_map<int, int>* core_mapping) {
+		long long tjmax = 0;
+		unordered_flat_map<int, int> mapping;
+		const bool got = read(sec_lhm, [&](Reader& in) {
+			if (in.get<uint8_t>() == 0) return false;
+			tjmax = in.get<int64_t>();
+			mapping.clear();
+			for (size_t i = 0, n = in.count(2 * sizeof(int32_t)); i < n; i++) {
+				const int core = in.get<int32_t>();
+				const int sensor = in.get<int32_t>();
+				mapping[core] = sensor;
+			}
+			stats.CpuClock = in.get<int32_t>();
+			stats.CPU.resize(in.count(sizeof(int32_t)));
+			for (auto& temp : stats.CPU) temp = in.get<int32_t>();
+			stats.GPUS.clear();
+			stats.GPUorder.resize(in.count(2 * sizeof(uint32_t) + 1 + 4 * sizeof(uint64_t)));
+			for (auto& name : stats.GPUorder) {
+				in.get(name);
+				auto& gpu = stats.GPUS[name];
+				gpu.usage = in.get<uint64_t>();
+				gpu.mem_total = in.get<uint64_t>();
+				gpu.mem_used = in.get<uint64_t>();
+				gpu.temp = in.get<uint64_t>();
+				gpu.cpu_gpu = (in.get<uint8_t>() != 0);
+				in.get(gpu.clock_mhz);
+			}
+			return in.ok;
+		});
+		if (got) {
+			if (temp_max != nullptr) *temp_max = tjmax;
+			if (core_mapping != nullptr) *core_mapping = std::move(mapping);
+		}
+		return got;
+	}
+}
@@ -0,0 +1,69 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <btop_shared.hpp>
+
+using std::string, std::vector;
+
+//* Snapshots shared between a collector daemon started with argument "--daemon" and viewers on the same machine.
+//* The daemon publishes raw counters for processes, drives and sensors to a named memory mapped region, alternating
+//* between two frames guarded by a sequence counter each. Viewers map the region read-only and decode the latest frame
+//* directly from the mapping, rates and percentages are then calculated by the normal collector code in each viewer.
+//* Viewers collect on their own while no daemon is running or when it stops publishing
+namespace Share {
+
+	//* Set by argument "--daemon"
+	extern bool daemon;
+
+	//* Create the shared region and set up collectors for daemon mode, called before Shared::init(). Throws std::runtime_error on failure
+	void create();
+
+	//* Collect processes and drives and publish them together with the latest sensor values as a new frame, run by the scheduler in daemon mode
+	void publish();
+
+	//* Tell viewers the daemon has stopped, safe to call from any thread
+	void close();
+
+	//* Map the region of a daemon if not already mapped, returns true if attached to a running daemon
+	bool attach();
+
+	//* True if the region is mapped and the daemon has published recently
+	bool attached();
+
+	//* Raw process values as collected by the daemon
+	struct proc_raw {
+		size_t pid = 0;
+		uint64_t ppid = 0, threads = 0, mem = 0, cpu_s = 0, cpu_t = 0;
+		string name, cmd, user;
+	};
+
+	//* Get processes from the latest frame and the system cpu time they were collected at, returns false if not attached
+	bool read_procs(vector<proc_raw>& procs, uint64_t& cputimes);
+
+	//* Get drives from the latest frame and the Tools::steady_ms() time they were read at, returns false if not attached
+	bool read_drives(vector<Mem::drive_raw>& drives, uint64_t& time);
+
+	//* Get sensor values from the latest frame, <temp_max> and <core_mapping> are set if not nullptr.
+	//* Returns false if not attached or the daemon isn't running Libre Hardware Monitor
+	bool read_lhm(Cpu::OHMRraw& stats, long long* temp_max = nullptr, unordered_flat_map<int, int>* core_mapping = nullptr);
+}
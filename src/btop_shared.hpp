@@ -26,6 +26,8 @@ tab-size = 4
 #include <robin_hood.h>
 #include <array>
 #include <tuple>
+#include <memory>
+#include <functional>
 
 using std::string, std::vector, std::deque, robin_hood::unordered_flat_map, std::atomic, std::array, std::tuple;
 
@@ -58,7 +60,12 @@ namespace Runner {
 	extern bool pause_output;
 	extern string debug_bg;
 
+	//* Runs collect and draw for <box>, "all" for all shown boxes or several box names separated by whitespace
 	void run(const string& box="", const bool no_update=false, const bool force_redraw=false);
+
+	//* Update interval in ms for <box>, the box specific update_ms_<box> value if set, otherwise update_ms.
+	//* Includes changes from adaptive sampling for cpu and proc if <adaptive> is true
+	uint64_t interval(const string& box, const bool adaptive=true);
 	void stop();
 
 }
@@ -72,7 +79,44 @@ namespace Shared {
 	//* Initialize platform specific needed variables and check for errors
 	void init();
 
+	//* Set up collectors for modes running without the tui (batch, daemon and agent), called before init().
+	//* Boxes are never drawn, <cpu>, <mem>, <net> and <proc> tells which boxes the mode collects
+	void headless_setup(const bool cpu, const bool mem, const bool net, const bool proc);
+
 	extern long coreCount, page_size, clk_tck;
+
+	//* Multi resolution history of a graph series for the zoomed graph time scales. Keeps min, max and average of
+	//* completed buckets of 10 seconds, 1 minute and 10 minutes, at most <capacity> buckets per level (~36 KiB per series)
+	//* and never more than an equal share of <budget> bytes for all series alive, so many cores or disks shorten the history
+	class History {
+		static inline atomic<size_t> series = 0;
+	public:
+		static constexpr array<uint64_t, 3> bucket_ms = { 10'000, 60'000, 600'000 };
+		static constexpr size_t capacity = 512;
+		static constexpr size_t budget = 8 << 20;
+
+		History() { ++series; }
+		History(const History& other) : levels(other.levels) { ++series; }
+		History(History&& other) noexcept : levels(std::move(other.levels)) { ++series; }
+		History& operator=(const History& other) = default;
+		History& operator=(History&& other) noexcept = default;
+		~History() { --series; }
+
+		//* Buckets kept per level for the current number of series
+		static size_t limit();
+
+		struct Level {
+			deque<long long> min, max, avg;
+			//? True if the last add() completed a bucket
+			bool updated = false;
+			uint64_t bucket = 0;
+			long long b_min = 0, b_max = 0, b_sum = 0, b_count = 0;
+		};
+		array<Level, 3> levels;
+
+		//* Add <value> sampled at <now> ms from Tools::steady_ms(), buckets without any samples are stored as gaps
+		void add(const long long value, const uint64_t now);
+	};
 }
 
 
@@ -103,6 +147,7 @@ namespace Cpu {
 		unordered_flat_map<string, GpuRaw> GPUS;
 		vector<int> CPU;
 		int CpuClock = 0;
+		vector<string> GPUorder;
 	};
 
 	struct cpu_info {
@@ -113,9 +158,13 @@ namespace Cpu {
 			{"dpc", {}},
 			{"interrupt", {}},
 			{"idle", {}},
-			{"gpu", {}}
+			{"gpu", {}},
+			{"max", {}}
 		};
 		vector<deque<long long>> core_percent;
+		vector<deque<long long>> core_max;
+		unordered_flat_map<string, Shared::History> history;
+		vector<Shared::History> core_history;
 		vector<deque<long long>> temp;
 		deque<long long> gpu_temp;
 		long long temp_max = 100;
@@ -129,6 +178,12 @@ namespace Cpu {
 	string draw(const cpu_info& cpu, const bool force_redraw=false, const bool data_same=false);
 
 	extern unordered_flat_map<int, int> core_mapping;
+
+	extern cpu_info current_cpu;
+	extern bool has_OHMR;
+
+	//* Get the latest values collected from Libre Hardware Monitor
+	std::shared_ptr<const OHMRraw> get_OHMR();
 }
 
 namespace Mem {
@@ -147,8 +202,22 @@ namespace Mem {
 		deque<long long> io_read = {};
 		deque<long long> io_write = {};
 		deque<long long> io_activity = {};
+		unordered_flat_map<string, Shared::History> history;
 	};
 
+	//* Values of a mounted drive as read from the system, before filtering and rate calculations
+	struct drive_raw {
+		string letter, name;
+		unsigned type = 0;
+		bool has_space = false, has_io = false;
+		uint64_t total = 0, free = 0, free_priv = 0;
+		int64_t read = 0, written = 0, io_time = 0;
+	};
+
+	//* Read all mounted drives to <drives>, drives <wanted> returns false for after getting letter, name and type are not read further.
+	//* Returns false if the mounted drives couldn't be listed
+	bool get_drives(vector<drive_raw>& drives, const std::function<bool(const drive_raw&)>& wanted = nullptr);
+
 	struct mem_info {
 		unordered_flat_map<string, uint64_t> stats =
 		{ {"total", 0}, {"used", 0}, {"available", 0}, {"commit", 0}, {"commit_total", 0}, {"cached", 0},
@@ -156,6 +225,7 @@ namespace Mem {
 		unordered_flat_map<string, deque<long long>> percent =
 		{ {"used", {}}, {"available", {}}, {"commit", {}}, {"cached", {}},
 			{"page_used", {}}, {"page_free", {}}, {"gpu_used", {}}, {"gpu_free", {}} };
+		unordered_flat_map<string, Shared::History> history;
 		unordered_flat_map<string, disk_info> disks;
 		vector<string> disks_order;
 		bool pagevirt = false;
@@ -184,8 +254,12 @@ namespace Net {
 	struct net_info {
 		unordered_flat_map<string, deque<long long>> bandwidth = { {"download", {}}, {"upload", {}} };
 		unordered_flat_map<string, net_stat> stat = { {"download", {}}, {"upload", {}} };
+		unordered_flat_map<string, Shared::History> history;
 		string ipv4 = "", ipv6 = "";
 		bool connected = false;
+
+		//? Skipped by adaptive sampling, speed is zero and totals are from when it was last collected
+		bool stale = false;
 	};
 
 	extern unordered_flat_map<string, net_info> current_net;
@@ -211,6 +285,12 @@ namespace Proc {
 	extern atomic<uint64_t> WMItimer;
 	extern bool services_swap;
 
+	//* Busy cpu time of the whole system at the last process collection, in 100 ns units
+	extern uint64_t cputimes;
+
+	//* Set by input when only the selection or view moved, the runner then skips collect and redraws only changed rows
+	extern atomic<bool> selection_only;
+
 	//? Contains the valid sorting options for processes
 	const vector<string> sort_vector = {
 		"pid",
@@ -283,9 +363,12 @@ namespace Proc {
 	//* Collect and sort process information from /proc
 	auto collect(const bool no_update=false) -> vector<proc_info>&;
 
+	//* Sort <proc_vec> by <sorting>, <services> translates service sorting names to the matching process fields
+	void proc_sorter(vector<proc_info>& proc_vec, string sorting, const bool reverse, const bool tree=false, const bool services=false);
+
 	//* Update current selection and view, returns -1 if no change otherwise the current selection
 	int selection(const string& cmd_key);
 
-	//* Draw contents of proc box using <plist> as data source
-	string draw(const vector<proc_info>& plist, const bool force_redraw=false, const bool data_same=false);
+	//* Draw contents of proc box using <plist> as data source, <selection_only> allows redrawing only the rows that changed
+	string draw(const vector<proc_info>& plist, const bool force_redraw=false, const bool data_same=false, const bool selection_only=false);
 }
@@ -0,0 +1,308 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#include <bit>
+#include <cmath>
+#include <algorithm>
+
+#include <btop_stream.hpp>
+
+using std::max;
+
+namespace Stream {
+
+	void put_var(string& buf, uint64_t value) {
+		while (value >= 0x80) {
+			buf += (char)(value | 0x80);
+			value >>= 7;
+		}
+		buf += (char)value;
+	}
+
+	void put_int(string& buf, const int64_t value) {
+		put_var(buf, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+	}
+
+	void put_str(string& buf, const string_view str) {
+		put_var(buf, str.size());
+		buf.append(str);
+	}
+
+	void put_f32(string& buf, const float value) {
+		const uint32_t bits = std::bit_cast<uint32_t>(value);
+		for (int i = 0; i < 4; i++) buf += (char)(bits >> (i * 8));
+	}
+
+	void begin_frame(string& buf, const char type) {
+		buf.append(4, '\0');
+		buf += type;
+	}
+
+	void end_frame(string& buf, const size_t start) {
+		const uint32_t size = (uint32_t)(buf.size() - start - head_size);
+		for (int i = 0; i < 4; i++) buf[start + i] = (char)(size >> (i * 8));
+	}
+
+	uint32_t payload_size(const char* head) {
+		uint32_t size = 0;
+		for (int i = 0; i < 4; i++) size |= (uint32_t)(uint8_t)head[i] << (i * 8);
+		return size;
+	}
+
+	uint8_t Cursor::byte() {
+		if (pos >= data.size()) {
+			ok = false;
+			return 0;
+		}
+		return (uint8_t)data[pos++];
+	}
+
+	uint64_t Cursor::var() {
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			const uint8_t b = byte();
+			value |= (uint64_t)(b & 0x7f) << shift;
+			if (not (b & 0x80)) return value;
+		}
+		ok = false;
+		return 0;
+	}
+
+	int64_t Cursor::sint() {
+		const uint64_t value = var();
+		return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+	}
+
+	float Cursor::f32() {
+		uint32_t bits = 0;
+		for (int i = 0; i < 4; i++) bits |= (uint32_t)byte() << (i * 8);
+		return std::bit_cast<float>(bits);
+	}
+
+	string_view Cursor::str() {
+		const uint64_t len = var();
+		if (not ok or len > data.size() - pos) {
+			ok = false;
+			return {};
+		}
+		pos += len;
+		return data.substr(pos - len, len);
+	}
+
+	size_t Cursor::count(const size_t min_size) {
+		const uint64_t n = var();
+		if (not ok or n > (data.size() - pos) / min_size) {
+			ok = false;
+			return 0;
+		}
+		return (size_t)n;
+	}
+
+	Encoder::Field& Encoder::field(const string& name, const bool text) {
+		auto [it, added] = fields.try_emplace(name);
+		auto& f = it->second;
+		f.tick = tick;
+		if (added) {
+			f.id = next_id++;
+			put_var(defs, f.id);
+			defs += (char)text;
+			put_str(defs, name);
+			n_defs++;
+		}
+		return f;
+	}
+
+	void Encoder::begin(const bool keyframe) {
+		key = keyframe;
+		if (key) {
+			fields.clear();
+			procs.clear();
+			next_id = 0;
+		}
+		tick++;
+		for (auto* buf : {&defs, &values, &spawned, &changed}) buf->clear();
+		n_defs = n_values = n_spawned = n_changed = 0;
+	}
+
+	void Encoder::num(const string& name, const int64_t value) {
+		const size_t before = n_defs;
+		auto& f = field(name, false);
+		if (n_defs == before and f.num == value) return;
+		f.num = value;
+		put_var(values, f.id);
+		put_int(values, value);
+		n_values++;
+	}
+
+	void Encoder::text(const string& name, const string_view value) {
+		const size_t before = n_defs;
+		auto& f = field(name, true);
+		if (n_defs == before and f.str == value) return;
+		f.str = value;
+		put_var(values, f.id);
+		put_str(values, value);
+		n_values++;
+	}
+
+	void Encoder::proc(const Proc::proc_info& p) {
+		const uint64_t cpu_p = (uint64_t)std::llround(max(0.0, p.cpu_p) * 10);
+		const float cpu_c = (float)p.cpu_c;
+		auto [it, added] = procs.try_emplace(p.pid);
+		auto& s = it->second;
+
+		if (added or s.cpu_s != p.cpu_s) {
+			s = {p.cpu_s, p.threads, p.mem, cpu_p, tick, cpu_c, p.state};
+			put_var(spawned, p.pid);
+			put_var(spawned, p.ppid);
+			put_str(spawned, p.name);
+			put_str(spawned, string_view(p.cmd).substr(0, max_cmd));
+			put_str(spawned, p.user);
+			put_var(spawned, p.threads);
+			put_var(spawned, p.mem);
+			put_var(spawned, cpu_p);
+			put_f32(spawned, cpu_c);
+			spawned += p.state;
+			put_var(spawned, p.cpu_s);
+			n_spawned++;
+			return;
+		}
+		s.tick = tick;
+
+		//? The lazy cpu value drifts a little every update for every process, only changes above 1% are sent
+		uint8_t bits = 0;
+		if (p.threads != s.threads) bits |= bit_threads;
+		if (p.mem != s.mem) bits |= bit_mem;
+		if (cpu_p != s.cpu_p) bits |= bit_cpu_p;
+		if (std::abs(cpu_c - s.cpu_c) > max(0.01f, s.cpu_c * 0.01f)) bits |= bit_cpu_c;
+		if (p.state != s.state) bits |= bit_state;
+		if (bits == 0) return;
+
+		put_var(changed, p.pid);
+		changed += (char)bits;
+		if (bits & bit_threads) put_var(changed, s.threads = p.threads);
+		if (bits & bit_mem) put_var(changed, s.mem = p.mem);
+		if (bits & bit_cpu_p) put_var(changed, s.cpu_p = cpu_p);
+		if (bits & bit_cpu_c) put_f32(changed, s.cpu_c = cpu_c);
+		if (bits & bit_state) changed += (s.state = p.state);
+		n_changed++;
+	}
+
+	void Encoder::finish(string& out, const uint64_t time) {
+		stale_fields.clear();
+		for (const auto& [name, f] : fields) if (f.tick != tick) stale_fields.push_back(name);
+		stale_procs.clear();
+		for (const auto& [pid, s] : procs) if (s.tick != tick) stale_procs.push_back(pid);
+
+		const size_t start = out.size();
+		begin_frame(out, (key ? type_key : type_delta));
+		put_var(out, time);
+		put_var(out, n_defs);
+		out += defs;
+		put_var(out, n_values);
+		out += values;
+		put_var(out, stale_fields.size());
+		for (const auto& name : stale_fields) {
+			put_var(out, fields.at(name).id);
+			fields.erase(name);
+		}
+		put_var(out, n_spawned);
+		out += spawned;
+		put_var(out, n_changed);
+		out += changed;
+		put_var(out, stale_procs.size());
+		for (const auto pid : stale_procs) {
+			put_var(out, pid);
+			procs.erase(pid);
+		}
+		end_frame(out, start);
+	}
+
+	namespace {
+		void read_row(Cursor& in, Proc::proc_info& p) {
+			p.pid = (size_t)in.var();
+			p.ppid = in.var();
+			p.name = p.short_cmd = in.str();
+			p.cmd = in.str();
+			p.user = in.str();
+			p.threads = (size_t)in.var();
+			p.mem = in.var();
+			p.cpu_p = (double)in.var() / 10;
+			p.cpu_c = in.f32();
+			p.state = (char)in.byte();
+			p.cpu_s = in.var();
+		}
+	}
+
+	bool Decoder::apply(const char type, const string_view payload) {
+		if (type != type_key and type != type_delta) return true;
+		Cursor in(payload);
+		if (type == type_key) {
+			values.clear();
+			procs.clear();
+		}
+		const uint64_t frame_time = in.var();
+
+		for (size_t n = in.count(3); n > 0 and in.ok; n--) {
+			const uint64_t id = in.var();
+			const uint8_t kind = in.byte();
+			const string_view name = in.str();
+			if (id >= max_fields or kind > 1) return false;
+			if (id >= values.size()) values.resize(id + 1);
+			values[id] = {string(name), kind == 1, true, 0, {}};
+		}
+		for (size_t n = in.count(2); n > 0 and in.ok; n--) {
+			const uint64_t id = in.var();
+			if (id >= values.size() or not values[id].alive) return false;
+			auto& value = values[id];
+			if (value.text) value.str = in.str();
+			else value.num = in.sint();
+		}
+		for (size_t n = in.count(1); n > 0 and in.ok; n--) {
+			const uint64_t id = in.var();
+			if (id >= values.size()) return false;
+			values[id] = {};
+		}
+
+		Proc::proc_info row;
+		for (size_t n = in.count(14); n > 0 and in.ok; n--) {
+			read_row(in, row);
+			procs.insert_or_assign(row.pid, row);
+		}
+		for (size_t n = in.count(2); n > 0 and in.ok; n--) {
+			auto found = procs.find((size_t)in.var());
+			const uint8_t bits = in.byte();
+			row.threads = (bits & bit_threads ? (size_t)in.var() : 0);
+			row.mem = (bits & bit_mem ? in.var() : 0);
+			row.cpu_p = (bits & bit_cpu_p ? (double)in.var() / 10 : 0);
+			row.cpu_c = (bits & bit_cpu_c ? in.f32() : 0);
+			row.state = (bits & bit_state ? (char)in.byte() : 0);
+			if (found == procs.end()) continue;
+			auto& p = found->second;
+			if (bits & bit_threads) p.threads = row.threads;
+			if (bits & bit_mem) p.mem = row.mem;
+			if (bits & bit_cpu_p) p.cpu_p = row.cpu_p;
+			if (bits & bit_cpu_c) p.cpu_c = row.cpu_c;
+			if (bits & bit_state) p.state = row.state;
+		}
+		for (size_t n = in.count(1); n > 0 and in.ok; n--) procs.erase((size_t)in.var());
+
+		if (not in.done()) return false;
+		time = frame_time;
+		return true;
+	}
+}
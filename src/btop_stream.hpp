@@ -0,0 +1,154 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include <btop_shared.hpp>
+
+using std::string, std::string_view, std::vector;
+
+//* Binary frame format streamed from agents to viewers by the Remote module, kept free of sockets so it can be tested on its own.
+//* A frame is the payload size as 32-bit little endian, a type byte and the payload. Values are named fields given a numeric id
+//* the first time they are sent, processes are keyed by pid. Deltas only hold what changed since the previous frame
+namespace Stream {
+
+	enum frame_type : char { type_hello = 'H', type_key = 'K', type_delta = 'D' };
+
+	//* Frames between keyframes, agents also send a keyframe to everyone as soon as a new viewer connects
+	const size_t key_interval = 300;
+
+	//* Size of the frame header preceding the payload
+	const size_t head_size = 5;
+
+	//* Command lines are cut to this length
+	const size_t max_cmd = 4096;
+
+	//* Field ids at or above this are treated as a corrupt frame
+	const uint64_t max_fields = 1 << 16;
+
+	//? Values following a changed process, in order of the bits set
+	enum proc_bits : uint8_t { bit_threads = 1, bit_mem = 2, bit_cpu_p = 4, bit_cpu_c = 8, bit_state = 16 };
+
+	//* Unsigned LEB128 varint
+	void put_var(string& buf, uint64_t value);
+
+	//* Zigzag encoded varint, small negative values like graph gaps stay short
+	void put_int(string& buf, const int64_t value);
+
+	void put_str(string& buf, const string_view str);
+
+	void put_f32(string& buf, const float value);
+
+	//* Start a frame of <type> at the end of <buf>, the size is filled in by end_frame()
+	void begin_frame(string& buf, const char type);
+
+	//* Set the size of the frame started at offset <start> in <buf>
+	void end_frame(string& buf, const size_t start);
+
+	//* Payload size from the <head_size> bytes at <head>
+	uint32_t payload_size(const char* head);
+
+	//* Bounds checked reading of a frame payload, <ok> is cleared by the first read past the end or malformed value
+	class Cursor {
+		string_view data;
+		size_t pos = 0;
+	public:
+		bool ok = true;
+
+		Cursor(const string_view data) : data(data) {}
+
+		uint8_t byte();
+		uint64_t var();
+		int64_t sint();
+		float f32();
+
+		//* View into the payload, empty with <ok> cleared if the length is past the end
+		string_view str();
+
+		//* Length of a list with elements of at least <min_size> bytes, 0 with <ok> cleared if the payload is too short for it
+		size_t count(const size_t min_size);
+
+		bool done() const { return ok and pos == data.size(); }
+	};
+
+	//* Agent side, remembers what has been sent to encode only what changed since the last frame
+	class Encoder {
+		struct Field {
+			uint64_t id = 0, tick = 0;
+			int64_t num = 0;
+			string str;
+		};
+		struct Sent {
+			uint64_t cpu_s = 0, threads = 0, mem = 0, cpu_p = 0, tick = 0;
+			float cpu_c = 0;
+			char state = 0;
+		};
+
+		unordered_flat_map<string, Field> fields;
+		unordered_flat_map<size_t, Sent> procs;
+		uint64_t next_id = 0, tick = 0;
+		bool key = false;
+		string defs, values, spawned, changed;
+		size_t n_defs = 0, n_values = 0, n_spawned = 0, n_changed = 0;
+		vector<string> stale_fields;
+		vector<size_t> stale_procs;
+
+		Field& field(const string& name, const bool text);
+
+	public:
+		//* Start a new frame, a keyframe forgets everything sent before
+		void begin(const bool keyframe);
+
+		void num(const string& name, const int64_t value);
+
+		void text(const string& name, const string_view value);
+
+		//* Add a process, a pid seen with another start time <cpu_s> is sent as a new process replacing the old one
+		void proc(const Proc::proc_info& p);
+
+		//* Append the frame to <out>, values and processes not given since begin() are sent as removed
+		void finish(string& out, const uint64_t time);
+	};
+
+	//* Viewer side, current values and process table as applied from the stream
+	class Decoder {
+	public:
+		struct Value {
+			string name;
+			bool text = false, alive = false;
+			int64_t num = 0;
+			string str;
+		};
+
+		//? Indexed by field id, removed fields are kept with <alive> false
+		vector<Value> values;
+		unordered_flat_map<size_t, Proc::proc_info> procs;
+
+		//? Time the agent sent the last applied frame
+		uint64_t time = 0;
+
+		//* Apply a keyframe or delta, returns false if the payload is malformed. A frame rejected halfway can leave
+		//* the state partly updated, the stream should be resynced with a keyframe. Other frame types are ignored
+		bool apply(const char type, const string_view payload);
+	};
+}
@@ -259,7 +259,7 @@ namespace Theme {
 					}
 				}
 				if (not colors.contains(name) and not is_in(name, "meter_bg", "process_start", "process_mid", "process_end", "graph_text")) {
-					Logger::debug("Missing color value for \"" + name + "\". Using value from default.");
+					Logger::debug("Missing color value for \"", name, "\". Using value from default.");
 					colors[name] = hex_to_color(color, t_to_256, depth);
 					rgbs[name] = hex_to_dec(color);
 				}
@@ -382,7 +382,7 @@ namespace Theme {
 
 			std::ifstream themefile(filepath);
 			if (themefile.good()) {
-				Logger::debug("Loading theme file: " + filename);
+				Logger::debug("Loading theme file: ", filename);
 				while (not themefile.bad()) {
 					themefile.ignore(SSmax, '[');
 					if (themefile.eof()) break;
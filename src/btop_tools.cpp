@@ -498,30 +498,25 @@ namespace Tools {
 		return new_str;
 	}
 
-	string strf_time(const string& strf) {
-		const time_t in_time_t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+	string strf_time(const string& strf, const time_t time) {
+		const time_t in_time_t = (time > 0 ? time : std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
 		std::stringstream ss;
 		struct tm* bt = localtime(&in_time_t);
 		ss << std::put_time(bt, strf.c_str());
 		return ss.str();
 	}
 
-	void atomic_wait(const atomic<bool>& atom, const bool old) noexcept {
-		while (atom.load(std::memory_order_relaxed) == old );
-	}
-
-	void atomic_wait_for(const atomic<bool>& atom, const bool old, const uint64_t wait_ms) noexcept {
-		const uint64_t start_time = time_ms();
-		while (atom.load(std::memory_order_relaxed) == old and (time_ms() - start_time < wait_ms)) sleep_ms(1);
-	}
+	size_t SampleTimer::tick(const uint64_t interval, const size_t max_missed) {
+		const uint64_t now = steady_ms();
+		elapsed = (last == 0 ? 0 : now - last);
+		//? Use the longer of the current and last interval so a shortened interval doesn't make the current sample look late
+		const uint64_t expected = max(interval, last_interval);
+		last = now;
+		last_interval = interval;
 
-	atomic_lock::atomic_lock(atomic<bool>& atom, bool wait) : atom(atom) {
-		if (wait) while (not this->atom.compare_exchange_strong(this->not_true, true));
-		else this->atom.store(true);
-	}
-
-	atomic_lock::~atomic_lock() {
-		this->atom.store(false);
+		//? A sample more than 1.5 intervals after the last one is late, every whole interval in between is a missed sample
+		if (expected == 0 or elapsed * 2 <= expected * 3) return 0;
+		return std::min<uint64_t>(max_missed, (elapsed + expected / 2) / expected - 1);
 	}
 
 	string readfile(const std::filesystem::path& path, const string& fallback) {
@@ -686,41 +681,273 @@ namespace Tools {
 
 }
 
-namespace Logger {
+namespace Shared {
+	using Tools::graph_gap;
+
+	size_t History::limit() {
+		constexpr size_t series_bytes = bucket_ms.size() * 3 * sizeof(long long);
+		return std::clamp<size_t>(budget / (std::max<size_t>(series, 1) * series_bytes), 1, capacity);
+	}
+
+	void History::add(const long long value, const uint64_t now) {
+		const size_t max_size = limit();
+		for (size_t i = 0; i < levels.size(); i++) {
+			auto& l = levels[i];
+			const uint64_t bucket = now / bucket_ms[i];
+			l.updated = false;
+
+			//? Store the finished bucket when a new one starts, any buckets passed without samples are stored as gaps
+			if (l.bucket != 0 and bucket > l.bucket) {
+				const uint64_t missed = std::min<uint64_t>(max_size, bucket - l.bucket - 1);
+				const bool empty = (l.b_count == 0);
+				l.min.push_back(empty ? graph_gap : l.b_min);
+				l.max.push_back(empty ? graph_gap : l.b_max);
+				l.avg.push_back(empty ? graph_gap : l.b_sum / l.b_count);
+				for (auto* data : {&l.min, &l.max, &l.avg}) Tools::push_gaps(*data, missed);
+				l.b_count = l.b_sum = 0;
+				l.updated = true;
+			}
+			//? Also trims older series when the share of the budget shrinks because new series were added
+			for (auto* data : {&l.min, &l.max, &l.avg}) {
+				while (data->size() > max_size) data->pop_front();
+			}
+			if (l.bucket == 0 or bucket > l.bucket) l.bucket = bucket;
+
+			if (value == graph_gap) continue;
+			l.b_min = (l.b_count == 0 ? value : std::min(l.b_min, value));
+			l.b_max = (l.b_count == 0 ? value : std::max(l.b_max, value));
+			l.b_sum += value;
+			l.b_count++;
+		}
+	}
+}
+
+namespace Scheduler {
 	using namespace Tools;
-	std::atomic<bool> busy (false);
-	bool first = true;
-	const string tdf = "%Y/%m/%d (%T) | ";
 
-	size_t loglevel;
-	fs::path logfile;
+	struct task {
+		string name;
+		std::function<uint64_t()> interval;
+		std::function<void()> func;
+		std::function<uint64_t()> lead;
+		uint64_t nominal = 0;
+		uint64_t due_tick = 0;
+	};
+
+	vector<task> tasks;
+	array<vector<size_t>, slot_count> slots;
+	uint64_t current_tick = 0;
+
+	//? Place task at <index> in the wheel, due at its nominal time minus any lead, never earlier than the next tick
+	void arm(const size_t index) {
+		auto& t = tasks.at(index);
+		const uint64_t interval = max<uint64_t>(tick_ms, t.interval());
+		const uint64_t lead = (t.lead ? std::min(t.lead(), interval / 2) : 0);
+		t.due_tick = max(current_tick + 1, (t.nominal - std::min(lead, t.nominal) + tick_ms - 1) / tick_ms);
+		slots.at(t.due_tick % slot_count).push_back(index);
+	}
+
+	void add(const string& name, std::function<uint64_t()> interval, std::function<void()> func, std::function<uint64_t()> lead) {
+		const uint64_t now = steady_ms();
+		if (tasks.empty()) current_tick = now / tick_ms;
+		tasks.push_back({name, std::move(interval), std::move(func), std::move(lead)});
+		tasks.back().nominal = now + tasks.back().interval();
+		arm(tasks.size() - 1);
+	}
+
+	uint64_t run(const uint64_t now) {
+		//? Start over from <now> if the clock has been set back
+		if (now / tick_ms < current_tick) reset(now);
+		const uint64_t now_tick = now / tick_ms;
+		vector<size_t> due;
+
+		//? Only the slots passed since last run needs checking, tasks more than one revolution away stay in their slot
+		const uint64_t passed = std::min<uint64_t>(now_tick - std::min(current_tick, now_tick), slot_count);
+		for (uint64_t tick = now_tick - passed + 1; tick <= now_tick; tick++) {
+			auto& slot = slots.at(tick % slot_count);
+			for (auto it = slot.begin(); it != slot.end();) {
+				if (tasks.at(*it).due_tick <= now_tick) {
+					due.push_back(*it);
+					it = slot.erase(it);
+				}
+				else ++it;
+			}
+		}
+		current_tick = max(current_tick, now_tick);
 
+		rng::sort(due, [](const size_t a, const size_t b) { return tasks.at(a).due_tick < tasks.at(b).due_tick; });
+		for (const auto& index : due) {
+			auto& t = tasks.at(index);
+			t.func();
+			//? Keep the task on its grid unless it has fallen more than a full interval behind
+			const uint64_t interval = max<uint64_t>(tick_ms, t.interval());
+			t.nominal = (t.nominal + interval > now ? t.nominal + interval : now + interval);
+			arm(index);
+		}
 
-	void set(const string& level) {
-		loglevel = v_index(log_levels, level);
+		uint64_t next_tick = UINT64_MAX;
+		for (const auto& t : tasks) next_tick = std::min(next_tick, t.due_tick);
+		return (next_tick == UINT64_MAX ? 1000 : next_tick * tick_ms - std::min(next_tick * tick_ms, now));
 	}
 
-	void log_write(const size_t level, const string& msg) {
-		if (loglevel < level or logfile.empty()) return;
-		atomic_lock lck(busy, true);
-		std::error_code ec;
-		try {
-			if (fs::exists(logfile) and fs::file_size(logfile, ec) > 1024 << 10 and not ec) {
+	void rearm(const string& name, const uint64_t now) {
+		for (size_t i = 0; i < tasks.size(); i++) {
+			auto& t = tasks.at(i);
+			if (t.name != name or now + t.interval() >= t.nominal) continue;
+			std::erase(slots.at(t.due_tick % slot_count), i);
+			t.nominal = now + t.interval();
+			arm(i);
+		}
+	}
+
+	void reset(const uint64_t now) {
+		for (auto& slot : slots) slot.clear();
+		current_tick = now / tick_ms;
+		for (size_t i = 0; i < tasks.size(); i++) {
+			tasks.at(i).nominal = now + tasks.at(i).interval();
+			arm(i);
+		}
+	}
+}
+
+namespace Logger {
+	using namespace Tools;
+	atomic<size_t> loglevel (0);
+	fs::path logfile;
+
+	namespace {
+		const string tdf = "%Y/%m/%d (%T) | ";
+
+		//? The file is rotated to <logfile>.1 when a batch would take it past this size
+		const std::streamoff max_size = 1024 << 10;
+
+		//? Messages waiting for the writer, new messages are dropped and counted while the writer is this far behind
+		const size_t max_queued = 10'000;
+
+		//? Level of the entry pushed by flush() to stop the writer
+		const size_t stop_level = SIZE_MAX;
+
+		struct Entry {
+			Entry* next;
+			time_t time;
+			size_t level;
+			string msg;
+		};
+
+		//? Lock-free stack of queued messages, newest first. Producers push with a CAS, the writer takes the whole stack at once
+		atomic<Entry*> head (nullptr);
+		atomic<size_t> queued (0);
+		atomic<uint64_t> dropped (0);
+		atomic<bool> failed (false), stopping (false), stopped (false);
+		std::once_flag started;
+
+		void push(Entry* entry) {
+			entry->next = head.load(std::memory_order_relaxed);
+			while (not head.compare_exchange_weak(entry->next, entry, std::memory_order_release, std::memory_order_relaxed));
+			if (entry->next == nullptr) head.notify_one();
+		}
+
+		//* Opens the log, rotating it first if it's too large for <incoming> more bytes, returns false on failure
+		bool open(std::ofstream& out, const size_t incoming) {
+			std::error_code ec;
+			std::streamoff size = (out.is_open() ? (std::streamoff)out.tellp() : (std::streamoff)fs::file_size(logfile, ec));
+			if (ec) size = 0;
+			if (size > 0 and size + (std::streamoff)incoming > max_size) {
+				out.close();
 				auto old_log = logfile;
 				old_log += ".1";
-				if (fs::exists(old_log)) fs::remove(old_log, ec);
+				if (fs::exists(old_log, ec)) fs::remove(old_log, ec);
 				if (not ec) fs::rename(logfile, old_log, ec);
+				if (ec) return false;
 			}
-			if (not ec) {
-				std::ofstream lwrite(logfile, std::ios::app);
-				if (first) { first = false; lwrite << "\n" << strf_time(tdf) << "===> btop++ v." << Global::Version << "\n";}
-				lwrite << strf_time(tdf) << log_levels.at(level) << ": " << msg << "\n";
+			if (not out.is_open()) out.open(logfile, std::ios::app);
+			return out.good();
+		}
+
+		//* Writer thread, formats queued messages oldest first and writes them as one batch
+		void writer() {
+			std::ofstream out;
+			string batch, stamp;
+			time_t stamp_time = -1;
+			bool first = true;
+
+			while (true) {
+				head.wait(nullptr, std::memory_order_acquire);
+				Entry* entry = head.exchange(nullptr, std::memory_order_acquire);
+				Entry* ordered = nullptr;
+				while (entry != nullptr) {
+					Entry* next = entry->next;
+					entry->next = ordered;
+					ordered = entry;
+					entry = next;
+				}
+
+				batch.clear();
+				bool stop = false;
+				size_t count = 0;
+				for (entry = ordered; entry != nullptr;) {
+					if (entry->level == stop_level) stop = true;
+					else {
+						count++;
+						if (entry->time != stamp_time) {
+							stamp_time = entry->time;
+							stamp = strf_time(tdf, stamp_time);
+						}
+						if (first) {
+							first = false;
+							batch.append("\n").append(stamp).append("===> btop++ v.").append(Global::Version).append("\n");
+						}
+						batch.append(stamp).append(log_levels.at(entry->level)).append(": ").append(entry->msg) += '\n';
+					}
+					Entry* next = entry->next;
+					delete entry;
+					entry = next;
+				}
+				queued.fetch_sub(count, std::memory_order_relaxed);
+				if (const uint64_t lost = dropped.exchange(0, std::memory_order_relaxed); lost > 0)
+					batch.append(stamp).append("WARNING: Logger dropped ").append(to_string(lost)).append(" messages while writing was behind\n");
+
+				if (not batch.empty() and not failed) {
+					try {
+						if (open(out, batch.size())) out.write(batch.data(), batch.size()).flush();
+						if (not out.good()) failed = true;
+					}
+					catch (...) {
+						failed = true;
+					}
+				}
+
+				if (stop) {
+					stopped = true;
+					return;
+				}
 			}
-			else logfile.clear();
 		}
-		catch (const std::exception& e) {
-			logfile.clear();
-			throw std::runtime_error("Exception in Logger::log_write() : " + (string)e.what());
+	}
+
+	void set(const string& level) {
+		loglevel = v_index(log_levels, level);
+	}
+
+	void log_write(const size_t level, string msg) {
+		if (not enabled(level) or logfile.empty() or failed.load(std::memory_order_relaxed) or stopping.load(std::memory_order_relaxed)) return;
+		std::call_once(started, [] { std::thread(writer).detach(); });
+		if (queued.fetch_add(1, std::memory_order_relaxed) >= max_queued) {
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
 		}
+		push(new Entry{nullptr, std::time(nullptr), level, std::move(msg)});
+	}
+
+	void flush() {
+		if (stopping.exchange(true)) return;
+		bool running = true;
+		std::call_once(started, [&] { running = false; });
+		if (not running) return;
+		push(new Entry{nullptr, 0, stop_level, {}});
+
+		//? Exit is held up at most a second by a slow disk
+		for (int i = 0; i < 100 and not stopped; i++) sleep_ms(10);
 	}
 }
@@ -20,6 +20,7 @@ tab-size = 4
 #define NOMINMAX
 #include <string>
 #include <vector>
+#include <deque>
 #include <array>
 #include <atomic>
 #include <regex>
@@ -28,7 +29,12 @@ tab-size = 4
 #include <chrono>
 #include <thread>
 #include <tuple>
+#include <memory>
+#include <functional>
+#include <string_view>
+#include <type_traits>
 #include <robin_hood.h>
+#include <btop_atomic.hpp>
 #include <limits.h>
 #define WIN32_LEAN_AND_MEAN
 #define VC_EXTRALEAN
@@ -120,6 +126,16 @@ namespace Term {
 	const string clear_begin = Fx::e + "1J";
 	const string sync_start = Fx::e + "?2026h"; //? Start of terminal synchronized output
 	const string sync_end = Fx::e + "?2026l"; //? End of terminal synchronized output
+	const string scroll_reset = Fx::e + "r"; //? Reset scrolling region to full screen, also moves cursor to home
+
+	//* Set scrolling region to lines <top> through <bottom> (DECSTBM), also moves cursor to home
+	inline string scroll_region(const int& top, const int& bottom) { return Fx::e + to_string(top) + ';' + to_string(bottom) + 'r'; }
+
+	//* Scroll content of scrolling region up <x> lines, exposing blank lines at the bottom
+	inline string scroll_up(const int& x) { return Fx::e + to_string(x) + 'S'; }
+
+	//* Scroll content of scrolling region down <x> lines, exposing blank lines at the top
+	inline string scroll_down(const int& x) { return Fx::e + to_string(x) + 'T'; }
 
 	//* Returns true if terminal has been resized and updates width and height
 	bool refresh(bool only_check=false);
@@ -270,6 +286,19 @@ namespace Tools {
 		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 	}
 
+	//* Return milliseconds from a monotonic clock, for time between events since it never jumps with changes to the system clock
+	inline uint64_t steady_ms() {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	//* Value stored in graph histories in place of a missed sample, drawn as an empty column by Draw::Graph
+	const long long graph_gap = -1;
+
+	//* Add <count> missed samples to graph history <data>
+	inline void push_gaps(std::deque<long long>& data, const size_t count) {
+		for (size_t i = 0; i < count; i++) data.push_back(graph_gap);
+	}
+
 	//* Check if a string is a valid bool value
 	inline bool isbool(const string& str) {
 		return is_in(str, "true", "false", "True", "False");
@@ -340,23 +369,52 @@ namespace Tools {
 	//* Add std::string operator * : Repeat string <str> <n> number of times
 	std::string operator*(const string& str, int64_t n);
 
-	//* Return current time in <strf> format
-	string strf_time(const string& strf);
+	//* Return current time or <time> in seconds since epoch in <strf> format
+	string strf_time(const string& strf, const time_t time=0);
 
 	string hostname();
 	string username();
 
-	void atomic_wait(const atomic<bool>& atom, const bool old=true) noexcept;
+	//* Measures the time between samples of a graph history on a monotonic clock
+	class SampleTimer {
+		uint64_t last = 0, last_interval = 0;
+	public:
+		//* Milliseconds between the two last calls to tick(), 0 after the first call
+		uint64_t elapsed = 0;
 
-	void atomic_wait_for(const atomic<bool>& atom, const bool old=true, const uint64_t wait_ms=0) noexcept;
+		//* Register a new sample for data expected every <interval> ms, returns the number of samples missed since the last one up to <max_missed>
+		size_t tick(const uint64_t interval, const size_t max_missed);
+	};
 
-	//* Sets atomic<bool> to true on construct, sets to false on destruct
-	class atomic_lock {
-		atomic<bool>& atom;
-		bool not_true = false;
+	//* Versioned snapshot of a value produced by a background thread, RCU style
+	//* Producers build a new value and publish it with a pointer swap, readers get a consistent immutable snapshot
+	//* in O(1) that stays valid for as long as they hold it, without ever blocking the producer
+	template <typename T>
+	class snapshot_cell {
+		std::atomic<std::shared_ptr<const T>> current;
+		atomic<uint64_t> current_version = 0;
 	public:
-		atomic_lock(atomic<bool>& atom, bool wait=false);
-		~atomic_lock();
+		snapshot_cell() : current(std::make_shared<const T>()) {}
+		snapshot_cell(const snapshot_cell&) = delete;
+		snapshot_cell& operator=(const snapshot_cell&) = delete;
+
+		//* Get current snapshot
+		std::shared_ptr<const T> load() const { return current.load(std::memory_order_acquire); }
+
+		//* Replace current snapshot with <value>, old snapshots are freed when the last reader lets go
+		void publish(T&& value) {
+			current.store(std::make_shared<const T>(std::move(value)), std::memory_order_release);
+			current_version.fetch_add(1, std::memory_order_release);
+		}
+
+		//* Replace current snapshot with an already allocated <value>, used by producers reusing buffers no reader holds anymore
+		void publish(std::shared_ptr<const T> value) {
+			current.store(std::move(value), std::memory_order_release);
+			current_version.fetch_add(1, std::memory_order_release);
+		}
+
+		//* Number of times a new value has been published
+		uint64_t version() const { return current_version.load(std::memory_order_acquire); }
 	};
 
 	//* Read a complete file and return as a string
@@ -373,6 +431,28 @@ namespace Tools {
 
 }
 
+//* Timer wheel driving all periodic work from the main loop: box updates and the triggers for the background collectors.
+//* Tasks run on the main thread and should only do light work or hand off to another thread, all times are from Tools::steady_ms()
+namespace Scheduler {
+	//* Resolution of the wheel in milliseconds and number of slots, one revolution of the wheel covers 2.56 seconds
+	const uint64_t tick_ms = 10;
+	const size_t slot_count = 256;
+
+	//* Add task <name> running <func> every <interval>() ms, <interval> is read each time the task is re-armed.
+	//* <lead>() if set gives a number of ms the task should run ahead of the shared interval grid,
+	//* used for collectors that need to finish just before the boxes using their data are updated
+	void add(const string& name, std::function<uint64_t()> interval, std::function<void()> func, std::function<uint64_t()> lead = nullptr);
+
+	//* Run all tasks due at <now> ms in order of due time and re-arm them, returns ms until the next task is due
+	uint64_t run(const uint64_t now);
+
+	//* Re-arm all tasks starting from <now> ms, used when intervals have changed
+	void reset(const uint64_t now);
+
+	//* Move task <name> forward to be due one interval from <now> ms if that is sooner, used to pick up a shorter interval right away
+	void rearm(const string& name, const uint64_t now);
+}
+
 //* Simple logging implementation
 namespace Logger {
 	const vector<string> log_levels = {
@@ -384,13 +464,39 @@ namespace Logger {
 	};
 	extern std::filesystem::path logfile;
 
+	//* Index of the current level in <log_levels>
+	extern atomic<size_t> loglevel;
+
 	//* Set log level, valid arguments: "DISABLED", "ERROR", "WARNING", "INFO" and "DEBUG"
 	void set(const string& level);
 
-	void log_write(const size_t level, const string& msg);
-	inline void error(const string msg) { log_write(1, msg); }
-	inline void warning(const string msg) { log_write(2, msg); }
-	inline void info(const string msg) { log_write(3, msg); }
-	inline void debug(const string msg) { log_write(4, msg); }
+	//* Returns true if messages of <level> are written
+	inline bool enabled(const size_t level) { return loglevel.load(std::memory_order_relaxed) >= level; }
+
+	//* Queue <msg> for the writer thread, which keeps the file open and writes and rotates it in the background
+	void log_write(const size_t level, string msg);
+
+	//* Write all queued messages and stop the writer thread, messages logged after this are dropped. Called on exit
+	void flush();
+
+	inline void append(string& out, const std::string_view arg) { out.append(arg); }
+	inline void append(string& out, const char arg) { out += arg; }
+	template <typename T> requires std::is_arithmetic_v<T>
+	inline void append(string& out, const T arg) { out += to_string(arg); }
+
+	//* Arguments are only concatenated into a message if <level> is enabled, numbers are converted with std::to_string.
+	//* Prefer Logger::debug("Failed for ", name, ": ", code) over building the message with operator+ at the call site
+	template <typename... Args>
+	inline void log(const size_t level, const Args&... args) {
+		if (not enabled(level)) return;
+		string msg;
+		(append(msg, args), ...);
+		log_write(level, std::move(msg));
+	}
+
+	template <typename... Args> inline void error(const Args&... args) { Logger::log(1, args...); }
+	template <typename... Args> inline void warning(const Args&... args) { Logger::log(2, args...); }
+	template <typename... Args> inline void info(const Args&... args) { Logger::log(3, args...); }
+	template <typename... Args> inline void debug(const Args&... args) { Logger::log(4, args...); }
 }
 
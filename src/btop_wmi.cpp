@@ -0,0 +1,174 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#include <btop_wmi.hpp>
+
+namespace Wmi {
+
+	namespace {
+		namespace proc_column {
+			enum { ProcessId, ParentProcessId, Name, CommandLine, ExecutablePath, CreationDate, KernelModeTime, UserModeTime, PrivatePageCount, ReadTransferCount, WriteTransferCount };
+		}
+		const Query proc_query = {
+			"Win32_Process",
+			{ "ProcessId", "ParentProcessId", "Name", "CommandLine", "ExecutablePath", "CreationDate", "KernelModeTime", "UserModeTime", "PrivatePageCount", "ReadTransferCount", "WriteTransferCount" }
+		};
+
+		namespace svc_column {
+			enum { Name, ProcessId, AcceptPause, AcceptStop, StartMode, StartName, State, Caption, Description, ServiceType };
+		}
+		const Query svc_query = {
+			"Win32_Service",
+			{ "Name", "ProcessId", "AcceptPause", "AcceptStop", "StartMode", "StartName", "State", "Caption", "Description", "ServiceType" }
+		};
+
+		//? Compare UTF-16 <str> with UTF-8 <utf8>, only converts if <str> isn't plain ASCII
+		bool same(const wstring_view str, const string& utf8) {
+			for (const auto c : str) {
+				if (static_cast<uint32_t>(c) >= 0x80) return to_utf8(str) == utf8;
+			}
+			if (str.size() != utf8.size()) return false;
+			for (size_t i = 0; i < str.size(); i++) {
+				if (static_cast<char>(str[i]) != utf8[i]) return false;
+			}
+			return true;
+		}
+
+		//? Set <dst> to <src> converted to UTF-8 if changed
+		void assign(string& dst, const wstring_view src) {
+			if (same(src, dst)) return;
+			dst.clear();
+			to_utf8(src, dst);
+		}
+	}
+
+	ProcMap update_procs(Enumerator& wmi, const ProcMap& previous, const unordered_flat_set<size_t>& requests) {
+		namespace col = proc_column;
+		ProcMap procs;
+		procs.reserve(previous.size());
+
+		wmi.query(proc_query, [&](const Row& row) {
+			const size_t pid = row.num(col::ProcessId);
+			if (pid == 0) return;
+			const auto old = previous.find(pid);
+
+			if (not requests.empty() and not requests.contains(pid)) {
+				if (old != previous.end()) procs.emplace(pid, old->second);
+				return;
+			}
+
+			ProcEntry entry;
+			if (old != previous.end())
+				entry.info = old->second.info;
+			else {
+				auto info = std::make_shared<ProcInfo>();
+				info->ParentProcessId = static_cast<uint32_t>(row.num(col::ParentProcessId));
+				to_utf8(row.str(col::Name), info->Name);
+				to_utf8(row.str(col::CommandLine), info->CommandLine);
+				to_utf8(row.str(col::ExecutablePath), info->ExecutablePath);
+				to_utf8(row.str(col::CreationDate), info->CreationDate);
+				entry.info = std::move(info);
+			}
+			entry.KernelModeTime = row.num(col::KernelModeTime);
+			entry.UserModeTime = row.num(col::UserModeTime);
+			entry.PrivateMemory = row.num(col::PrivatePageCount);
+			entry.ReadTransferCount = row.num(col::ReadTransferCount);
+			entry.WriteTransferCount = row.num(col::WriteTransferCount);
+			procs.emplace(pid, std::move(entry));
+		});
+
+		return procs;
+	}
+
+	SvcMap update_services(Enumerator& wmi, const SvcMap& previous) {
+		namespace col = svc_column;
+		SvcMap svcs;
+		svcs.reserve(previous.size());
+		string name;
+
+		wmi.query(svc_query, [&](const Row& row) {
+			name.clear();
+			to_utf8(row.str(col::Name), name);
+			if (name.empty()) return;
+			const auto old = previous.find(name);
+
+			SvcEntry entry;
+			if (old != previous.end())
+				entry = old->second;
+			else {
+				auto info = std::make_shared<SvcInfo>();
+				to_utf8(row.str(col::Caption), info->Caption);
+				to_utf8(row.str(col::Description), info->Description);
+				to_utf8(row.str(col::ServiceType), info->ServiceType);
+				entry.info = std::move(info);
+			}
+			entry.ProcessID = static_cast<uint32_t>(row.num(col::ProcessId));
+			entry.AcceptPause = (row.num(col::AcceptPause) != 0);
+			entry.AcceptStop = (row.num(col::AcceptStop) != 0);
+			assign(entry.StartMode, row.str(col::StartMode));
+			assign(entry.Owner, row.str(col::StartName));
+			assign(entry.State, row.str(col::State));
+			svcs.emplace(name, std::move(entry));
+		});
+
+		return svcs;
+	}
+
+	void to_utf8(const wstring_view str, string& out) {
+		out.reserve(out.size() + str.size());
+		for (size_t i = 0; i < str.size(); i++) {
+			uint32_t c = static_cast<uint32_t>(str[i]);
+			if (c < 0x80) {
+				out.push_back(static_cast<char>(c));
+				continue;
+			}
+			//? Combine UTF-16 surrogate pairs, unpaired surrogates are replaced with U+FFFD
+			if (c >= 0xD800 and c <= 0xDFFF) {
+				const uint32_t low = (i + 1 < str.size() ? static_cast<uint32_t>(str[i + 1]) : 0);
+				if (c <= 0xDBFF and low >= 0xDC00 and low <= 0xDFFF) {
+					c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+					i++;
+				}
+				else
+					c = 0xFFFD;
+			}
+			if (c < 0x800) {
+				out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+			}
+			else if (c < 0x10000) {
+				out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+				out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+			}
+			else {
+				out.push_back(static_cast<char>(0xF0 | (c >> 18)));
+				out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+			}
+			out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+		}
+	}
+
+	uint64_t to_uint(const wstring_view str) {
+		uint64_t num = 0;
+		for (const auto c : str) {
+			if (c < L'0' or c > L'9') break;
+			num = num * 10 + static_cast<uint64_t>(c - L'0');
+		}
+		return num;
+	}
+}
@@ -0,0 +1,118 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <robin_hood.h>
+
+using std::string, std::string_view, std::wstring_view, std::vector, robin_hood::unordered_flat_map, robin_hood::unordered_flat_set;
+
+//* Process and service information from WMI, used to fill in what the Win32 API can't read for processes of other users.
+//* Queries go through an Enumerator so the caching here doesn't depend on COM. Each update builds a new snapshot from the
+//* previous one in a single pass over the result, strings are only converted for rows not seen before or values that changed
+namespace Wmi {
+
+	//* A row of a query result, <column> is the index in Query::columns
+	class Row {
+	public:
+		virtual ~Row() = default;
+
+		//* String value of <column>, empty if null
+		virtual wstring_view str(const size_t column) const = 0;
+
+		//* Integer or boolean value of <column>, CIM uint64 values returned as strings are parsed, 0 if null
+		virtual uint64_t num(const size_t column) const = 0;
+	};
+
+	//* Selects <columns> from WMI class <from>
+	struct Query {
+		string from;
+		vector<string> columns;
+	};
+
+	//* Runs queries against WMI, implemented with IWbemServices by Shared::WbemQuery
+	class Enumerator {
+	public:
+		virtual ~Enumerator() = default;
+
+		//* Run <query> and call <row_callback> for each row, throws std::runtime_error if the query fails
+		virtual void query(const Query& query, const std::function<void(const Row&)>& row_callback) = 0;
+	};
+
+	//* Values of a process that don't change, converted when the pid is first seen and shared between snapshots
+	struct ProcInfo {
+		uint32_t ParentProcessId = 0;
+		string Name;
+		string CommandLine;
+		string ExecutablePath;
+		string CreationDate;
+	};
+
+	struct ProcEntry {
+		std::shared_ptr<const ProcInfo> info;
+		uint64_t KernelModeTime = 0;
+		uint64_t UserModeTime = 0;
+		uint64_t PrivateMemory = 0;
+		uint64_t ReadTransferCount = 0;
+		uint64_t WriteTransferCount = 0;
+	};
+
+	//* Values of a service that don't change, converted when the service is first seen and shared between snapshots
+	struct SvcInfo {
+		string Caption;
+		string Description;
+		string ServiceType;
+	};
+
+	struct SvcEntry {
+		std::shared_ptr<const SvcInfo> info;
+		uint32_t ProcessID = 0;
+		bool AcceptPause = false;
+		bool AcceptStop = false;
+		string StartMode;
+		string Owner;
+		string State;
+	};
+
+	using ProcMap = unordered_flat_map<size_t, ProcEntry>;
+	using SvcMap = unordered_flat_map<string, SvcEntry>;
+
+	//* Get a new process snapshot from a Win32_Process query and <previous>, processes missing from the result are dropped.
+	//* If <requests> isn't empty only those pids are refreshed, other pids keep their previous values and unknown pids are skipped
+	ProcMap update_procs(Enumerator& wmi, const ProcMap& previous, const unordered_flat_set<size_t>& requests);
+
+	//* Get a new service snapshot from a Win32_Service query and <previous>, services missing from the result are dropped
+	SvcMap update_services(Enumerator& wmi, const SvcMap& previous);
+
+	//* Append UTF-16 <str> converted to UTF-8 to <out>
+	void to_utf8(const wstring_view str, string& out);
+
+	inline string to_utf8(const wstring_view str) {
+		string out;
+		to_utf8(str, out);
+		return out;
+	}
+
+	//* Parse the unsigned decimal number at the start of <str>, 0 if none
+	uint64_t to_uint(const wstring_view str);
+}
@@ -0,0 +1,56 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include <btop_accounts.hpp>
+
+namespace Fake {
+	using std::string;
+
+	//* Account resolver with injected latency. Ids starting with "bad" fail and ids starting with "hang" block for
+	//* <hang_ms>, other ids resolve to "user_<id>". Counters are shared so they can be read after the cache took ownership
+	class Resolver : public Accounts::Resolver {
+	public:
+		struct Counters {
+			std::atomic<int> lookups = 0, finished = 0;
+		};
+
+		Resolver(const uint64_t latency_ms, const uint64_t hang_ms, std::shared_ptr<Counters> counters)
+			: latency_ms(latency_ms), hang_ms(hang_ms), counters(std::move(counters)) {}
+
+		bool lookup(const string& id, string& name) override {
+			counters->lookups++;
+			std::this_thread::sleep_for(std::chrono::milliseconds(id.starts_with("hang") ? hang_ms : latency_ms));
+			counters->finished++;
+			if (id.starts_with("bad")) return false;
+			name = "user_" + id;
+			return true;
+		}
+	private:
+		uint64_t latency_ms, hang_ms;
+		std::shared_ptr<Counters> counters;
+	};
+}
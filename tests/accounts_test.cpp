@@ -0,0 +1,139 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <btop_accounts.hpp>
+
+#include "testing.hpp"
+#include "accounts_fake.hpp"
+
+using std::string, std::vector;
+using namespace std::chrono_literals;
+
+namespace {
+	using Accounts::status;
+	using clock = std::chrono::steady_clock;
+
+	constexpr uint64_t latency_ms = 300, hang_ms = 5000, timeout_ms = 1000;
+	constexpr size_t max_workers = 4;
+
+	struct Frame {
+		size_t resolved = 0, pending = 0, failed = 0;
+		double micros = 0;
+	};
+
+	//? One runner pass, every process asks for the name of its owner
+	Frame frame(Accounts::Cache& cache, const vector<string>& owners) {
+		Frame f;
+		const auto start = clock::now();
+		for (const auto& id : owners) {
+			string name;
+			switch (cache.get(id, name)) {
+				case status::resolved: f.resolved++; break;
+				case status::pending: f.pending++; break;
+				case status::failed: f.failed++; break;
+			}
+		}
+		f.micros = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+		return f;
+	}
+
+	double seconds_since(const clock::time_point start) {
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	//? 2000 processes owned by 40 accounts, 2 accounts fail and 1 hangs for 5 seconds. Frames never wait for lookups
+	//? and every account that can be resolved is resolved long before the hung lookup returns
+	void test_scenario() {
+		auto counters = std::make_shared<Fake::Resolver::Counters>();
+		Accounts::Cache cache(std::make_unique<Fake::Resolver>(latency_ms, hang_ms, counters), timeout_ms, 60000, max_workers);
+
+		vector<string> owners;
+		for (size_t i = 0; i < 2000; i++) {
+			const size_t account = i % 40;
+			owners.push_back(account == 0 ? "hang0" : (account < 3 ? "bad" + std::to_string(account) : "S-1-5-21-" + std::to_string(account)));
+		}
+
+		const auto start = clock::now();
+		Frame f;
+		double worst = 0;
+		while (seconds_since(start) < hang_ms / 1000.0) {
+			f = frame(cache, owners);
+			worst = std::max(worst, f.micros);
+			if (f.pending == 0) break;
+			std::this_thread::sleep_for(50ms);
+		}
+		const double elapsed = seconds_since(start);
+		std::printf("scenario: resolved in %.2f s, worst frame %.0f us, %d lookups\n", elapsed, worst, counters->lookups.load());
+
+		CHECK(f.pending == 0);
+		CHECK(f.resolved == 2000 - 3 * 50);
+		CHECK(f.failed == 3 * 50);
+		CHECK(elapsed < hang_ms / 1000.0);
+		CHECK(counters->lookups == 40);
+
+		string name;
+		CHECK(cache.get("S-1-5-21-3", name) == status::resolved and name == "user_S-1-5-21-3");
+		CHECK(cache.get("bad1", name) == status::failed);
+		CHECK(cache.get("hang0", name) == status::failed);
+	}
+
+	//? As many hung lookups as workers, and their accounts are never asked for again (the processes exited).
+	//? The hung workers must still be noticed and replaced so the other accounts get resolved
+	void test_hung_workers() {
+		auto counters = std::make_shared<Fake::Resolver::Counters>();
+		Accounts::Cache cache(std::make_unique<Fake::Resolver>(latency_ms, hang_ms, counters), timeout_ms, 60000, max_workers);
+
+		vector<string> hung;
+		for (size_t i = 0; i < max_workers; i++) hung.push_back("hang" + std::to_string(i));
+		frame(cache, hung);
+		std::this_thread::sleep_for(50ms);
+
+		vector<string> owners;
+		for (size_t i = 0; i < 20; i++) owners.push_back("S-1-5-21-" + std::to_string(i));
+
+		const auto start = clock::now();
+		Frame f;
+		while (seconds_since(start) < hang_ms / 1000.0) {
+			f = frame(cache, owners);
+			if (f.pending == 0) break;
+			std::this_thread::sleep_for(50ms);
+		}
+		const double elapsed = seconds_since(start);
+		std::printf("hung workers: resolved in %.2f s, %d of %d lookups finished\n", elapsed, counters->finished.load(), counters->lookups.load());
+
+		CHECK(f.resolved == owners.size());
+		CHECK(elapsed < hang_ms / 1000.0);
+		CHECK(counters->finished == (int)owners.size());
+	}
+}
+
+int main() {
+	test_scenario();
+	test_hung_workers();
+
+	//? Hung lookups still sleeping in detached workers only hold on to the cache state and the shared counters
+	std::fflush(stdout);
+	return Testing::result("accounts_test");
+}
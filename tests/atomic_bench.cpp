@@ -0,0 +1,178 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+	#define NOMINMAX
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+#include <btop_atomic.hpp>
+
+#include "testing.hpp"
+
+using std::vector, std::function;
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+	//* Waiting as done before atomic_wait() blocked on std::atomic::wait() and atomic_wait_for() on a condition variable
+	namespace Old {
+		void atomic_wait(const atomic<bool>& atom, const bool old) {
+			while (atom.load(std::memory_order_relaxed) == old);
+		}
+
+		void atomic_wait_for(const atomic<bool>& atom, const bool old, const uint64_t wait_ms) {
+			const auto start = clock_type::now();
+			while (atom.load(std::memory_order_relaxed) == old and clock_type::now() - start < std::chrono::milliseconds(wait_ms))
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		//? The old waiting lock left the expected value at true after its first failed exchange and then took a lock
+		//? that was still held, this spins with the expected value reset as it was meant to
+		class atomic_lock {
+			atomic<bool>& atom;
+		public:
+			atomic_lock(atomic<bool>& atom, const bool wait) : atom(atom) {
+				if (not wait) {
+					atom.store(true);
+					return;
+				}
+				bool expected = false;
+				while (not atom.compare_exchange_strong(expected, true)) expected = false;
+			}
+			~atomic_lock() { atom.store(false); }
+		};
+	}
+
+	//* CPU time used by the calling thread in milliseconds
+	double thread_cpu_ms() {
+	#ifdef _WIN32
+		FILETIME creation, exit, kernel, user;
+		if (not GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) return 0;
+		const auto ticks = [](const FILETIME& ft) { return ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime; };
+		return (double)(ticks(kernel) + ticks(user)) / 10'000;
+	#else
+		timespec ts;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+		return (double)ts.tv_sec * 1000 + (double)ts.tv_nsec / 1'000'000;
+	#endif
+	}
+
+	//* Wait for a flag held by another thread, <lock> waits by taking the lock itself and <notify> uses the
+	//* Tools implementation where releasing the flag wakes the waiter
+	struct Variant {
+		const char* name;
+		function<void(atomic<bool>&)> wait;
+		bool lock = false;
+		bool notify = false;
+	};
+
+	struct Round {
+		double latency_us = 0, cpu_ms = 0, wall_ms = 0;
+		bool woken = false;
+	};
+
+	//* Hold the flag, start a waiter and release the flag <settle_ms> after the waiter started waiting
+	Round run(const Variant& v, const int settle_ms) {
+		atomic<bool> flag (false), entered (false);
+		std::optional<Tools::atomic_lock> held_new;
+		std::optional<Old::atomic_lock> held_old;
+		if (v.notify) held_new.emplace(flag);
+		else held_old.emplace(flag, false);
+
+		Round round;
+		clock_type::time_point woke;
+		std::thread waiter([&] {
+			const double cpu_start = thread_cpu_ms();
+			const auto start = clock_type::now();
+			entered = true;
+			v.wait(flag);
+			woke = clock_type::now();
+			round.cpu_ms = thread_cpu_ms() - cpu_start;
+			round.wall_ms = std::chrono::duration<double, std::milli>(woke - start).count();
+			round.woken = (v.lock or not flag.load());
+		});
+		while (not entered) std::this_thread::yield();
+		std::this_thread::sleep_for(std::chrono::milliseconds(settle_ms));
+
+		const auto released = clock_type::now();
+		held_new.reset();
+		held_old.reset();
+		waiter.join();
+		round.latency_us = std::chrono::duration<double, std::micro>(woke - released).count();
+		return round;
+	}
+
+	double percentile(const vector<double>& sorted, const double p) {
+		return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+	}
+}
+
+//* Wake-up latency after the flag is released and CPU used by the waiting thread, for the spinning and polling waits
+//* used before and the blocking waits in btop_atomic.cpp. Latency is measured over <rounds> waits of a few ms, idle
+//* CPU over one wait of <idle_ms>.
+//* Usage: atomic_bench [rounds] [idle_ms]
+int main(int argc, char** argv) {
+	const int rounds = (argc > 1 ? std::max(1, std::atoi(argv[1])) : 200);
+	const int idle_ms = (argc > 2 ? std::max(10, std::atoi(argv[2])) : 500);
+
+	//? Timed waits get a timeout far past the hold time so they are always ended by the release
+	constexpr uint64_t timeout_ms = 60'000;
+	const vector<Variant> variants = {
+		{"atomic_wait spin", [](atomic<bool>& f) { Old::atomic_wait(f, true); }},
+		{"atomic_wait", [](atomic<bool>& f) { Tools::atomic_wait(f, true); }, false, true},
+		{"atomic_wait_for poll", [](atomic<bool>& f) { Old::atomic_wait_for(f, true, timeout_ms); }},
+		{"atomic_wait_for", [](atomic<bool>& f) { Tools::atomic_wait_for(f, true, timeout_ms); }, false, true},
+		{"atomic_lock spin", [](atomic<bool>& f) { Old::atomic_lock lck(f, true); }, true},
+		{"atomic_lock", [](atomic<bool>& f) { Tools::atomic_lock lck(f, true); }, true, true},
+	};
+
+	std::printf("%d handoffs after 2 ms, idle cpu over %d ms, %u hardware threads\n", rounds, idle_ms, std::thread::hardware_concurrency());
+	for (const auto& v : variants) {
+		vector<double> latencies;
+		for (int i = 0; i < rounds; i++) {
+			const auto round = run(v, 2);
+			if (not CHECK(round.woken)) break;
+			latencies.push_back(round.latency_us);
+		}
+		const auto idle = run(v, idle_ms);
+		CHECK(idle.woken and idle.wall_ms < timeout_ms);
+		const double idle_pct = idle.cpu_ms * 100 / idle.wall_ms;
+
+		//? The blocking waits should sleep through the whole hold
+		if (v.notify) CHECK(idle_pct < 10);
+
+		if (latencies.empty()) continue;
+		std::ranges::sort(latencies);
+		std::printf("%-22s p50 %9.1f us  p99 %9.1f us  max %9.1f us  idle cpu %5.1f%%\n",
+			v.name, percentile(latencies, 0.50), percentile(latencies, 0.99), latencies.back(), idle_pct);
+	}
+	return Testing::result("atomic_bench");
+}
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+# Generates the Libre Hardware Monitor output fixtures used by tests/lhm_test.cpp and tests/lhm_bench.cpp.
+# These are synthesized, not captured: sensor names, types and section order are modeled on the sensors Libre Hardware Monitor
+# registers for each kind of system, so layouts that differ on real hardware (sensor order, extra sections, firmware specific
+# names) are not covered. Values are random but fixed per tick so <system>.<tick>.txt files share a layout and differ in values.
+# Real FetchLHMValues() dumps go in captured/<system>.txt and are checked by lhm_test against the reference parser as is.
+# Run from this directory: python3 generate.py
+import random
+random.seed(7)
+def cpu(name, ident, pcores, ecores, amd=False, tick=0):
+    r=random.Random(tick)
+    L=[f"Hardware\t{name}\t{ident}"]
+    cores=pcores+ecores
+    if amd:
+        for c in range(cores): L.append(f"Core #{c+1}\tClock\t{r.randint(3000,5700)}")
+        L.append(f"Bus Speed\tClock\t100")
+        L.append(f"Core (Tctl/Tdie)\tTemperature\t{r.randint(40,90)}")
+        L.append(f"Core (Tctl)\tTemperature\t{r.randint(40,90)}")
+        for c in range(2): L.append(f"CCD{c+1} (Tdie)\tTemperature\t{r.randint(40,90)}")
+        L.append(f"Package\tPower\t{r.uniform(20,230):.3f}")
+        for c in range(cores): L.append(f"Core #{c+1} (SMU)\tPower\t{r.uniform(0,20):.3f}")
+        for c in range(cores): L.append(f"Core #{c+1} VID\tVoltage\t{r.uniform(0.8,1.4):.4f}")
+        for t in range(cores*2): L.append(f"CPU Core #{t//2+1} Thread #{t%2+1}\tLoad\t{r.uniform(0,100):.2f}")
+        L.append(f"CPU Total\tLoad\t{r.uniform(0,100):.2f}")
+    else:
+        L.append(f"Bus Speed\tClock\t100")
+        for c in range(cores): L.append(f"CPU Core #{c+1}\tClock\t{r.randint(800,5200)}")
+        for c in range(cores): L.append(f"CPU Core #{c+1}\tTemperature\t{r.randint(30,100)}")
+        L.append(f"CPU Package\tTemperature\t{r.randint(30,100)}")
+        L.append(f"Core Max\tTemperature\t{r.randint(30,100)}")
+        L.append(f"Core Average\tTemperature\t{r.randint(30,100)}")
+        for c in range(cores): L.append(f"CPU Core #{c+1} Distance to TjMax\tTemperature\t{r.randint(0,70)}")
+        threads=pcores*2+ecores
+        for t in range(threads): L.append(f"CPU Core #{t+1}\tLoad\t{r.uniform(0,100):.2f}")
+        L.append(f"CPU Total\tLoad\t{r.uniform(0,100):.2f}")
+        L.append(f"CPU Core Max\tLoad\t{r.uniform(0,100):.2f}")
+        for n in ["CPU Package","CPU Cores","CPU Graphics","CPU Memory"]: L.append(f"{n}\tPower\t{r.uniform(0,200):.3f}")
+        L.append(f"CPU Core\tVoltage\t{r.uniform(0.7,1.4):.4f}")
+        for c in range(cores): L.append(f"CPU Core #{c+1}\tVoltage\t{r.uniform(0.7,1.4):.4f}")
+    return L
+def board(tick):
+    r=random.Random(tick+1)
+    L=["Hardware\tASUS ROG STRIX Z690-A\tMotherboard","Hardware\tNuvoton NCT6798D\tSuperIO"]
+    for i in range(14): L.append(f"Voltage #{i+1}\tVoltage\t{r.uniform(0,12):.3f}")
+    L.append(f"CPU\tTemperature\t{r.randint(30,80)}")
+    L.append(f"System\tTemperature\t{r.randint(25,50)}")
+    for i in range(5): L.append(f"Temperature #{i+1}\tTemperature\t{r.randint(20,60)}")
+    for i in range(7): L.append(f"Fan #{i+1}\tFan\t{r.randint(0,2000)}")
+    for i in range(7): L.append(f"Fan Control #{i+1}\tControl\t{r.uniform(0,100):.1f}")
+    return L
+def mem(tick):
+    r=random.Random(tick+2)
+    return ["Hardware\tGeneric Memory\tMemory",f"Memory Used\tData\t{r.uniform(5,30):.3f}",f"Memory Available\tData\t{r.uniform(5,30):.3f}",f"Memory\tLoad\t{r.uniform(0,100):.2f}",f"Virtual Memory Used\tData\t{r.uniform(5,30):.3f}",f"Virtual Memory Available\tData\t{r.uniform(5,30):.3f}",f"Virtual Memory\tLoad\t{r.uniform(0,100):.2f}"]
+def nvidia(name, idx, tick):
+    r=random.Random(tick+10+idx)
+    L=[f"Hardware\t{name}\tGpuNvidia"]
+    L+= [f"GPU Core\tClock\t{r.randint(200,2800)}",f"GPU Memory\tClock\t{r.randint(400,10000)}",f"GPU Core\tTemperature\t{r.randint(30,85)}",f"GPU Hot Spot\tTemperature\t{r.randint(30,95)}",
+         f"GPU Core\tLoad\t{r.randint(0,100)}",f"GPU Memory Controller\tLoad\t{r.randint(0,100)}",f"GPU Video Engine\tLoad\t{r.randint(0,100)}",f"GPU Bus\tLoad\t{r.randint(0,100)}",f"GPU Memory\tLoad\t{r.uniform(0,100):.2f}",
+         f"D3D 3D\tLoad\t{r.uniform(0,100):.2f}",f"D3D Copy\tLoad\t{r.uniform(0,100):.2f}",f"D3D Video Decode\tLoad\t{r.uniform(0,100):.2f}",
+         f"GPU Fan\tFan\t{r.randint(0,3000)}",f"GPU Fan 1\tControl\t{r.randint(0,100)}",f"GPU Package\tPower\t{r.uniform(10,450):.2f}",
+         f"GPU Memory Total\tSmallData\t24564",f"GPU Memory Free\tSmallData\t{r.randint(1000,20000)}",f"GPU Memory Used\tSmallData\t{r.randint(500,20000)}",
+         f"D3D Dedicated Memory Used\tSmallData\t{r.randint(500,20000)}",f"D3D Shared Memory Used\tSmallData\t{r.randint(0,500)}",
+         f"GPU PCIe Rx\tThroughput\t{r.uniform(0,1e8):.0f}",f"GPU PCIe Tx\tThroughput\t{r.uniform(0,1e8):.0f}"]
+    return L
+def intelgpu(tick):
+    r=random.Random(tick+20)
+    return ["Hardware\tIntel(R) UHD Graphics 770\tGpuIntel",f"GPU Power\tPower\t{r.uniform(0,10):.2f}",f"D3D 3D\tLoad\t{r.uniform(0,100):.2f}",f"D3D Video Decode\tLoad\t{r.uniform(0,100):.2f}",f"D3D Shared Memory Used\tSmallData\t{r.randint(50,800)}"]
+def amdgpu(tick):
+    r=random.Random(tick+30)
+    return ["Hardware\tAMD Radeon RX 7900 XTX\tGpuAmd",f"GPU Core\tVoltage\t{r.uniform(0.7,1.2):.3f}",f"GPU Core\tClock\t{r.randint(500,2900)}",f"GPU Memory\tClock\t{r.randint(400,2500)}",f"GPU Core\tTemperature\t{r.randint(30,90)}",f"GPU Hot Spot\tTemperature\t{r.randint(30,100)}",f"GPU Core\tLoad\t{r.randint(0,100)}",f"GPU Memory\tLoad\t{r.randint(0,100)}",f"GPU Fan\tFan\t{r.randint(0,3000)}",f"GPU Package\tPower\t{r.uniform(10,400):.1f}",f"D3D 3D\tLoad\t{r.uniform(0,100):.2f}",f"GPU Memory Used\tSmallData\t{r.randint(500,20000)}",f"GPU Memory Free\tSmallData\t{r.randint(500,20000)}",f"GPU Memory Total\tSmallData\t24560",f"D3D Shared Memory Used\tSmallData\t{r.randint(0,500)}"]
+def storage(n,tick):
+    r=random.Random(tick+40)
+    L=[]
+    for d in range(n):
+        L.append(f"Hardware\tSamsung SSD 980 PRO 2TB\tStorage")
+        L+= [f"Temperature\tTemperature\t{r.randint(30,70)}",f"Temperature 1\tTemperature\t{r.randint(30,70)}",f"Available Spare\tLevel\t100",f"Percentage Used\tLevel\t{r.randint(0,10)}",f"Used Space\tLoad\t{r.uniform(0,100):.2f}",f"Read Activity\tLoad\t{r.uniform(0,100):.2f}",f"Write Activity\tLoad\t{r.uniform(0,100):.2f}",f"Total Activity\tLoad\t{r.uniform(0,100):.2f}",f"Data Read\tData\t{r.randint(1000,90000)}",f"Data Written\tData\t{r.randint(1000,90000)}",f"Read Rate\tThroughput\t{r.uniform(0,1e9):.0f}",f"Write Rate\tThroughput\t{r.uniform(0,1e9):.0f}"]
+    return L
+def net(n,tick):
+    r=random.Random(tick+50)
+    L=[]
+    for i in range(n):
+        L.append(f"Hardware\tEthernet {i}\tNetwork")
+        L+= [f"Data Uploaded\tData\t{r.uniform(0,100):.3f}",f"Data Downloaded\tData\t{r.uniform(0,100):.3f}",f"Upload Speed\tThroughput\t{r.uniform(0,1e7):.0f}",f"Download Speed\tThroughput\t{r.uniform(0,1e7):.0f}",f"Network Utilization\tLoad\t{r.uniform(0,100):.2f}"]
+    return L
+systems={
+ 'intel_hybrid': lambda t: cpu("12th Gen Intel Core i9-12900K","Cpu",8,8,tick=t)+board(t)+mem(t)+intelgpu(t)+nvidia("NVIDIA GeForce RTX 3080",0,t)+storage(2,t)+net(4,t),
+ 'ryzen': lambda t: board(t)+cpu("AMD Ryzen 9 7950X","Cpu",16,0,amd=True,tick=t)+mem(t)+amdgpu(t)+storage(3,t)+net(3,t),
+ 'multi_gpu': lambda t: cpu("Intel Core i7-9700K","Cpu",8,0,tick=t)+board(t)+mem(t)+nvidia("NVIDIA GeForce RTX 4090",0,t)+nvidia("NVIDIA GeForce RTX 4090",1,t)+nvidia("NVIDIA RTX A6000",2,t)+storage(4,t)+net(2,t),
+}
+for k,f in systems.items():
+    for t in range(3):
+        open(f"{k}.{t}.txt","w").write("\n".join(f(t))+"\n")
@@ -0,0 +1,68 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <btop_lhm.hpp>
+
+#include "testing.hpp"
+#include "lhm_reference.hpp"
+
+using std::string;
+
+//* Time per update of the reference parser, compile() and extract() together and extract() with a kept mapping.
+//* The fixtures are generated by fixtures/lhm/generate.py and model each kind of system, they are not captured LHM output.
+//* Usage: lhm_bench [iterations]
+int main(int argc, char** argv) {
+	const int iterations = (argc > 1 ? std::max(1, std::atoi(argv[1])) : 20000);
+	const auto micros = [&](const auto start, const auto end) {
+		return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+	};
+
+	for (const string system : {"intel_hybrid", "ryzen", "multi_gpu"}) {
+		const string output = Testing::fixture("lhm/" + system + ".0.txt");
+		const auto mapping = Lhm::compile(output);
+
+		const auto t0 = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++) {
+			Cpu::OHMRraw stats;
+			Reference::parse(output, stats);
+		}
+		const auto t1 = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++) {
+			Cpu::OHMRraw stats;
+			Lhm::Errors errors;
+			Lhm::extract(output, Lhm::compile(output), stats, errors);
+		}
+		const auto t2 = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++) {
+			Cpu::OHMRraw stats;
+			Lhm::Errors errors;
+			Lhm::extract(output, mapping, stats, errors);
+		}
+		const auto t3 = std::chrono::steady_clock::now();
+
+		std::printf("%-13s %4zu lines  reference %7.2f us  compile+extract %7.2f us  extract %7.2f us\n",
+			system.c_str(), mapping.lines, micros(t0, t1), micros(t1, t2), micros(t2, t3));
+	}
+	return Testing::result("lhm_bench");
+}
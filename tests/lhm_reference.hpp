@@ -0,0 +1,137 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include <btop_lhm.hpp>
+
+//* Parser used by Cpu::OHMR_collect() before the Lhm module, splits every line and matches sensor names on each update.
+//* Kept as the reference for the values and timings of Lhm::compile() and Lhm::extract()
+namespace Reference {
+	using std::string, std::vector;
+
+	inline vector<string> ssplit(const string& str, const char delim) {
+		vector<string> out;
+		size_t last = 0;
+		for (size_t loc = str.find(delim); loc != string::npos; loc = str.find(delim, last)) {
+			out.push_back(str.substr(last, loc - last));
+			last = loc + 1;
+		}
+		if (last < str.size()) out.push_back(str.substr(last));
+		return out;
+	}
+
+	//* Returns false if a value failed to parse
+	inline bool parse(const string& output, Cpu::OHMRraw& stats) {
+		bool isGPU = false;
+		bool hasPackage = false;
+		bool hasGPUload = false;
+		int mb_cpu = 0;
+		int mb_system = 0;
+		auto& gpus = stats.GPUS;
+		auto& cpu_temps = stats.CPU;
+		auto& cpu_clock = stats.CpuClock;
+		string gpu_name;
+
+		for (const auto& line : ssplit(output, '\n')) {
+			auto linevec = ssplit(line.ends_with('\r') ? line.substr(0, line.size() - 1) : line, '\t');
+			if (linevec.size() < 3) continue;
+			try {
+				if (linevec.front() == "Hardware") {
+					isGPU = linevec.at(2).contains("Gpu");
+					if (isGPU) {
+						gpu_name = (linevec.at(1).empty() ? linevec.at(2) : linevec.at(1));
+						hasGPUload = false;
+						stats.GPUorder.push_back(gpu_name);
+					}
+				}
+				else if (isGPU) {
+					if (linevec.front().starts_with("GPU Core")) {
+						if (linevec.at(1) == "Clock")
+							gpus[gpu_name].clock_mhz = linevec.at(2) + " Mhz";
+						else if (linevec.at(1) == "Temperature")
+							gpus[gpu_name].temp = std::stoi(linevec.at(2));
+						else if (linevec.at(1) == "Load") {
+							gpus[gpu_name].usage = std::stoi(linevec.at(2));
+							hasGPUload = true;
+							gpus[gpu_name].cpu_gpu = false;
+						}
+					}
+					else if (not hasGPUload and linevec.front().starts_with("D3D 3D") and linevec.at(1) == "Load") {
+						gpus[gpu_name].usage = std::stoi(linevec.at(2));
+						gpus[gpu_name].cpu_gpu = true;
+					}
+					else if (linevec.front().starts_with("GPU Memory Used") or linevec.front() == "D3D Shared Memory Used")
+						gpus[gpu_name].mem_used = std::stoll(linevec.at(2)) << 20ll;
+					else if (linevec.front().starts_with("GPU Memory Total"))
+						gpus[gpu_name].mem_total = std::stoll(linevec.at(2)) << 20ll;
+				}
+				else {
+					if ((linevec.front().starts_with("CPU Core") or linevec.front().starts_with("Core #")) and linevec.at(1) == "Clock") {
+						const int clock = std::stoi(linevec.at(2));
+						if (clock > cpu_clock) cpu_clock = clock;
+					}
+					else if (linevec.at(1) == "Temperature") {
+						if (linevec.front().starts_with("CPU Core #") and not linevec.front().contains("TjMax"))
+							cpu_temps.push_back(std::stoi(linevec.at(2)));
+						else if (not hasPackage and (linevec.front().starts_with("CPU Package") or linevec.front() == "Core (Tctl/Tdie)")) {
+							cpu_temps.insert(cpu_temps.begin(), std::stoi(linevec.at(2)));
+							hasPackage = true;
+						}
+						else if (not hasPackage and linevec.front() == "CPU")
+							mb_cpu = std::stoi(linevec.at(2));
+						else if (not hasPackage and linevec.front() == "System")
+							mb_system = std::stoi(linevec.at(2));
+					}
+				}
+			}
+			catch (const std::exception&) {
+				return false;
+			}
+		}
+
+		if (not hasPackage) {
+			if (mb_cpu > 0)
+				cpu_temps.insert(cpu_temps.begin(), mb_cpu);
+			else if (not cpu_temps.empty())
+				cpu_temps.insert(cpu_temps.begin(), std::accumulate(cpu_temps.begin(), cpu_temps.end(), 0) / (int)cpu_temps.size());
+			else if (mb_system > 0)
+				cpu_temps.insert(cpu_temps.begin(), mb_system);
+		}
+		return true;
+	}
+
+	//* True if all values in <a> and <b> are the same
+	inline bool same(const Cpu::OHMRraw& a, const Cpu::OHMRraw& b) {
+		if (a.CpuClock != b.CpuClock or a.CPU != b.CPU or a.GPUorder != b.GPUorder or a.GPUS.size() != b.GPUS.size()) return false;
+		return std::ranges::all_of(a.GPUS, [&](const auto& entry) {
+			const auto& [name, ga] = entry;
+			const auto it = b.GPUS.find(name);
+			if (it == b.GPUS.end()) return false;
+			const auto& gb = it->second;
+			return ga.usage == gb.usage and ga.mem_total == gb.mem_total and ga.mem_used == gb.mem_used
+				and ga.temp == gb.temp and ga.cpu_gpu == gb.cpu_gpu and ga.clock_mhz == gb.clock_mhz;
+		});
+	}
+}
@@ -0,0 +1,214 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include <btop_lhm.hpp>
+
+#include "testing.hpp"
+#include "lhm_reference.hpp"
+
+using std::string, std::vector;
+namespace fs = std::filesystem;
+
+namespace {
+	const vector<string> systems = {"intel_hybrid", "ryzen", "multi_gpu"};
+	constexpr int ticks = 3;
+
+	void test_tokenizer() {
+		Lhm::Tokenizer lines("Hardware\tCPU\tCpu\r\nno fields\n\nName\tType\t\nA\tB\t12\textra\nlast\tline\t5");
+		Lhm::Line line;
+		CHECK(lines.next(line));
+		CHECK(line.name == "Hardware" and line.type == "CPU" and line.value == "Cpu");
+		CHECK(lines.line_number() == 1);
+
+		//? Lines with less than 3 fields or an empty value are skipped, fields after the value are ignored
+		CHECK(lines.next(line));
+		CHECK(line.name == "A" and line.type == "B" and line.value == "12");
+		CHECK(lines.line_number() == 5);
+
+		//? Last line without a newline
+		CHECK(lines.next(line));
+		CHECK(line.value == "5" and lines.line_number() == 6);
+		CHECK(not lines.next(line));
+	}
+
+	void test_to_number() {
+		int i = 0;
+		CHECK(Lhm::to_number(" +42", i) and i == 42);
+		CHECK(Lhm::to_number("68.63", i) and i == 68);
+		CHECK(Lhm::to_number("-5", i) and i == -5);
+		CHECK(not Lhm::to_number("xx", i));
+		CHECK(not Lhm::to_number("", i));
+		CHECK(not Lhm::to_number("99999999999", i));
+		long long ll = 0;
+		CHECK(Lhm::to_number("99999999999", ll) and ll == 99999999999);
+	}
+
+	void test_errors() {
+		const string output = Testing::fixture("lhm/intel_hybrid.0.txt");
+		const auto mapping = Lhm::compile(output);
+		string bad = output;
+		const size_t pos = bad.find("CPU Package\tTemperature\t") + 24;
+		bad.replace(pos, bad.find('\n', pos) - pos, "xx");
+
+		//? A malformed value is skipped and reported, the rest of the output is still used
+		Cpu::OHMRraw stats;
+		Lhm::Errors errors;
+		const bool ok = Lhm::extract(bad, mapping, stats, errors);
+		CHECK(ok);
+		CHECK(errors.count == 1);
+		CHECK(errors.reason == "invalid value \"xx\" for Temperature sensor \"CPU Package\"");
+		CHECK(stats.CpuClock == 4988);
+	}
+
+	//? Values from the layout of tick 0 applied to every tick must be the same as parsing each output from scratch
+	void test_fixtures() {
+		for (const auto& system : systems) {
+			const auto mapping = Lhm::compile(Testing::fixture("lhm/" + system + ".0.txt"));
+			CHECK(mapping.lines > 0);
+			for (int tick = 0; tick < ticks; tick++) {
+				const string output = Testing::fixture("lhm/" + system + '.' + std::to_string(tick) + ".txt");
+				Cpu::OHMRraw expected, stats;
+				Lhm::Errors errors;
+				CHECK(Reference::parse(output, expected));
+				const bool ok = Lhm::extract(output, mapping, stats, errors);
+				if (not CHECK(ok and errors.count == 0 and Reference::same(expected, stats)))
+					std::printf("  %s tick %d differs from the reference parser\n", system.c_str(), tick);
+			}
+		}
+	}
+
+	//? Dumps of FetchLHMValues() from real systems in lhm/captured, if any, must extract the same as the reference parser
+	void test_captured() {
+		const fs::path dir = fs::path(FIXTURE_DIR) / "lhm" / "captured";
+		if (not fs::is_directory(dir)) return;
+		for (const auto& entry : fs::directory_iterator(dir)) {
+			if (entry.path().extension() != ".txt") continue;
+			const string name = "lhm/captured/" + entry.path().filename().string();
+			const string output = Testing::fixture(name);
+			const auto mapping = Lhm::compile(output);
+			Cpu::OHMRraw expected, stats;
+			Lhm::Errors errors;
+			CHECK(Reference::parse(output, expected));
+			const bool ok = Lhm::extract(output, mapping, stats, errors);
+			if (not CHECK(mapping.lines > 0 and ok and errors.count == 0 and Reference::same(expected, stats)))
+				std::printf("  %s differs from the reference parser\n", name.c_str());
+		}
+	}
+
+	//? Swap lines <a> and <b> (1-based) of <output>
+	string swap_lines(const string& output, const size_t a, const size_t b) {
+		vector<string> lines = Reference::ssplit(output, '\n');
+		std::swap(lines.at(a - 1), lines.at(b - 1));
+		string out;
+		for (const auto& line : lines) out += line + '\n';
+		return out;
+	}
+
+	//? Find the line number of the first line starting with <prefix>
+	size_t line_of(const string& output, const string& prefix) {
+		const vector<string> lines = Reference::ssplit(output, '\n');
+		for (size_t i = 0; i < lines.size(); i++) if (lines[i].starts_with(prefix)) return i + 1;
+		return 0;
+	}
+
+	//? Any change of the layout must be caught by extract() so the caller compiles a new mapping, values are never assigned to the wrong slots
+	void test_layout_changes() {
+		const string output = Testing::fixture("lhm/intel_hybrid.0.txt");
+		const auto mapping = Lhm::compile(output);
+		auto rejects = [&](const string& changed) {
+			Cpu::OHMRraw stats;
+			Lhm::Errors errors;
+			return not Lhm::extract(changed, mapping, stats, errors);
+		};
+
+		CHECK(rejects(Testing::fixture("lhm/multi_gpu.0.txt")));
+
+		string renamed = output;
+		renamed.replace(renamed.find("NVIDIA GeForce RTX 3080"), 23, "NVIDIA GeForce RTX 3090");
+		CHECK(rejects(renamed));
+
+		string removed = output;
+		const size_t igpu = removed.find("Hardware\tIntel(R) UHD");
+		removed.erase(igpu, removed.find("Hardware\tNVIDIA") - igpu);
+		CHECK(rejects(removed));
+
+		CHECK(rejects(output + "Extra\tLoad\t1\n"));
+		CHECK(rejects(output.substr(0, output.rfind('\n', output.size() - 2) + 1)));
+
+		//? Sensors moved within a section keep the line count and headers
+		const size_t package = line_of(output, "CPU Package\tTemperature"), core_max = line_of(output, "Core Max\tTemperature");
+		CHECK(package > 0 and core_max > 0);
+		CHECK(rejects(swap_lines(output, package, core_max)));
+
+		const size_t clock = line_of(output, "CPU Core #1\tClock"), temp = line_of(output, "CPU Core #1\tTemperature");
+		CHECK(rejects(swap_lines(output, clock, temp)));
+
+		const size_t gpu_temp = line_of(output, "GPU Core\tTemperature"), gpu_load = line_of(output, "GPU Core\tLoad");
+		const string swapped = swap_lines(output, gpu_temp, gpu_load);
+		CHECK(rejects(swapped));
+
+		//? A new mapping for the changed layout gives the same values as the reference parser
+		Cpu::OHMRraw expected, stats;
+		Lhm::Errors errors;
+		CHECK(Reference::parse(swapped, expected));
+		const bool ok = Lhm::extract(swapped, Lhm::compile(swapped), stats, errors);
+		CHECK(ok and Reference::same(expected, stats));
+
+		//? Lines that aren't mapped can move without a new mapping
+		const size_t fan = line_of(output, "Fan #1\tFan");
+		CHECK(fan > 0 and not rejects(swap_lines(output, fan, fan + 1)));
+
+		CHECK(Lhm::compile("no\nsensors\n").lines == 0);
+	}
+
+	//? Known values of intel_hybrid.0.txt
+	void test_intel_hybrid() {
+		const string output = Testing::fixture("lhm/intel_hybrid.0.txt");
+		Cpu::OHMRraw stats;
+		Lhm::Errors errors;
+		CHECK(Lhm::extract(output, Lhm::compile(output), stats, errors));
+		CHECK(stats.CpuClock == 4988);
+		CHECK(stats.CPU.size() == 17 and stats.CPU.front() == 96);
+		CHECK((stats.GPUorder == vector<string>{"Intel(R) UHD Graphics 770", "NVIDIA GeForce RTX 3080"}));
+
+		const auto& igpu = stats.GPUS["Intel(R) UHD Graphics 770"];
+		CHECK(igpu.usage == 68 and igpu.cpu_gpu);
+		CHECK(igpu.mem_used == 204ull << 20);
+
+		const auto& nvidia = stats.GPUS["NVIDIA GeForce RTX 3080"];
+		CHECK(nvidia.usage == 73 and not nvidia.cpu_gpu);
+		CHECK(nvidia.temp == 57 and nvidia.clock_mhz == "2540 Mhz");
+		CHECK(nvidia.mem_total == 24564ull << 20);
+	}
+}
+
+int main() {
+	test_tokenizer();
+	test_to_number();
+	test_errors();
+	test_fixtures();
+	test_captured();
+	test_intel_hybrid();
+	test_layout_changes();
+	return Testing::result("lhm_test");
+}
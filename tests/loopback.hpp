@@ -0,0 +1,110 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+
+#ifdef _WIN32
+	#define NOMINMAX
+	#define WIN32_LEAN_AND_MEAN
+	#include <winsock2.h>
+	#include <WS2tcpip.h>
+	#pragma comment(lib, "Ws2_32.lib")
+#else
+	#include <arpa/inet.h>
+	#include <netinet/in.h>
+	#include <sys/socket.h>
+	#include <unistd.h>
+	using SOCKET = int;
+	constexpr SOCKET INVALID_SOCKET = -1;
+	inline int closesocket(const SOCKET sock) { return close(sock); }
+#endif
+
+//* Blocking TCP sockets on 127.0.0.1 for tests and benchmarks, Winsock on Windows and BSD sockets elsewhere
+namespace Loopback {
+
+	//* Initialize the socket library, returns false on failure
+	inline bool startup() {
+	#ifdef _WIN32
+		WSADATA wsa_data;
+		return WSAStartup(MAKEWORD(2, 2), &wsa_data) == 0;
+	#else
+		return true;
+	#endif
+	}
+
+	inline sockaddr_in address(const int port) {
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons((unsigned short)port);
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		return addr;
+	}
+
+	//* Connect to 127.0.0.1:<port>, INVALID_SOCKET on failure
+	inline SOCKET connect_to(const int port) {
+		const SOCKET sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (sock == INVALID_SOCKET) return sock;
+		const auto addr = address(port);
+		if (connect(sock, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+			closesocket(sock);
+			return INVALID_SOCKET;
+		}
+		return sock;
+	}
+
+	//* Listen on a free port on 127.0.0.1 and set <port> to it, INVALID_SOCKET on failure
+	inline SOCKET listen_any(int& port) {
+		const SOCKET sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (sock == INVALID_SOCKET) return sock;
+		auto addr = address(0);
+		socklen_t len = sizeof(addr);
+		if (bind(sock, (const sockaddr*)&addr, sizeof(addr)) != 0 or listen(sock, SOMAXCONN) != 0
+		or getsockname(sock, (sockaddr*)&addr, &len) != 0) {
+			closesocket(sock);
+			return INVALID_SOCKET;
+		}
+		port = ntohs(addr.sin_port);
+		return sock;
+	}
+
+	inline bool send_all(const SOCKET sock, const char* buf, size_t len) {
+		while (len > 0) {
+			const int n = send(sock, buf, (int)std::min(len, (size_t)INT_MAX), 0);
+			if (n <= 0) return false;
+			buf += n;
+			len -= n;
+		}
+		return true;
+	}
+
+	//* Read exactly <len> bytes, returns false on error or closed connection
+	inline bool recv_all(const SOCKET sock, char* buf, size_t len) {
+		while (len > 0) {
+			const int n = recv(sock, buf, (int)std::min(len, (size_t)INT_MAX), 0);
+			if (n <= 0) return false;
+			buf += n;
+			len -= n;
+		}
+		return true;
+	}
+}
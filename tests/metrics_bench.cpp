@@ -0,0 +1,118 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <latch>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "testing.hpp"
+#include "loopback.hpp"
+
+using std::string, std::vector;
+
+namespace {
+	const string request = "GET /metrics HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+
+	struct Scrape {
+		double millis = 0;
+		size_t bytes = 0;
+		bool ok = false;
+	};
+
+	//* One scrape on a new connection, timed from connect() until the server closes the connection
+	Scrape scrape(const int port) {
+		Scrape result;
+		const auto start = std::chrono::steady_clock::now();
+		const SOCKET sock = Loopback::connect_to(port);
+		string response;
+		if (sock != INVALID_SOCKET and Loopback::send_all(sock, request.data(), request.size())) {
+			char buf[16384];
+			int n;
+			while ((n = recv(sock, buf, sizeof(buf), 0)) > 0) response.append(buf, n);
+			result.ok = (n == 0 and response.starts_with("HTTP/1.1 200") and response.find("\r\n\r\n") != string::npos);
+		}
+		if (sock != INVALID_SOCKET) closesocket(sock);
+		result.millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		result.bytes = response.size();
+		return result;
+	}
+
+	double percentile(const vector<double>& sorted, const double p) {
+		return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+	}
+}
+
+//* Scrape latency of the metrics endpoint with concurrent local scrapers, each doing its scrapes back to back.
+//* Export::Metrics::serve() uses Winsock, so this measures a btop4win running on Windows with metrics_port set to <port>.
+//* Usage: metrics_bench <port> [scrapers] [scrapes per scraper]
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::printf("Usage: metrics_bench <port> [scrapers] [scrapes per scraper]\n");
+		return 2;
+	}
+	const int port = std::atoi(argv[1]);
+	const int scrapers = (argc > 2 ? std::max(1, std::atoi(argv[2])) : 100);
+	const int scrapes = (argc > 3 ? std::max(1, std::atoi(argv[3])) : 20);
+
+	if (not CHECK(Loopback::startup())) return Testing::result("metrics_bench");
+
+	//? All scrapers are started before the first connect so the listener sees them concurrently
+	vector<vector<Scrape>> results(scrapers);
+	std::latch ready(scrapers + 1);
+	vector<std::thread> threads;
+	for (int i = 0; i < scrapers; i++) {
+		threads.emplace_back([&, i] {
+			results[i].reserve(scrapes);
+			ready.arrive_and_wait();
+			for (int s = 0; s < scrapes; s++) results[i].push_back(scrape(port));
+		});
+	}
+	ready.arrive_and_wait();
+	const auto start = std::chrono::steady_clock::now();
+	for (auto& thread : threads) thread.join();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	vector<double> latencies;
+	size_t failed = 0, bytes = 0;
+	for (const auto& list : results) {
+		for (const auto& result : list) {
+			if (not result.ok) failed++;
+			else {
+				latencies.push_back(result.millis);
+				bytes += result.bytes;
+			}
+		}
+	}
+	CHECK(failed == 0);
+
+	if (not latencies.empty()) {
+		std::ranges::sort(latencies);
+		std::printf("%d scrapers x %d scrapes  p50 %7.2f ms  p99 %7.2f ms  max %7.2f ms  %8.0f scrapes/s  %zu bytes per response\n",
+			scrapers, scrapes, percentile(latencies, 0.50), percentile(latencies, 0.99), latencies.back(),
+			latencies.size() / seconds, bytes / latencies.size());
+	}
+	if (failed > 0) std::printf("%zu of %zu scrapes failed\n", failed, failed + latencies.size());
+
+	return Testing::result("metrics_bench");
+}
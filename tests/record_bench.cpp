@@ -0,0 +1,133 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <btop_series.hpp>
+
+#include "testing.hpp"
+
+using std::string, std::to_string, std::vector;
+
+namespace {
+	constexpr size_t cores = 128;
+
+	//? Samples per block as written by Record::Disk
+	constexpr uint32_t block_samples = 60;
+
+	//* Usage percent of each core as a random walk of whole percents, mostly idle cores with a few busy ones,
+	//* and timestamps one second apart with a few ms of scheduling jitter
+	class Host {
+		uint64_t state = 0x9E3779B97F4A7C15ull;
+		vector<double> pct = vector<double>(cores, 0);
+	public:
+		uint64_t time = 1'700'000'000'000;
+
+		uint64_t next() {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			return state;
+		}
+
+		const vector<double>& sample() {
+			time += 1000 + (next() % 8 == 0 ? next() % 5 : 0);
+			for (size_t i = 0; i < cores; i++) {
+				const int step = (i % 16 == 0 ? 20 : 3);
+				pct[i] = std::clamp(pct[i] + (double)((int)(next() % (step * 2 + 1)) - step), 0.0, 100.0);
+			}
+			return pct;
+		}
+	};
+}
+
+//* Size and encode/decode time of <samples> samples of <cores> cpu core series in blocks as written by Record::Disk,
+//* a day at one sample per second by default.
+//* Usage: record_bench [samples]
+int main(int argc, char** argv) {
+	const size_t samples = (argc > 1 ? (size_t)std::max(1, std::atoi(argv[1])) : 86'400);
+	const auto seconds = [](const auto start, const auto end) {
+		return std::chrono::duration<double>(end - start).count();
+	};
+
+	//? Values are generated up front so only the encoding is timed
+	Host host;
+	vector<uint64_t> times(samples);
+	vector<double> values(samples * cores);
+	for (size_t s = 0; s < samples; s++) {
+		const auto& pct = host.sample();
+		times[s] = host.time;
+		std::copy(pct.begin(), pct.end(), values.begin() + s * cores);
+	}
+
+	vector<string> names;
+	for (size_t i = 0; i < cores; i++) names.push_back("cpu.core." + to_string(i));
+
+	const auto t0 = std::chrono::steady_clock::now();
+	vector<char> buf;
+	size_t blocks = 0;
+	for (size_t s = 0; s < samples; s += block_samples) {
+		Series::Block block;
+		block.names = names;
+		block.values.resize(cores);
+		block.start = times[s];
+		for (size_t n = s; n < std::min(samples, s + block_samples); n++) {
+			block.times.add(times[n]);
+			for (size_t i = 0; i < cores; i++) block.values[i].add(values[n * cores + i]);
+			block.end = times[n];
+			block.samples++;
+		}
+		block.write(buf);
+		blocks++;
+	}
+	const auto t1 = std::chrono::steady_clock::now();
+
+	size_t decoded_samples = 0;
+	Series::BlockRef ref;
+	for (size_t offset = 0; Series::index(buf.data() + offset, buf.size() - offset, ref); offset += ref.size) {
+		Series::Decoded decoded;
+		if (not CHECK(Series::decode(ref, decoded) and decoded.values.size() == cores)) break;
+		for (size_t n = 0; n < decoded.times.size(); n++) {
+			const size_t s = decoded_samples + n;
+			if (not CHECK(decoded.times[n] == times[s])) break;
+			for (size_t i = 0; i < cores; i++) {
+				if (not CHECK(decoded.values[i][n] == values[s * cores + i])) break;
+			}
+		}
+		decoded_samples += decoded.times.size();
+	}
+	const auto t2 = std::chrono::steady_clock::now();
+	CHECK(decoded_samples == samples);
+
+	//? Uncompressed size is a 64-bit timestamp and a double per core each sample
+	const double raw = (double)samples * (cores + 1) * 8;
+	const double names_bytes = (double)blocks * (names.size() * (2 + names.back().size()));
+	std::printf("%zu cores x %zu samples in %zu blocks of %u\n", cores, samples, blocks, block_samples);
+	std::printf("%-10s %12zu bytes  %6.2f bits/value  %6.1fx smaller than raw  %.1f%% series names\n",
+		"size", buf.size(), (double)buf.size() * 8 / ((double)samples * cores), raw / buf.size(), names_bytes * 100 / buf.size());
+	std::printf("%-10s %12.1f ms  %8.1f ns/value\n", "encode", seconds(t0, t1) * 1000, seconds(t0, t1) * 1e9 / ((double)samples * cores));
+	std::printf("%-10s %12.1f ms  %8.1f ns/value\n", "decode", seconds(t1, t2) * 1000, seconds(t1, t2) * 1e9 / ((double)samples * cores));
+	return Testing::result("record_bench");
+}
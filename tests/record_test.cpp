@@ -0,0 +1,236 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <btop_series.hpp>
+
+#include "testing.hpp"
+
+using std::string, std::vector;
+
+namespace {
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+
+	Series::BitReader reader(const Series::BitWriter& bits) {
+		return {bits.bytes.data(), bits.bytes.size()};
+	}
+
+	//* Encode and decode <times>, returns the encoded size in bytes or 0 if the round trip differs
+	size_t round_trip(const vector<uint64_t>& times) {
+		Series::TimeEncoder encoder;
+		for (const auto t : times) encoder.add(t);
+		Series::TimeDecoder decoder{reader(encoder.bits)};
+		for (const auto t : times) {
+			if (not CHECK(decoder.next() == t)) return 0;
+		}
+		return encoder.bits.bytes.size();
+	}
+
+	//* Values are compared bit for bit, NaN and -0.0 have to come back unchanged
+	size_t round_trip(const vector<double>& values) {
+		Series::ValueEncoder encoder;
+		for (const auto v : values) encoder.add(v);
+		Series::ValueDecoder decoder{reader(encoder.bits)};
+		for (const auto v : values) {
+			if (not CHECK(std::bit_cast<uint64_t>(decoder.next()) == std::bit_cast<uint64_t>(v))) return 0;
+		}
+		return encoder.bits.bytes.size();
+	}
+
+	//* Bits used per timestamp with a delta-of-delta of <dod>
+	size_t dod_bits(const int64_t dod) {
+		if (dod == 0) return 1;
+		if (dod >= -63 and dod <= 64) return 9;
+		if (dod >= -255 and dod <= 256) return 12;
+		if (dod >= -2047 and dod <= 2048) return 16;
+		return 68;
+	}
+
+	void test_time_buckets() {
+		//? A first timestamp and 8 more with the same delta-of-delta take 8 bytes plus one byte per bit of the bucket
+		for (const int64_t dod : {0ll, 1ll, -1ll, -63ll, 64ll, -64ll, 65ll, -255ll, 256ll, -256ll, 257ll, -2047ll, 2048ll, -2048ll, 2049ll,
+								  1ll << 40, -(1ll << 40), 1ll << 56, -(1ll << 56)}) {
+			vector<uint64_t> times = {1ull << 62};
+			int64_t delta = 0;
+			for (int i = 0; i < 8; i++) {
+				delta += dod;
+				times.push_back(times.back() + (uint64_t)delta);
+			}
+			const size_t bytes = round_trip(times);
+			if (not CHECK(bytes == 8 + dod_bits(dod))) std::printf("  dod %lld: %zu bytes\n", (long long)dod, bytes);
+		}
+
+		//? Samples at update_ms with scheduling jitter and a gap where the collector was stalled
+		vector<uint64_t> times;
+		uint64_t t = 1'700'000'000'000;
+		for (int i = 0; i < 1000; i++) {
+			t += 1500 + (i % 7 == 0 ? (i % 3) * 4 : 0) - (i % 11 == 0 ? 3 : 0) + (i == 500 ? 60'000 : 0);
+			times.push_back(t);
+		}
+		CHECK(round_trip(times) > 0);
+
+		//? Timestamps going backwards and a single timestamp
+		CHECK(round_trip(vector<uint64_t>{5000, 4000, 4500, 0, std::numeric_limits<uint64_t>::max(), 0}) > 0);
+		CHECK(round_trip(vector<uint64_t>{42}) == 8);
+	}
+
+	void test_values() {
+		//? Repeated values cost one bit each after the first
+		CHECK(round_trip(vector<double>(65, 12.0)) == 16);
+
+		//? Graph gaps are stored as NaN between regular values
+		CHECK(round_trip(vector<double>{nan, 1.0, nan, nan, 100.0, nan, 0.0, nan}) > 0);
+		CHECK(round_trip(vector<double>{-0.0, 0.0, -0.0, std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+							std::numeric_limits<double>::denorm_min(), std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()}) > 0);
+
+		//? XOR with no leading or trailing zeros, the 64 bit window is stored as a length of 0
+		const double full = std::bit_cast<double>(0x8000'0000'0000'0001ull);
+		CHECK(round_trip(vector<double>{0.0, full}) == 18);
+		CHECK(round_trip(vector<double>{0.0, full, 0.0, full, 1.0, full}) > 0);
+
+		//? More than 31 leading zeros are capped to fit the 5 bit field
+		const double low = std::bit_cast<double>(1ull);
+		CHECK(round_trip(vector<double>{0.0, low, 0.0, low}) > 0);
+
+		//? A following XOR that fits inside the window reuses it, one that doesn't starts a new window
+		CHECK(round_trip(vector<double>{1.0, 1.5, 1.25, 1.75, 3.0, 1e300, -1e-300, 7.0}) > 0);
+
+		//? Random walk of integer percentages as stored for cpu cores, and uniformly random bit patterns
+		vector<double> walk, random;
+		uint64_t state = 0x9E3779B97F4A7C15ull;
+		const auto next = [&] {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			return state;
+		};
+		double pct = 50;
+		for (int i = 0; i < 10'000; i++) {
+			pct = std::clamp(pct + (double)((int)(next() % 21) - 10), 0.0, 100.0);
+			walk.push_back((next() % 50 == 0 ? nan : pct));
+			random.push_back(std::bit_cast<double>(next()));
+		}
+		CHECK(round_trip(walk) > 0);
+		CHECK(round_trip(random) > 0);
+	}
+
+	Series::Block make_block(const uint64_t start, const uint32_t samples) {
+		Series::Block block;
+		block.names = {"cpu.total", "cpu.core.0", "net.Ethernet.download.speed", ""};
+		block.strings = {{"cpu.name", "Test CPU"}, {"proc.0.name", "btop4win.exe"}, {"empty", ""}};
+		block.values.resize(block.names.size());
+		block.start = start;
+		for (uint32_t i = 0; i < samples; i++) {
+			block.end = start + i * 1000;
+			block.times.add(block.end);
+			block.values[0].add(i % 100);
+			block.values[1].add(i % 3 == 0 ? nan : 25.0);
+			block.values[2].add((double)(i * 4096));
+			block.values[3].add(-(double)i / 3);
+			block.samples++;
+		}
+		return block;
+	}
+
+	bool same(const Series::Decoded& decoded, const Series::Block& block) {
+		bool ok = CHECK(decoded.names == block.names);
+		ok &= CHECK(decoded.strings.size() == block.strings.size());
+		for (const auto& [key, value] : block.strings) {
+			const auto found = decoded.strings.find(key);
+			ok &= CHECK(found != decoded.strings.end() and found->second == value);
+		}
+		ok &= CHECK(decoded.times.size() == block.samples and decoded.times.front() == block.start and decoded.times.back() == block.end);
+		if (not CHECK(decoded.values.size() == block.names.size())) return false;
+		for (const auto& values : decoded.values) ok &= CHECK(values.size() == block.samples);
+		for (uint32_t i = 0; i < block.samples and ok; i++) {
+			ok &= CHECK(decoded.times[i] == block.start + i * 1000);
+			ok &= CHECK(decoded.values[0][i] == i % 100 and decoded.values[2][i] == (double)(i * 4096) and decoded.values[3][i] == -(double)i / 3);
+			ok &= CHECK(i % 3 == 0 ? std::isnan(decoded.values[1][i]) : decoded.values[1][i] == 25.0);
+		}
+		return ok;
+	}
+
+	void test_blocks() {
+		//? Consecutive blocks as written to a segment
+		const auto first = make_block(1'000'000, 60), second = make_block(1'060'000, 17);
+		vector<char> buf;
+		first.write(buf);
+		const size_t first_size = buf.size();
+		second.write(buf);
+
+		vector<Series::BlockRef> refs;
+		Series::BlockRef ref;
+		for (size_t offset = 0; Series::index(buf.data() + offset, buf.size() - offset, ref); offset += ref.size) refs.push_back(ref);
+		if (not CHECK(refs.size() == 2)) return;
+		CHECK(refs[0].size == first_size and refs[0].samples == 60 and refs[0].start == 1'000'000 and refs[0].end == 1'059'000);
+		CHECK(refs[1].size == buf.size() - first_size and refs[1].samples == 17 and refs[1].start == 1'060'000);
+		for (size_t i = 0; i < refs.size(); i++) {
+			Series::Decoded decoded;
+			CHECK(Series::decode(refs[i], decoded));
+			CHECK(same(decoded, (i == 0 ? first : second)));
+		}
+
+		//? A block truncated at any length is not indexed, as at the end of a segment still being written
+		size_t indexed = 0;
+		for (size_t len = 0; len < first_size; len++) indexed += Series::index(buf.data(), len, ref);
+		CHECK(indexed == 0);
+
+		//? A block with a size in its header past the data it holds is rejected when decoded
+		size_t decoded_ok = 0;
+		for (uint32_t len = Series::head_size; len < first_size; len++) {
+			Series::BlockRef cut = refs[0];
+			cut.size = len;
+			Series::Decoded decoded;
+			decoded_ok += Series::decode(cut, decoded);
+			if (not CHECK(decoded.names.empty() and decoded.values.empty())) break;
+		}
+		CHECK(decoded_ok == 0);
+
+		//? Bad magic and sizes smaller than the header
+		vector<char> bad = buf;
+		bad[0] ^= 0x01;
+		CHECK(not Series::index(bad.data(), bad.size(), ref));
+		bad = buf;
+		bad[4] = (char)(Series::head_size - 1);
+		bad[5] = bad[6] = bad[7] = 0;
+		CHECK(not Series::index(bad.data(), bad.size(), ref));
+
+		//? Empty block
+		Series::Block empty;
+		vector<char> empty_buf;
+		empty.write(empty_buf);
+		CHECK(empty_buf.size() == Series::head_size + 4);
+		Series::Decoded decoded;
+		CHECK(Series::index(empty_buf.data(), empty_buf.size(), ref) and Series::decode(ref, decoded) and decoded.names.empty() and decoded.times.empty());
+	}
+}
+
+int main() {
+	test_time_buckets();
+	test_values();
+	test_blocks();
+	return Testing::result("record_test");
+}
@@ -0,0 +1,161 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <btop_stream.hpp>
+
+#include "testing.hpp"
+
+using std::string, std::to_string, std::vector;
+
+namespace {
+	constexpr size_t process_count = 10'000;
+
+	//? Default update_ms in the config
+	constexpr double update_ms = 1500;
+
+	//* Process shaped like a browser renderer, values drifting with <tick> at rates seen on a busy desktop:
+	//* memory changes for about a third of processes per update, cpu usage for a tenth and threads for a few
+	Proc::proc_info make_proc(const size_t pid, const size_t tick, const uint64_t start) {
+		Proc::proc_info p;
+		p.pid = pid;
+		p.ppid = pid / 7 + 4;
+		p.name = "process_" + to_string(pid) + ".exe";
+		p.cmd = "\"C:\\Program Files\\Vendor\\Application " + to_string(pid) + "\\process.exe\" --type=renderer --field-trial-handle=1234,i,56789 /prefetch:1";
+		p.user = (pid % 3 == 0 ? "SYSTEM" : "user");
+		p.threads = 8 + (pid % 50 == 0 ? tick % 4 : 0);
+		p.mem = (uint64_t)(pid % 97 + 1) << 20;
+		if (pid % 3 == 0) p.mem += (tick % 16) * 4096;
+		p.cpu_p = (pid % 10 == 0 ? (double)((pid + tick) % 200) / 10 : 0.0);
+		p.cpu_c = (double)(pid % 100) / 100;
+		p.state = 'R';
+		p.cpu_s = start;
+		return p;
+	}
+
+	//* Cpu, memory, disk and network fields of a 16 core host, about a third of them changing every update
+	void add_fields(Stream::Encoder& encoder, const size_t tick) {
+		for (const string field : {"total", "kernel", "user", "dpc", "interrupt", "idle"}) encoder.num("cpu/pct/" + field, (int64_t)((tick * 7) % 100));
+		for (size_t i = 0; i < 16; i++) {
+			encoder.num("cpu/core/" + to_string(i), (int64_t)((tick + i) % 100));
+			encoder.num("cpu/core_max/" + to_string(i), 100);
+			encoder.num("cpu/temp/" + to_string(i), (int64_t)(50 + (tick + i) % 3));
+		}
+		for (const string stat : {"used", "available", "cached", "commit", "page_total", "page_used", "page_free"})
+			encoder.num("mem/stat/" + stat, (int64_t)(1ll << 33) + (stat == "used" ? (int64_t)tick * 4096 : 0));
+		for (const string disk : {"C:", "D:"}) {
+			encoder.text("disk/" + disk + "/name", "Disk " + disk);
+			encoder.num("disk/" + disk + "/total", 1ll << 40);
+			encoder.num("disk/" + disk + "/used", 1ll << 39);
+			encoder.num("disk/" + disk + "/read", (int64_t)(tick % 5) << 20);
+			encoder.num("disk/" + disk + "/write", (int64_t)(tick % 3) << 20);
+		}
+		for (const string dir : {"download", "upload"}) {
+			encoder.num("net/Ethernet/" + dir + "/speed", (int64_t)(tick % 11) << 10);
+			encoder.num("net/Ethernet/" + dir + "/total", (int64_t)tick << 20);
+		}
+	}
+
+	struct Result {
+		size_t frames = 0, bytes = 0;
+		double encode_us = 0, decode_us = 0;
+	};
+
+	void print(const char* label, const Result& r) {
+		const double per_frame = (double)r.bytes / r.frames;
+		std::printf("%-24s %10.0f bytes/frame  %10.0f bytes/s  encode %8.1f us  decode %8.1f us\n",
+			label, per_frame, per_frame * 1000 / update_ms, r.encode_us / r.frames, r.decode_us / r.frames);
+	}
+}
+
+//* Frame size and bytes/s of the agent stream at 10k processes, for keyframes, steady state deltas with 0.1% process churn
+//* per update and the resulting stream with a keyframe every Stream::key_interval frames, at the default update_ms.
+//* Usage: remote_bench [updates]
+int main(int argc, char** argv) {
+	const size_t updates = (argc > 1 ? (size_t)std::max(1, std::atoi(argv[1])) : 100);
+	const auto micros = [](const auto start, const auto end) {
+		return std::chrono::duration<double, std::micro>(end - start).count();
+	};
+
+	//? Start time of each pid slot, a new start time is a process exiting and another one reusing the pid
+	vector<uint64_t> starts(process_count, 1);
+	vector<Proc::proc_info> procs(process_count);
+	Stream::Encoder encoder;
+	Stream::Decoder decoder;
+	Result key, delta;
+	string frame;
+
+	for (size_t tick = 0; tick <= updates; tick++) {
+		for (size_t c = 0; c < process_count / 1000; c++) starts[(tick * 997 + c * 101) % process_count]++;
+		for (size_t i = 0; i < process_count; i++) procs[i] = make_proc(i * 4 + 4, tick, starts[i]);
+
+		//? Every frame after the first is a delta here, keyframes are timed separately below
+		const bool is_key = (tick == 0);
+		const auto t0 = std::chrono::steady_clock::now();
+		encoder.begin(is_key);
+		add_fields(encoder, tick);
+		for (const auto& p : procs) encoder.proc(p);
+		frame.clear();
+		encoder.finish(frame, tick * (uint64_t)update_ms);
+		const auto t1 = std::chrono::steady_clock::now();
+		CHECK(decoder.apply(frame[4], string_view(frame).substr(Stream::head_size)));
+		const auto t2 = std::chrono::steady_clock::now();
+
+		auto& result = (is_key ? key : delta);
+		result.frames++;
+		result.bytes += frame.size();
+		result.encode_us += micros(t0, t1);
+		result.decode_us += micros(t1, t2);
+	}
+	CHECK(decoder.procs.size() == process_count);
+	for (const auto& p : procs) {
+		const auto found = decoder.procs.find(p.pid);
+		if (not CHECK(found != decoder.procs.end() and found->second.cpu_s == p.cpu_s and found->second.mem == p.mem)) break;
+	}
+
+	//? Keyframes of the steady state, as sent periodically and to viewers connecting
+	for (size_t i = 0; i < 10; i++) {
+		Stream::Decoder viewer;
+		const auto t0 = std::chrono::steady_clock::now();
+		encoder.begin(true);
+		add_fields(encoder, updates);
+		for (const auto& p : procs) encoder.proc(p);
+		frame.clear();
+		encoder.finish(frame, updates * (uint64_t)update_ms);
+		const auto t1 = std::chrono::steady_clock::now();
+		CHECK(viewer.apply(frame[4], string_view(frame).substr(Stream::head_size)));
+		const auto t2 = std::chrono::steady_clock::now();
+		key.frames++;
+		key.bytes += frame.size();
+		key.encode_us += micros(t0, t1);
+		key.decode_us += micros(t1, t2);
+	}
+
+	std::printf("%zu processes, update_ms %.0f, %zu delta updates\n", process_count, update_ms, delta.frames);
+	print("keyframe", key);
+	print("delta", delta);
+	const double stream = ((double)key.bytes / key.frames + (double)delta.bytes / delta.frames * (Stream::key_interval - 1)) / Stream::key_interval;
+	std::printf("%-24s %10.0f bytes/frame  %10.0f bytes/s\n", ("stream, key every " + to_string(Stream::key_interval)).c_str(), stream, stream * 1000 / update_ms);
+	return Testing::result("remote_bench");
+}
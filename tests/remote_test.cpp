@@ -0,0 +1,334 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <btop_stream.hpp>
+
+#include "testing.hpp"
+#include "loopback.hpp"
+
+using std::string, std::string_view, std::vector, std::pair;
+
+namespace {
+	Proc::proc_info make_proc(const size_t pid, const string& name, const uint64_t cpu_s) {
+		Proc::proc_info p;
+		p.pid = pid;
+		p.ppid = 4;
+		p.name = name;
+		p.cmd = "C:\\Windows\\System32\\" + name + " --flag";
+		p.user = "SYSTEM";
+		p.threads = 8;
+		p.mem = 1 << 20;
+		p.cpu_p = 1.5;
+		p.cpu_c = 0.25;
+		p.state = 'R';
+		p.cpu_s = cpu_s;
+		return p;
+	}
+
+	//* Frames in <buf> as (type, payload), stops at a truncated frame
+	vector<pair<char, string_view>> frames(const string& buf) {
+		vector<pair<char, string_view>> out;
+		for (size_t pos = 0; pos + Stream::head_size <= buf.size();) {
+			const uint32_t size = Stream::payload_size(buf.data() + pos);
+			if (pos + Stream::head_size + size > buf.size()) break;
+			out.emplace_back(buf[pos + 4], string_view(buf).substr(pos + Stream::head_size, size));
+			pos += Stream::head_size + size;
+		}
+		return out;
+	}
+
+	//* Encode one frame with <values> and <procs> and return it
+	string encode(Stream::Encoder& encoder, const bool key, const vector<pair<string, int64_t>>& values, const vector<Proc::proc_info>& procs,
+				const string& label = "label") {
+		encoder.begin(key);
+		for (const auto& [name, value] : values) encoder.num(name, value);
+		if (not label.empty()) encoder.text("text/label", label);
+		for (const auto& p : procs) encoder.proc(p);
+		string out;
+		encoder.finish(out, 1000);
+		return out;
+	}
+
+	bool receive(Stream::Decoder& decoder, const string& frame) {
+		const auto list = frames(frame);
+		return CHECK(list.size() == 1) and decoder.apply(list[0].first, list[0].second);
+	}
+
+	const Stream::Decoder::Value* find(const Stream::Decoder& decoder, const string_view name) {
+		for (const auto& value : decoder.values) if (value.alive and value.name == name) return &value;
+		return nullptr;
+	}
+
+	size_t alive(const Stream::Decoder& decoder) {
+		size_t n = 0;
+		for (const auto& value : decoder.values) n += value.alive;
+		return n;
+	}
+
+	//* Decoded state holds exactly <values> and <procs>
+	bool same(const Stream::Decoder& decoder, const vector<pair<string, int64_t>>& values, const vector<Proc::proc_info>& procs) {
+		bool ok = CHECK(alive(decoder) == values.size() + 1);
+		for (const auto& [name, num] : values) {
+			const auto* value = find(decoder, name);
+			ok &= CHECK(value != nullptr and not value->text and value->num == num);
+		}
+		ok &= CHECK(decoder.procs.size() == procs.size());
+		for (const auto& p : procs) {
+			const auto found = decoder.procs.find(p.pid);
+			if (not CHECK(found != decoder.procs.end())) return false;
+			const auto& d = found->second;
+			ok &= CHECK(d.name == p.name and d.short_cmd == p.name and d.cmd == p.cmd and d.user == p.user);
+			ok &= CHECK(d.ppid == p.ppid and d.threads == p.threads and d.mem == p.mem and d.state == p.state and d.cpu_s == p.cpu_s);
+			ok &= CHECK(std::abs(d.cpu_p - p.cpu_p) < 0.051 and std::abs(d.cpu_c - p.cpu_c) < 0.01);
+		}
+		return ok;
+	}
+
+	void test_keyframe() {
+		Stream::Encoder encoder;
+		Stream::Decoder decoder;
+		const vector<pair<string, int64_t>> values = {{"cpu/pct/total", 42}, {"cpu/temp/0", -1}, {"mem/stat/used", 1ll << 40}};
+		const vector<Proc::proc_info> procs = {make_proc(4, "System", 1), make_proc(1000, "explorer.exe", 2), make_proc(1004, "btop4win.exe", 3)};
+
+		const string frame = encode(encoder, true, values, procs);
+		CHECK(frame[4] == Stream::type_key);
+		CHECK(receive(decoder, frame));
+		CHECK(same(decoder, values, procs));
+		CHECK(decoder.time == 1000);
+		const auto* label = find(decoder, "text/label");
+		CHECK(label != nullptr and label->text and label->str == "label");
+	}
+
+	void test_deltas() {
+		Stream::Encoder encoder;
+		Stream::Decoder decoder;
+		vector<pair<string, int64_t>> values = {{"cpu/pct/total", 42}, {"cpu/core/0", 10}, {"cpu/core/1", 20}};
+		vector<Proc::proc_info> procs = {make_proc(4, "System", 1), make_proc(1000, "explorer.exe", 2), make_proc(1004, "btop4win.exe", 3)};
+		const string key = encode(encoder, true, values, procs);
+		CHECK(receive(decoder, key));
+
+		//? Nothing changed, the delta only holds the time and empty lists
+		const string idle = encode(encoder, false, values, procs);
+		CHECK(idle[4] == Stream::type_delta);
+		CHECK(idle.size() < 16);
+		CHECK(receive(decoder, idle));
+		CHECK(same(decoder, values, procs));
+
+		//? Changed values and process fields, a new value and a spawned process
+		values[1].second = 99;
+		values.emplace_back("cpu/core/2", 5);
+		procs[1].mem *= 2;
+		procs[1].cpu_p = 12.3;
+		procs[2].state = 'S';
+		procs[2].threads = 9;
+		procs.push_back(make_proc(2000, "new.exe", 4));
+		const string changed = encode(encoder, false, values, procs);
+		CHECK(changed.size() < key.size());
+		CHECK(receive(decoder, changed));
+		CHECK(same(decoder, values, procs));
+
+		//? The lazy cpu value only sends changes above 1%
+		procs[0].cpu_c = 0.2501;
+		const string drift = encode(encoder, false, values, procs);
+		CHECK(drift.size() == idle.size());
+		CHECK(receive(decoder, drift));
+		procs[0].cpu_c = 0.5;
+		CHECK(receive(decoder, encode(encoder, false, values, procs)));
+		CHECK(same(decoder, values, procs));
+
+		//? A viewer joining at a later keyframe ends up with the same state as one that followed every delta
+		Stream::Decoder late;
+		const string rekey = encode(encoder, true, values, procs);
+		CHECK(receive(late, rekey));
+		CHECK(receive(decoder, rekey));
+		CHECK(same(late, values, procs));
+		CHECK(same(decoder, values, procs));
+	}
+
+	void test_removed() {
+		Stream::Encoder encoder;
+		Stream::Decoder decoder;
+		vector<pair<string, int64_t>> values = {{"disk/C:/used", 1}, {"disk/D:/used", 2}};
+		vector<Proc::proc_info> procs = {make_proc(100, "a.exe", 1), make_proc(200, "b.exe", 1), make_proc(300, "c.exe", 1)};
+		CHECK(receive(decoder, encode(encoder, true, values, procs)));
+
+		//? A disk removed and a process exited
+		values.pop_back();
+		procs.erase(procs.begin() + 1);
+		CHECK(receive(decoder, encode(encoder, false, values, procs)));
+		CHECK(same(decoder, values, procs));
+		CHECK(find(decoder, "disk/D:/used") == nullptr);
+		CHECK(not decoder.procs.contains(200));
+
+		//? A removed text field, and a field coming back gets a new definition
+		CHECK(receive(decoder, encode(encoder, false, values, procs, "")));
+		CHECK(find(decoder, "text/label") == nullptr);
+		values.emplace_back("disk/D:/used", 3);
+		CHECK(receive(decoder, encode(encoder, false, values, procs)));
+		CHECK(same(decoder, values, procs));
+	}
+
+	void test_pid_reuse() {
+		Stream::Encoder encoder;
+		Stream::Decoder decoder;
+		vector<Proc::proc_info> procs = {make_proc(500, "old.exe", 100)};
+		procs[0].ppid = 7;
+		CHECK(receive(decoder, encode(encoder, true, {}, procs)));
+
+		//? Same pid with another start time is a new process, even with every other value the same
+		procs[0] = make_proc(500, "new.exe", 200);
+		CHECK(receive(decoder, encode(encoder, false, {}, procs)));
+		CHECK(same(decoder, {}, procs));
+		CHECK(decoder.procs.at(500).ppid == 4);
+
+		//? Exited and reused within one update is only seen as a reuse
+		procs[0] = make_proc(500, "old.exe", 100);
+		CHECK(receive(decoder, encode(encoder, false, {}, procs)));
+		CHECK(same(decoder, {}, procs));
+	}
+
+	void test_malformed() {
+		Stream::Encoder encoder;
+		Stream::Decoder decoder;
+		const vector<pair<string, int64_t>> values = {{"cpu/pct/total", 42}, {"mem/stat/used", 1 << 30}};
+		vector<Proc::proc_info> procs = {make_proc(4, "System", 1), make_proc(1000, "explorer.exe", 2)};
+		const string key = encode(encoder, true, values, procs);
+		CHECK(receive(decoder, key));
+		procs[1].mem += 4096;
+		procs.push_back(make_proc(2000, "new.exe", 3));
+		const string delta = encode(encoder, false, {{"cpu/pct/total", 43}, {"mem/stat/used", 1 << 30}}, procs);
+
+		//? Every truncation of a frame is rejected
+		for (const string& frame : {key, delta}) {
+			const string_view payload = frames(frame).at(0).second;
+			size_t accepted = 0;
+			for (size_t len = 0; len < payload.size(); len++) {
+				Stream::Decoder copy = decoder;
+				accepted += copy.apply(frame[4], payload.substr(0, len));
+			}
+			CHECK(accepted == 0);
+		}
+		CHECK(frames(key.substr(0, key.size() - 1)).empty());
+
+		//? Trailing bytes
+		Stream::Decoder copy = decoder;
+		CHECK(not copy.apply(Stream::type_delta, string(frames(delta).at(0).second) + '\0'));
+
+		//? Handcrafted payloads: time, definitions, values, removed fields, spawned, changed, exited
+		const auto payload = [](const vector<uint64_t>& vars, const string& tail = "") {
+			string out;
+			for (const auto v : vars) Stream::put_var(out, v);
+			return out + tail;
+		};
+		const auto rejects = [&](const string& bad) {
+			Stream::Decoder d = decoder;
+			return not d.apply(Stream::type_delta, bad);
+		};
+		CHECK(not rejects(payload({1, 0, 0, 0, 0, 0, 0})));
+		CHECK(rejects(payload({1, 0, 1, 77, 0})));	//? value for an undefined id
+		CHECK(rejects(payload({1, 1, 5, 2, 1}, "x") + payload({0, 0, 0, 0, 0})));	//? unknown field kind
+		CHECK(rejects(payload({1, 1, Stream::max_fields, 0, 1}, "x") + payload({0, 0, 0, 0, 0})));	//? id out of range
+		CHECK(rejects(payload({1, 0, 0, 0, 0, 0, 1'000'000'000})));	//? count larger than the payload
+		CHECK(rejects(payload({1}) + string(10, '\xff')));	//? varint longer than 64 bits
+		CHECK(rejects(payload({1, 0, 0, 0, 0, 0, 1})));	//? missing exited pid
+
+		//? Changes for a pid not in the table are skipped, the rest of the frame still applies
+		Stream::Decoder d = decoder;
+		CHECK(d.apply(Stream::type_delta, payload({1, 0, 0, 0, 0, 1, 999, Stream::bit_mem, 5, 1, 4})));
+		CHECK(not d.procs.contains(999) and not d.procs.contains(4) and d.procs.size() == 1);
+
+		//? Unknown frame types are ignored
+		d = decoder;
+		CHECK(d.apply('X', "garbage"));
+		CHECK(d.procs.size() == decoder.procs.size() and d.values.size() == decoder.values.size());
+	}
+
+	//* Frames from an encoder sent over a 127.0.0.1 connection arrive and apply the same as in memory
+	void test_loopback() {
+		if (not CHECK(Loopback::startup())) return;
+		int port = 0;
+		const SOCKET listener = Loopback::listen_any(port);
+		if (not CHECK(listener != INVALID_SOCKET)) return;
+
+		constexpr size_t ticks = 50;
+		vector<pair<string, int64_t>> values;
+		vector<Proc::proc_info> procs;
+		const auto step = [&](const size_t tick) {
+			values = {{"cpu/pct/total", (int64_t)(tick % 100)}, {"net/eth0/download/speed", (int64_t)(tick * 1000)}};
+			procs.clear();
+			for (size_t pid = 4; pid < 2000; pid += 4) {
+				if ((pid + tick) % 97 == 0) continue;
+				auto p = make_proc(pid, "proc" + std::to_string(pid) + ".exe", pid + (pid % 13 == 0 ? tick : 0));
+				p.mem += (pid % 5 == 0 ? tick * 4096 : 0);
+				p.cpu_p = (double)((pid + tick) % 50) / 10;
+				procs.push_back(p);
+			}
+		};
+
+		std::thread agent([&] {
+			const SOCKET sock = accept(listener, nullptr, nullptr);
+			if (sock == INVALID_SOCKET) return;
+			Stream::Encoder encoder;
+			string frame;
+			for (size_t tick = 0; tick < ticks; tick++) {
+				step(tick);
+				frame = encode(encoder, tick % 20 == 0, values, procs);
+				if (not Loopback::send_all(sock, frame.data(), frame.size())) break;
+			}
+			closesocket(sock);
+		});
+
+		const SOCKET sock = Loopback::connect_to(port);
+		Stream::Decoder decoder;
+		size_t received = 0;
+		if (CHECK(sock != INVALID_SOCKET)) {
+			char head[Stream::head_size];
+			string payload;
+			while (Loopback::recv_all(sock, head, sizeof(head))) {
+				payload.resize(Stream::payload_size(head));
+				if (not CHECK(Loopback::recv_all(sock, payload.data(), payload.size()))) break;
+				if (not CHECK(decoder.apply(head[4], payload))) break;
+				received++;
+			}
+			closesocket(sock);
+		}
+		agent.join();
+		closesocket(listener);
+
+		CHECK(received == ticks);
+		CHECK(same(decoder, values, procs));
+	}
+}
+
+int main() {
+	test_keyframe();
+	test_deltas();
+	test_removed();
+	test_pid_reuse();
+	test_malformed();
+	test_loopback();
+	return Testing::result("remote_test");
+}
@@ -0,0 +1,56 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <sstream>
+
+//* Minimal checks for the portable modules built by tests/CMakeLists.txt, failed checks are printed and counted
+namespace Testing {
+	inline int failures = 0;
+
+	inline bool check(const bool ok, const char* expr, const char* file, const int line) {
+		if (not ok) {
+			failures++;
+			std::printf("FAILED %s:%d: %s\n", file, line, expr);
+		}
+		return ok;
+	}
+
+	//* Returns the content of <name> in the fixture directory, empty if missing
+	inline std::string fixture(const std::string& name) {
+		std::ifstream file(std::string(FIXTURE_DIR) + '/' + name, std::ios::binary);
+		if (not check(file.good(), name.c_str(), __FILE__, __LINE__)) return "";
+		std::stringstream ss;
+		ss << file.rdbuf();
+		return ss.str();
+	}
+
+	//* Print the result and return the process exit code
+	inline int result(const char* name) {
+		if (failures == 0) std::printf("%s: all checks passed\n", name);
+		else std::printf("%s: %d checks failed\n", name, failures);
+		return (failures == 0 ? 0 : 1);
+	}
+}
+
+#define CHECK(expr) Testing::check((expr), #expr, __FILE__, __LINE__)
@@ -0,0 +1,157 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <tuple>
+
+#include <btop_wmi.hpp>
+
+#include "testing.hpp"
+#include "wmi_fake.hpp"
+
+using std::string, std::wstring, std::to_wstring, std::vector;
+
+namespace {
+	namespace col {
+		enum { ProcessId, ParentProcessId, Name, CommandLine, ExecutablePath, CreationDate, KernelModeTime, UserModeTime, PrivatePageCount, ReadTransferCount, WriteTransferCount };
+	}
+
+	//? Row shaped like a browser process, values in the order of Fake::processes()
+	vector<wstring> proc_row(const size_t pid, const size_t tick) {
+		const wstring dir = L"C:\\Program Files\\Vendor\\Application " + to_wstring(pid);
+		return {to_wstring(pid), to_wstring(pid / 7 + 4), L"process_" + to_wstring(pid) + L".exe",
+			L"\"" + dir + L"\\process.exe\" --type=renderer --field-trial-handle=1234,i,56789 /prefetch:1",
+			dir + L"\\process.exe", L"20261019093000.123456+120",
+			to_wstring(pid * 1000 + tick * (pid % 3)), to_wstring(pid * 2000 + tick * (pid % 5)), to_wstring(1 << 20 | pid),
+			to_wstring(tick * pid), to_wstring(tick * 3)};
+	}
+
+	//* Update done by Proc::WMICollect() before the Wmi module: copies the whole map, keeps every string as a
+	//* _bstr_t (a reference counted wide string here) and searches requests and found pids linearly
+	namespace Previous {
+		using bstr = std::shared_ptr<wstring>;
+		struct Entry {
+			uint32_t ParentProcessId = 0;
+			bstr Name, CommandLine, ExecutablePath, KernelModeTime, UserModeTime, CreationDate;
+			bstr PrivateMemory, ReadTransferCount, WriteTransferCount;
+		};
+		using Map = robin_hood::unordered_flat_map<size_t, Entry>;
+
+		bool contains(const vector<size_t>& list, const size_t value) {
+			return std::ranges::find(list, value) != list.end();
+		}
+
+		Map update(const vector<vector<wstring>>& rows, const Map& previous, const vector<size_t>& requests) {
+			Map list = previous;
+			vector<size_t> found;
+			for (const auto& row : rows) {
+				const size_t pid = Wmi::to_uint(row[col::ProcessId]);
+				found.push_back(pid);
+				if (pid == 0 or (not requests.empty() and not contains(requests, pid))) continue;
+				const bool new_entry = not list.contains(pid);
+				auto& entry = list[pid];
+				entry.ReadTransferCount = std::make_shared<wstring>(row[col::ReadTransferCount]);
+				entry.WriteTransferCount = std::make_shared<wstring>(row[col::WriteTransferCount]);
+				entry.PrivateMemory = std::make_shared<wstring>(row[col::PrivatePageCount]);
+				entry.KernelModeTime = std::make_shared<wstring>(row[col::KernelModeTime]);
+				entry.UserModeTime = std::make_shared<wstring>(row[col::UserModeTime]);
+				if (new_entry) {
+					entry.ParentProcessId = (uint32_t)Wmi::to_uint(row[col::ParentProcessId]);
+					entry.Name = std::make_shared<wstring>(row[col::Name]);
+					entry.CommandLine = std::make_shared<wstring>(row[col::CommandLine]);
+					entry.ExecutablePath = std::make_shared<wstring>(row[col::ExecutablePath]);
+					entry.CreationDate = std::make_shared<wstring>(row[col::CreationDate]);
+				}
+			}
+			for (auto it = list.begin(); it != list.end();) {
+				if (not contains(found, it->first)) it = list.erase(it);
+				else ++it;
+			}
+			return list;
+		}
+	}
+
+	double millis(const auto start, const auto end) {
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+}
+
+//* Time per update of a 10k row Win32_Process result with the previous implementation and Wmi::update_procs().
+//* Usage: wmi_bench [passes]
+int main(int argc, char** argv) {
+	const int passes = (argc > 1 ? std::max(1, std::atoi(argv[1])) : 10);
+	constexpr size_t rows = 10'000;
+
+	Fake::Enumerator base;
+	auto& base_table = base.tables["Win32_Process"] = Fake::processes();
+	for (size_t i = 1; i <= rows; i++) base_table.rows.push_back(proc_row(i * 4, 0));
+
+	for (const auto& [label, requested, churn] : {
+			std::tuple{"all pids requested, no churn", rows, size_t{0}},
+			std::tuple{"all pids requested, 1% churn", rows, size_t{100}},
+			std::tuple{"500 pids requested, 1% churn", size_t{500}, size_t{100}},
+			std::tuple{"no requests (refresh all)", size_t{0}, size_t{0}}}) {
+		Fake::Enumerator wmi = base;
+		auto& table = wmi.tables.at("Win32_Process");
+		auto current = Wmi::update_procs(wmi, {}, {});
+		auto previous = Previous::update(table.rows, {}, {});
+		double t_previous = 0, t_current = 0;
+		size_t next_pid = rows * 4 + 4;
+
+		for (int tick = 1; tick <= passes; tick++) {
+			for (size_t c = 0; c < churn; c++) table.rows.erase(table.rows.begin() + (c * 97) % table.rows.size());
+			for (size_t c = 0; c < churn; c++) table.rows.push_back(proc_row(next_pid += 4, tick));
+			for (auto& row : table.rows) {
+				const size_t pid = Wmi::to_uint(row[col::ProcessId]);
+				row[col::KernelModeTime] = to_wstring(pid * 1000 + tick * (pid % 3));
+			}
+
+			//? The runner adds requests once per process shown, duplicates included
+			vector<size_t> request_list;
+			unordered_flat_set<size_t> request_set;
+			for (size_t i = 0; i < requested; i++) {
+				const size_t pid = Wmi::to_uint(table.rows[(i * 13) % table.rows.size()][col::ProcessId]);
+				request_list.push_back(pid);
+				request_list.push_back(pid);
+				request_set.insert(pid);
+			}
+
+			const auto t0 = std::chrono::steady_clock::now();
+			previous = Previous::update(table.rows, previous, request_list);
+			const auto t1 = std::chrono::steady_clock::now();
+			auto next = Wmi::update_procs(wmi, current, request_set);
+			const auto t2 = std::chrono::steady_clock::now();
+			t_previous += millis(t0, t1);
+			t_current += millis(t1, t2);
+
+			CHECK(next.size() == previous.size());
+			for (const auto& [pid, entry] : previous) {
+				if (not CHECK(next.contains(pid) and next.at(pid).KernelModeTime == Wmi::to_uint(*entry.KernelModeTime))) break;
+			}
+			current = std::move(next);
+		}
+		std::printf("%-30s previous %8.2f ms  update_procs %6.2f ms per pass (%zu entries)\n",
+			label, t_previous / passes, t_current / passes, current.size());
+	}
+	return Testing::result("wmi_bench");
+}
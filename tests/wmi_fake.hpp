@@ -0,0 +1,93 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+#include <btop_wmi.hpp>
+
+//* In-memory stand-in for WMI, so the snapshot diffing in btop_wmi.cpp can be tested and timed without COM.
+//* Tables hold every value as a string like WMI returns CIM uint64 values, booleans are stored as "0" or "1"
+namespace Fake {
+	using std::string, std::wstring, std::wstring_view, std::vector;
+
+	struct Table {
+		vector<string> columns;
+		vector<vector<wstring>> rows;
+
+		//* Index of <column>, throws std::out_of_range if the table doesn't have it
+		size_t index(const string& column) const {
+			const auto it = std::ranges::find(columns, column);
+			if (it == columns.end()) throw std::out_of_range("no column " + column);
+			return it - columns.begin();
+		}
+
+		//* Append a row with all values empty and return it
+		vector<wstring>& add() {
+			return rows.emplace_back(columns.size());
+		}
+
+		//* Value of <column> in <row>
+		wstring& at(const size_t row, const string& column) {
+			return rows.at(row).at(index(column));
+		}
+	};
+
+	//* Columns of a table row in the order of a query
+	class Row : public Wmi::Row {
+		const vector<wstring>& values;
+		const vector<size_t>& order;
+	public:
+		Row(const vector<wstring>& values, const vector<size_t>& order) : values(values), order(order) {}
+		wstring_view str(const size_t column) const override { return values.at(order.at(column)); }
+		uint64_t num(const size_t column) const override { return Wmi::to_uint(str(column)); }
+	};
+
+	class Enumerator : public Wmi::Enumerator {
+	public:
+		//? WMI class name -> table
+		robin_hood::unordered_node_map<string, Table> tables;
+		size_t queries = 0;
+		bool fail = false;
+
+		void query(const Wmi::Query& query, const std::function<void(const Wmi::Row&)>& row_callback) override {
+			queries++;
+			if (fail) throw std::runtime_error("query failed");
+			const auto& table = tables.at(query.from);
+			vector<size_t> order;
+			for (const auto& column : query.columns) order.push_back(table.index(column));
+			for (const auto& values : table.rows) row_callback(Row(values, order));
+		}
+	};
+
+	//* Empty Win32_Process table with the columns read by Wmi::update_procs()
+	inline Table processes() {
+		return {{"ProcessId", "ParentProcessId", "Name", "CommandLine", "ExecutablePath", "CreationDate",
+			"KernelModeTime", "UserModeTime", "PrivatePageCount", "ReadTransferCount", "WriteTransferCount"}, {}};
+	}
+
+	//* Empty Win32_Service table with the columns read by Wmi::update_services()
+	inline Table services() {
+		return {{"Name", "ProcessId", "AcceptPause", "AcceptStop", "StartMode", "StartName", "State", "Caption", "Description", "ServiceType"}, {}};
+	}
+}
@@ -0,0 +1,161 @@
+/* Copyright 2021 Aristocratos (jakob@qvantnet.com)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+	   http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+indent = tab
+tab-size = 4
+*/
+
+
+#include <string>
+
+#include <btop_wmi.hpp>
+
+#include "testing.hpp"
+#include "wmi_fake.hpp"
+
+using std::string, std::wstring, std::to_wstring;
+
+namespace {
+	void add_proc(Fake::Table& table, const size_t pid, const wstring& name, const uint64_t kernel) {
+		auto& row = table.add();
+		row[table.index("ProcessId")] = to_wstring(pid);
+		row[table.index("ParentProcessId")] = L"4";
+		row[table.index("Name")] = name;
+		row[table.index("CommandLine")] = L"\"C:\\Program Files\\" + name + L"\" --flag";
+		row[table.index("KernelModeTime")] = to_wstring(kernel);
+		row[table.index("PrivatePageCount")] = L"18446744073709551615";
+	}
+
+	void add_svc(Fake::Table& table, const wstring& name, const wstring& state, const wstring& caption) {
+		auto& row = table.add();
+		row[table.index("Name")] = name;
+		row[table.index("ProcessId")] = L"100";
+		row[table.index("AcceptPause")] = L"0";
+		row[table.index("AcceptStop")] = L"1";
+		row[table.index("StartMode")] = L"Auto";
+		row[table.index("StartName")] = L"LocalSystem";
+		row[table.index("State")] = state;
+		row[table.index("Caption")] = caption;
+	}
+
+	void test_to_utf8() {
+		using Wmi::to_utf8;
+		CHECK(to_utf8(L"plain ascii") == "plain ascii");
+		CHECK(to_utf8(L"Grüße") == "Gr\xC3\xBC\xC3\x9F" "e");
+		CHECK(to_utf8(L"\u20AC") == "\xE2\x82\xAC");
+
+		//? Built from UTF-16 code units so the surrogates are the same where wchar_t is 32 bits
+		const wstring pair = {wchar_t(0xD83D), wchar_t(0xDE00)};
+		CHECK(to_utf8(pair) == "\xF0\x9F\x98\x80");
+		CHECK(to_utf8(L"a" + pair + L"b") == "a\xF0\x9F\x98\x80" "b");
+
+		//? Unpaired surrogates are replaced with U+FFFD, the next unit is kept
+		CHECK(to_utf8(wstring{wchar_t(0xD83D)}) == "\xEF\xBF\xBD");
+		CHECK(to_utf8(wstring{wchar_t(0xD83D), L'x'}) == "\xEF\xBF\xBDx");
+		CHECK(to_utf8(wstring{wchar_t(0xDE00), wchar_t(0xD83D)}) == "\xEF\xBF\xBD\xEF\xBF\xBD");
+
+		string out = "kept ";
+		to_utf8(L"appended", out);
+		CHECK(out == "kept appended");
+
+		CHECK(Wmi::to_uint(L"18446744073709551615") == 18446744073709551615ull);
+		CHECK(Wmi::to_uint(L"123abc") == 123);
+		CHECK(Wmi::to_uint(L"") == 0);
+	}
+
+	void test_update_procs() {
+		Fake::Enumerator wmi;
+		auto& table = wmi.tables["Win32_Process"] = Fake::processes();
+		add_proc(table, 0, L"System Idle Process", 1);
+		add_proc(table, 8, L"first.exe", 10);
+		add_proc(table, 12, L"sécond.exe", 20);
+		add_proc(table, 16, L"third.exe", 30);
+
+		const unordered_flat_set<size_t> all;
+		const auto first = Wmi::update_procs(wmi, {}, all);
+		CHECK(first.size() == 3 and not first.contains(0));
+		CHECK(first.at(12).info->Name == "s\xC3\xA9" "cond.exe");
+		CHECK(first.at(8).info->CommandLine == "\"C:\\Program Files\\first.exe\" --flag");
+		CHECK(first.at(8).info->ParentProcessId == 4);
+		CHECK(first.at(8).KernelModeTime == 10);
+		CHECK(first.at(8).PrivateMemory == 18446744073709551615ull);
+
+		//? Pid 8 exits, pid 20 starts and values of the others change
+		table.rows.erase(table.rows.begin() + 1);
+		add_proc(table, 20, L"added.exe", 40);
+		for (size_t i = 0; i < table.rows.size(); i++) table.at(i, "KernelModeTime") += L"0";
+		const auto second = Wmi::update_procs(wmi, first, all);
+		CHECK(second.size() == 3);
+		CHECK(not second.contains(8));
+		CHECK(second.contains(20) and second.at(20).info->Name == "added.exe");
+		CHECK(second.at(16).KernelModeTime == 300);
+		CHECK(second.at(16).info == first.at(16).info);
+
+		//? Only requested pids are refreshed, others keep their values and requested pids not in the result are skipped
+		for (size_t i = 0; i < table.rows.size(); i++) table.at(i, "KernelModeTime") += L"0";
+		const unordered_flat_set<size_t> requests = {16, 99};
+		const auto third = Wmi::update_procs(wmi, second, requests);
+		CHECK(third.size() == 3 and not third.contains(99));
+		CHECK(third.at(16).KernelModeTime == 3000);
+		CHECK(third.at(12).KernelModeTime == 200);
+		CHECK(third.at(20).KernelModeTime == 400);
+
+		//? A pid that is new but not requested is skipped until refreshed, exited pids are dropped in both modes
+		add_proc(table, 24, L"late.exe", 1);
+		table.rows.erase(table.rows.begin() + 2);
+		const auto fourth = Wmi::update_procs(wmi, third, requests);
+		CHECK(not fourth.contains(24));
+		CHECK(not fourth.contains(16));
+		CHECK(fourth.size() == 2);
+
+		wmi.fail = true;
+		bool thrown = false;
+		try { Wmi::update_procs(wmi, fourth, all); }
+		catch (const std::runtime_error&) { thrown = true; }
+		CHECK(thrown);
+	}
+
+	void test_update_services() {
+		Fake::Enumerator wmi;
+		auto& table = wmi.tables["Win32_Service"] = Fake::services();
+		const wstring smiley = {wchar_t(0xD83D), wchar_t(0xDE00)};
+		add_svc(table, L"alpha", L"Running", L"Dienst für Grüße " + smiley);
+		add_svc(table, L"beta", L"Stopped", L"Beta");
+		add_svc(table, L"", L"Running", L"Unnamed");
+
+		const auto first = Wmi::update_services(wmi, {});
+		CHECK(first.size() == 2 and not first.contains(""));
+		CHECK(first.at("alpha").info->Caption == "Dienst f\xC3\xBCr Gr\xC3\xBC\xC3\x9F" "e \xF0\x9F\x98\x80");
+		CHECK(first.at("alpha").ProcessID == 100);
+		CHECK(first.at("alpha").AcceptStop and not first.at("alpha").AcceptPause);
+		CHECK(first.at("alpha").Owner == "LocalSystem" and first.at("alpha").State == "Running");
+
+		//? Changed values are updated, static info is shared and removed services are dropped
+		table.at(0, "State") = L"Stopped";
+		table.at(0, "StartName") = L"NT AUTHORITY\\Lokaler Dienst ü";
+		table.rows.erase(table.rows.begin() + 1);
+		const auto second = Wmi::update_services(wmi, first);
+		CHECK(second.size() == 1 and not second.contains("beta"));
+		CHECK(second.at("alpha").State == "Stopped");
+		CHECK(second.at("alpha").Owner == "NT AUTHORITY\\Lokaler Dienst \xC3\xBC");
+		CHECK(second.at("alpha").info == first.at("alpha").info);
+	}
+}
+
+int main() {
+	test_to_utf8();
+	test_update_procs();
+	test_update_services();
+	return Testing::result("wmi_test");
+}